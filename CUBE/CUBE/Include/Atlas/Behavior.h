@@ -4,6 +4,7 @@
 #include "ChunkSystems\BlockTypes.h"
 #include "Atlas\GameObject.h"
 #include "ChunkSystems\ChunkManager.h"
+#include "ChunkSystems\VoxelCursor.h"
 
 namespace Atlas
 {
@@ -34,7 +35,8 @@ namespace Atlas
 		//virtual void OnCollisionExit(){};
 		
 		/**
-		* Sets a block type within the world at a specific world position.
+		* Sets a block type within the world at a specific world position. Far chunks that only
+		* keep their cells refuse the block, and OnEditRejected listeners are called.
 		*/
 		void SetBlock(const Vector3i& Position, const FBlockTypes::BlockID ID);
 
@@ -44,10 +46,24 @@ namespace Atlas
 		FBlockTypes::BlockID GetBlock(const Vector3i& Position);
 
 		/**
-		* Destroys a block at a specific position within the world.
+		* Destroys a block at a specific position within the world. Far chunks that only keep
+		* their cells refuse the edit, and OnEditRejected listeners are called.
 		*/
 		void DestroyBlock(const Vector3i& Position);
 
+		/**
+		* Applies a batch of block writes to the world. Prefer this over single block
+		* functions when changing many blocks at once. Far chunks that only keep their cells
+		* aren't written, and OnEditRejected listeners are called for each of them.
+		*/
+		void ApplyEdit(const FBlockEdit& Edit);
+
+		/**
+		* Creates a cursor for reading blocks near a world position. Cursors should
+		* not be kept across frames.
+		*/
+		FVoxelCursor GetVoxelCursor(const Vector3i& Position) const;
+
 		template <typename T, void(T::*Function)(Vector3i, FBlockTypes::BlockID)>
 		/**
 		* Adds a function to call when a block is set within the world. A single instance
@@ -76,6 +92,35 @@ namespace Atlas
 		*/
 		void RemoveOnBlockDestroyListener(T* Instance);
 
+		template <typename T, void(T::*Function)(const std::vector<FBlockChange>&)>
+		/**
+		* Adds a function to call with every block changed by an edit. A single instance
+		* should not have more that one listener for a single event. Remember to
+		* remove this listener before the object is destroyed.
+		*/
+		void AddOnBlocksChangedListener(T* Instance);
+
+		template <typename T>
+		/**
+		* Removes the listener from the OnBlocksChanged event.
+		*/
+		void RemoveOnBlocksChangedListener(T* Instance);
+
+		template <typename T, void(T::*Function)(Vector3i)>
+		/**
+		* Adds a function to call with the chunk space position of a chunk that refused an edit.
+		* Chunks past the distance of level of detail 2 only keep their cells, so their blocks
+		* can't be edited until they are nearer. A single instance should not have more that one
+		* listener for a single event. Remember to remove this listener before the object is destroyed.
+		*/
+		void AddOnEditRejectedListener(T* Instance);
+
+		template <typename T>
+		/**
+		* Removes the listener from the OnEditRejected event.
+		*/
+		void RemoveOnEditRejectedListener(T* Instance);
+
 		/**
 		* Loads a world.
 		* @param WorldName - The name of the world directory.
@@ -129,6 +174,16 @@ namespace Atlas
 		mChunkManager->DestroyBlock(Position);
 	}
 
+	inline void FBehavior::ApplyEdit(const FBlockEdit& Edit)
+	{
+		mChunkManager->ApplyEdit(Edit);
+	}
+
+	inline FVoxelCursor FBehavior::GetVoxelCursor(const Vector3i& Position) const
+	{
+		return FVoxelCursor{ *mChunkManager, Position };
+	}
+
 	template <typename T, void(T::*Function)(Vector3i, FBlockTypes::BlockID)>
 	inline void FBehavior::AddOnBlockSetListener(T* Instance)
 	{
@@ -154,6 +209,30 @@ namespace Atlas
 		mChunkManager->mOnBlockDestroy.RemoveListener(Instance);
 	}
 
+	template <typename T, void(T::*Function)(const std::vector<FBlockChange>&)>
+	inline void FBehavior::AddOnBlocksChangedListener(T* Instance)
+	{
+		mChunkManager->mOnBlocksChanged.AddListener<T, Function>(Instance);
+	}
+
+	template <typename T>
+	inline void FBehavior::RemoveOnBlocksChangedListener(T* Instance)
+	{
+		mChunkManager->mOnBlocksChanged.RemoveListener(Instance);
+	}
+
+	template <typename T, void(T::*Function)(Vector3i)>
+	inline void FBehavior::AddOnEditRejectedListener(T* Instance)
+	{
+		mChunkManager->mOnEditRejected.AddListener<T, Function>(Instance);
+	}
+
+	template <typename T>
+	inline void FBehavior::RemoveOnEditRejectedListener(T* Instance)
+	{
+		mChunkManager->mOnEditRejected.RemoveListener(Instance);
+	}
+
 	inline void FBehavior::LoadWorld(const wchar_t* WorldName)
 	{
 		mChunkManager->LoadWorld(WorldName);
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "BlockTypes.h"
+#include "Math\Vector3.h"
+
+/**
+* A block in the world that was changed by an edit.
+*/
+struct FBlockChange
+{
+	Vector3i             Position; // World position of the block
+	FBlockTypes::BlockID OldID;
+	FBlockTypes::BlockID NewID;
+};
+
+/**
+* A batch of block writes that is applied to the world at once with
+* FChunkManager::ApplyEdit(). Writes are described as shapes or lists of voxels
+* and are applied in the order they were added, so later writes win where they overlap.
+* \n
+* Applying an edit visits each touched chunk once, writes the blocks of every operation
+* overlapping it while holding the chunk's block lock, and queues a single rebuild for it.
+* Edits can be reused by clearing them.
+*/
+class FBlockEdit
+{
+public:
+	enum class EShape : uint8_t
+	{
+		Box,
+		Sphere,
+		Cylinder,
+		Voxels
+	};
+
+	/**
+	* A single block write.
+	*/
+	struct FVoxel
+	{
+		Vector3i             Position;
+		FBlockTypes::BlockID ID;
+	};
+
+	/**
+	* A shape of blocks set to a single ID, or a range of voxels.
+	*/
+	struct FOperation
+	{
+		EShape               Shape;
+		FBlockTypes::BlockID ID;
+		Vector3i             Min;           // Inclusive bounds of the operation in world space
+		Vector3i             Max;
+		Vector3i             Center;        // Center of spheres and cylinders
+		int32_t              RadiusSquared;
+		uint32_t             FirstVoxel;    // Range of voxels in the edit for voxel operations
+		uint32_t             VoxelCount;
+
+		/**
+		* Finds the blocks of a shape on a row along z. Only valid for shape operations.
+		* @param X - World x position of the row.
+		* @param Y - World y position of the row.
+		* @param ZMinOut - First z position in the shape.
+		* @param ZMaxOut - Last z position in the shape.
+		* @return False if the row doesn't pass through the shape.
+		*/
+		bool RowSpan(const int32_t X, const int32_t Y, int32_t& ZMinOut, int32_t& ZMaxOut) const;
+	};
+
+public:
+	/**
+	* Constructs an empty edit.
+	*/
+	FBlockEdit();
+
+	/**
+	* Sets every block within a box.
+	* @param Min - The smallest corner of the box.
+	* @param Max - The largest corner of the box. Blocks at Max are included.
+	*/
+	void SetBox(const Vector3i& Min, const Vector3i& Max, const FBlockTypes::BlockID ID);
+
+	/**
+	* Sets every block within a distance of a center block.
+	*/
+	void SetSphere(const Vector3i& Center, const uint32_t Radius, const FBlockTypes::BlockID ID);
+
+	/**
+	* Sets every block within a vertical cylinder.
+	* @param BaseCenter - The block at the center of the bottom of the cylinder.
+	* @param Radius - Distance of the cylinder wall from the center.
+	* @param Height - Number of blocks the cylinder extends upward from the base.
+	*/
+	void SetCylinder(const Vector3i& BaseCenter, const uint32_t Radius, const uint32_t Height, const FBlockTypes::BlockID ID);
+
+	/**
+	* Sets a single block.
+	*/
+	void SetBlock(const Vector3i& Position, const FBlockTypes::BlockID ID);
+
+	/**
+	* Sets a list of blocks, such as a pasted structure.
+	*/
+	void SetBlocks(const FVoxel* Voxels, const uint32_t Count);
+
+	/**
+	* Removes all operations from the edit.
+	*/
+	void Clear();
+
+	/**
+	* Checks if the edit holds any operations.
+	*/
+	bool IsEmpty() const { return mOperations.empty(); }
+
+	/**
+	* Gets the operations in the order they were added.
+	*/
+	const std::vector<FOperation>& GetOperations() const { return mOperations; }
+
+	/**
+	* Gets the voxels of all voxel operations.
+	*/
+	const std::vector<FVoxel>& GetVoxels() const { return mVoxels; }
+
+private:
+	/**
+	* Adds a shape operation.
+	*/
+	void AddShape(const EShape Shape, const Vector3i& Min, const Vector3i& Max, const Vector3i& Center, const int32_t Radius, const FBlockTypes::BlockID ID);
+
+private:
+	std::vector<FOperation> mOperations;
+	std::vector<FVoxel>     mVoxels;
+};
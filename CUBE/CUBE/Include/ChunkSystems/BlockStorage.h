@@ -0,0 +1,225 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include "Memory\ConcurrentPoolAllocator.h"
+#include "Block.h"
+#include "BlockTypes.h"
+#include "ChunkGeometry.h"
+
+/**
+* Palette compressed block storage for a single chunk. Each distinct block
+* ID in the chunk is given an entry in a small palette and every voxel stores
+* a bit-packed index into that palette. Indices are 1, 2, 4 or 8 bits wide
+* depending on how many distinct block types the chunk holds. Once the palette
+* would need as many bits as a raw block ID, the storage switches to direct mode
+* and stores block IDs without a palette.
+* \n
+* Packed index data is split into fixed size pages taken from a shared page pool, so
+* a chunk only holds as many pages as its current index width requires. Storages where
+* every block has the same ID are kept in a uniform state that holds no pages at all.
+*/
+class FBlockStorage
+{
+public:
+	// Number of blocks held by each storage
+	static const uint32_t BLOCK_COUNT = FChunkGeometry::BLOCKS_PER_CHUNK;
+
+	// Number of bits in a raw block ID
+	static const uint32_t BITS_PER_ID = sizeof(FBlockTypes::BlockID) * 8;
+
+	// Max number of entries in the palette before direct mode is used
+	static const uint32_t MAX_PALETTE_SIZE = 1 << (BITS_PER_ID / 2);
+
+	// Size of each page of packed index data. Each page holds one bit per block.
+	static const uint32_t PAGE_SIZE = BLOCK_COUNT / 8;
+	static const uint32_t WORDS_PER_PAGE = PAGE_SIZE / sizeof(uint32_t);
+	static const uint32_t MAX_PAGES = BLOCK_COUNT * BITS_PER_ID / 8 / PAGE_SIZE;
+	static_assert(MAX_PAGES <= 32, "Heap pages are tracked in a 32 bit mask.");
+
+	// Palette entry counts must be able to hold every block in the storage
+	typedef std::conditional<(BLOCK_COUNT > 0xFFFF), uint32_t, uint16_t>::type PaletteCount;
+
+	// Page pool shared by all storages and threads. Reserves space for an average of
+	// 4 bits per block, and pages are only committed as they are used.
+	static const uint32_t PAGE_POOL_SIZE = 30000 * 4;
+	static FConcurrentPoolAllocator<PAGE_SIZE, PAGE_POOL_SIZE> PageAllocator;
+
+public:
+	/**
+	* Constructs a uniform storage of air.
+	*/
+	FBlockStorage();
+
+	FBlockStorage(const FBlockStorage& Other) = delete;
+	FBlockStorage& operator=(const FBlockStorage& Other) = delete;
+
+	/**
+	* Frees all pages back to the page pool.
+	*/
+	~FBlockStorage();
+
+	/**
+	* Retrieves the block ID at a block index.
+	*/
+	FBlockTypes::BlockID Get(const uint32_t Index) const;
+
+	/**
+	* Sets the block ID at a block index. The index width is increased
+	* if the palette can't hold the new block ID. Pages are only allocated for
+	* uniform storages once a differing block ID is set.
+	* @return The block ID that was previously at the index.
+	*/
+	FBlockTypes::BlockID Set(const uint32_t Index, const FBlockTypes::BlockID ID);
+
+	/**
+	* Replaces the contents of this storage with a flat array of block IDs. The
+	* smallest index width that can hold every distinct block ID is chosen. Arrays
+	* of a single block ID are stored in the uniform state.
+	* @param Blocks - BLOCK_COUNT block IDs in block index order.
+	*/
+	void Pack(const FBlockTypes::BlockID* Blocks);
+
+	/**
+	* Expands the contents of this storage into a flat array of block IDs.
+	* @param BlocksOut - Memory for BLOCK_COUNT block IDs.
+	*/
+	void Unpack(FBlockTypes::BlockID* BlocksOut) const;
+
+	/**
+	* Frees all pages and returns the storage to the uniform state of air.
+	*/
+	void Clear();
+
+	/**
+	* Frees all pages and sets every block to a single block ID.
+	*/
+	void SetUniform(const FBlockTypes::BlockID ID);
+
+	/**
+	* Checks if every block in the storage has the same ID. Uniform storages
+	* hold no pages.
+	*/
+	bool IsUniform() const { return mBitsPerBlock == 0; }
+
+	/**
+	* Gets the block ID of a uniform storage.
+	*/
+	FBlockTypes::BlockID GetUniformID() const { return mUniformID; }
+
+	/**
+	* Gets the current number of bits used for each block.
+	*/
+	uint32_t GetBitsPerBlock() const { return mBitsPerBlock; }
+
+	/**
+	* Gets the number of entries in the palette. Returns 0 in direct mode.
+	*/
+	uint32_t GetPaletteSize() const { return mPaletteSize; }
+
+	/**
+	* Gets the number of bytes of page memory held by this storage.
+	*/
+	uint32_t GetMemoryUsage() const { return PageCount(mBitsPerBlock) * PAGE_SIZE; }
+
+	/**
+	* Gets the number of pages allocated from all storages.
+	*/
+	static uint32_t GetPagesInUse();
+
+	/**
+	* Returns pages cached by the calling thread to the page pool. Should be
+	* called by threads that use storages before they exit.
+	*/
+	static void FlushThreadCache();
+
+private:
+	/**
+	* Gets the number of pages needed at an index width.
+	*/
+	static uint32_t PageCount(const uint32_t BitsPerBlock);
+
+	/**
+	* Checks if block IDs are stored without a palette.
+	*/
+	bool IsDirect() const { return mBitsPerBlock == BITS_PER_ID; }
+
+	/**
+	* Reads a packed value from the page data.
+	*/
+	uint32_t ReadIndex(const uint32_t Index) const;
+
+	/**
+	* Writes a packed value to the page data.
+	*/
+	void WriteIndex(const uint32_t Index, const uint32_t Value);
+
+	/**
+	* Finds the palette entry for a block ID, adding one if it is not in the palette.
+	* The index width is increased when the palette is full.
+	* @return The palette entry for the ID.
+	*/
+	uint32_t FindOrAddPaletteEntry(const FBlockTypes::BlockID ID);
+
+	/**
+	* Repacks all blocks to a new index width.
+	*/
+	void Resize(const uint32_t BitsPerBlock);
+
+	/**
+	* Allocates pages for an index width.
+	*/
+	void AllocatePages(const uint32_t BitsPerBlock);
+
+	/**
+	* Frees all pages.
+	*/
+	void FreePages();
+
+private:
+	uint32_t*            mPages[MAX_PAGES];
+	FBlockTypes::BlockID mPalette[MAX_PALETTE_SIZE];
+	PaletteCount         mPaletteCounts[MAX_PALETTE_SIZE]; // Number of blocks using each palette entry
+	uint32_t             mPaletteSize;
+	uint32_t             mBitsPerBlock;
+	uint32_t             mHeapPages; // Bit set of pages allocated outside the page pool
+	FBlockTypes::BlockID mUniformID; // ID of every block while no pages are held
+};
+
+inline uint32_t FBlockStorage::PageCount(const uint32_t BitsPerBlock)
+{
+	return (BLOCK_COUNT * BitsPerBlock / 8 + PAGE_SIZE - 1) / PAGE_SIZE;
+}
+
+inline uint32_t FBlockStorage::ReadIndex(const uint32_t Index) const
+{
+	const uint32_t BitIndex = Index * mBitsPerBlock;
+	const uint32_t Word = BitIndex >> 5;
+	const uint32_t* Page = mPages[Word / WORDS_PER_PAGE];
+	const uint32_t Mask = (1u << mBitsPerBlock) - 1;
+
+	return (Page[Word % WORDS_PER_PAGE] >> (BitIndex & 31)) & Mask;
+}
+
+inline void FBlockStorage::WriteIndex(const uint32_t Index, const uint32_t Value)
+{
+	const uint32_t BitIndex = Index * mBitsPerBlock;
+	const uint32_t Word = BitIndex >> 5;
+	const uint32_t Shift = BitIndex & 31;
+	uint32_t& Data = mPages[Word / WORDS_PER_PAGE][Word % WORDS_PER_PAGE];
+	const uint32_t Mask = ((1u << mBitsPerBlock) - 1) << Shift;
+
+	Data = (Data & ~Mask) | ((Value << Shift) & Mask);
+}
+
+inline FBlockTypes::BlockID FBlockStorage::Get(const uint32_t Index) const
+{
+	ASSERT(Index < BLOCK_COUNT);
+
+	if (IsUniform())
+		return mUniformID;
+
+	const uint32_t Value = ReadIndex(Index);
+	return IsDirect() ? static_cast<FBlockTypes::BlockID>(Value) : mPalette[Value];
+}
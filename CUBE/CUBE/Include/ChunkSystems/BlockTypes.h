@@ -15,7 +15,13 @@
 class FBlockTypes
 {
 public:
+	// Define CUBE_16BIT_BLOCK_IDS to allow more than 256 block types. Chunk block storage
+	// is palette compressed, so wider IDs only cost memory in chunks that use them.
+#ifdef CUBE_16BIT_BLOCK_IDS
+	using BlockID = uint16_t;
+#else
 	using BlockID = uint8_t;
+#endif
 
 public:
 	FBlockTypes() = delete;
@@ -3,64 +3,134 @@
 #include <GL\glew.h>
 #include <cstdint>
 #include <atomic>
+#include <mutex>
+#include <memory>
+#include <unordered_map>
 
 #include "Memory\PoolAllocator.h"
+#include "Memory\VirtualPoolAllocator.h"
+#include "Memory\RecyclingAllocator.h"
 #include "Common.h"
 #include "Block.h"
 #include "BulletPhysics\btBulletCollisionCommon.h"
 #include "Rendering\GLBindings.h"
 #include "ChunkMesh.h"
 #include "BlockTypes.h"
+#include "BlockStorage.h"
+#include "ChunkGeometry.h"
+#include "RunLengthCodec.h"
+#include "BlockEdit.h"
 
 class FChunkManager;
 class FPhysicsSystem;
+class FMeshCacheFile;
+
+namespace FBenchmarks
+{
+	void ChunkLayout();
+	void ChunkStreaming();
+}
 
 /**
 * Represents a 3D mesh of voxels of CHUNK_SIZE
-* dimensions.
+* dimensions. Chunk dimensions and block layout are set by FChunkGeometry.
 */
 class FChunk
 {
 private:
+	struct SharedMesh;
+
 	WIN_ALIGN(16)
 	struct CollisionData
 	{
-		struct MeshData
-		{
-			MeshData()
-				: Mesh()
-				, Shape(&Mesh, false, false)
-			{}
-			btTriangleIndexVertexArray Mesh;
-			btBvhTriangleMeshShape     Shape;
-		};
-
 		CollisionData()
-			: Object()
+			: Mesh()
+			, Object()
 			, ActiveMesh(false)
 		{}
-		MeshData            Mesh[2]; // Double buffer for collision mesh data
-		btCollisionObject   Object;
-		bool                ActiveMesh;
+		std::shared_ptr<SharedMesh> Mesh[2];   // Double buffer for collision mesh data
+		Vector3f                    Origin[2]; // World position of each collision mesh
+		btCollisionObject           Object;
+		bool                        ActiveMesh;
 	};
 
 public:
 	// Dimensions of each chunk
-	static const int32_t CHUNK_SIZE = 32;
-	static const int32_t BLOCKS_PER_CHUNK = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
+	static const int32_t CHUNK_SIZE = FChunkGeometry::CHUNK_SIZE;
+	static const int32_t BLOCKS_PER_CHUNK = FChunkGeometry::BLOCKS_PER_CHUNK;
+	static_assert(BLOCKS_PER_CHUNK == FBlockStorage::BLOCK_COUNT, "Block storage must match the chunk dimensions.");
+
+	// Size of each run in RLE block data. Each run is a block ID followed by a length byte.
+	static const uint32_t RLE_RUN_SIZE = FRunLengthCodec::RUN_SIZE;
+
+	// Levels of detail chunks can be meshed at. Level n merges blocks into cells 2^n blocks across.
+	// Each level merges the cells of the level before it, so cells kept at one level give the
+	// same cells at every level past it.
+	static const uint32_t LOD_LEVELS = 4;
+	static_assert(CHUNK_SIZE % (1 << (LOD_LEVELS - 1)) == 0, "Chunks must split into whole cells at every level of detail.");
 
-	// Memory pools
+	// Memory pools. Memory is committed as chunks are created, and the pools grow past POOL_SIZE if needed.
 	static const uint32_t POOL_SIZE = 30000;
-	static FPoolAllocator<sizeof(FBlock) * BLOCKS_PER_CHUNK, POOL_SIZE> ChunkAllocator;
-	static FPoolAllocatorType<FChunkMesh, POOL_SIZE> MeshAllocator;
-	static FPoolAllocatorType<CollisionData, POOL_SIZE> CollisionAllocator;
+	static FPoolAllocatorType<FChunkMesh, POOL_SIZE, FVirtualPoolAllocator> MeshAllocator;
+	static FPoolAllocatorType<CollisionData, POOL_SIZE, FVirtualPoolAllocator> CollisionAllocator;
+
+	// If chunks with the same blocks and neighbor blocks share a mesh and collision shape
+	static bool ShareMeshes;
+
+	// Constants used for constructing quads with correct normals in GreedyMesh(). Also
+	// used to name the faces of a chunk. Each positive face is followed by its opposite.
+	struct NormalID
+	{
+		enum : uint32_t
+		{
+			East,
+			West,
+			Top,
+			Bottom,
+			North,
+			South
+		};
+	};
+
+	/**
+	* The blocks just outside each face, edge and corner of a chunk, taken from its neighbors.
+	* Used to cull faces on the chunk's border that are covered by a neighbor, and to find the
+	* ambient occlusion of faces at the chunk's edges.
+	*/
+	struct Apron
+	{
+		// Indexed by NormalID, then by U + V * CHUNK_SIZE, where U and V are the axes
+		// after the face's axis. East and west faces are indexed by y + z * CHUNK_SIZE.
+		FBlockTypes::BlockID Blocks[6][CHUNK_SIZE * CHUNK_SIZE];
+
+		// Indexed by the edge's axis * 4, plus 1 past the low side of the next axis and 2
+		// past the low side of the axis after it, then by position along the edge's axis.
+		FBlockTypes::BlockID Edges[12][CHUNK_SIZE];
+
+		// Indexed by 1 past the low side of x, plus 2 past the low side of y and 4 past the low side of z
+		FBlockTypes::BlockID Corners[8];
+	};
 
 public:
 	/**
-	* Returns the index of a block in the mBlocks array based on 3D coordinates within the chunk.
+	* Returns the index of a block in the block storage based on 3D coordinates within the chunk.
 	*/
-	static int32_t BlockIndex(Vector3i Position);
-	static int32_t FChunk::BlockIndex(int32_t X, int32_t Y, int32_t Z);
+	static int32_t BlockIndex(const Vector3i& Position);
+	static int32_t BlockIndex(int32_t X, int32_t Y, int32_t Z);
+
+	/**
+	* Gets the position of a block within its chunk from its world position.
+	*/
+	static Vector3i LocalPosition(const Vector3i& WorldPosition);
+
+	/**
+	* Finds the faces of a chunk that can face a point. Faces pointing away from the
+	* point on every block of the chunk are left out.
+	* @param ChunkPosition - Position of the chunk in chunk coordinates.
+	* @param ViewPosition - World position the chunk is seen from.
+	* @return Bit set of NormalIDs.
+	*/
+	static uint32_t FacingFaces(const Vector3i& ChunkPosition, const Vector3f& ViewPosition);
 
 public:
 	/**
@@ -79,14 +149,24 @@ public:
 	/**
 	* Allocates and builds chunk data. Chunk meshes will still need to 
 	* be built before rendering.
-	* @param BlockData - RLE block layout for this chunk.
-	* @return True if the chunk is not empty, false otherwise.
+	* @param BlockData - RLE block layout for this chunk, or a single block ID for uniform chunks.
+	* @return True if the chunk only contains air, false otherwise.
 	*/
 	bool Load(const std::vector<uint8_t>& BlockData);
 
+	/**
+	* Loads the chunk from the cells written by Coarsen(), in place of its blocks.
+	* @param CellData - Cells of the chunk, or a single block ID if every cell has the same type.
+	* @param Lod - Level of detail the cells were kept at.
+	* @return True if the chunk only contains air, false otherwise.
+	*/
+	bool LoadCells(const std::vector<uint8_t>& CellData, const uint32_t Lod);
+
 	/**
 	* Frees block and mesh data.
-	* @param BlockDataOut - Memory to place RLE block layout for this chunk.
+	* @param BlockDataOut - Memory to place RLE block layout for this chunk. Uniform chunks
+	*                      only write their block ID. Chunks keeping cells write nothing, as
+	*                      their changed blocks were written when they were coarsened.
 	*/
 	void Unload(std::vector<uint8_t>& BlockDataOut);
 
@@ -97,13 +177,26 @@ public:
 
 	/**
 	* Builds/Rebuilds this chunks' mesh.
+	* @param WorldPosition - World position of the chunk.
+	* @param Neighbors - Blocks around the chunk. Faces covered by them are not built.
+	* @param Lod - Level of detail. Above 0, each cell of blocks is meshed as its most common
+	*              solid type, or air if less than half of it is solid.
+	* @param MeshFile - Mesh cache of the chunk's region, or nullptr. Chunks that haven't been
+	*                   edited since they were loaded read their mesh from it when their blocks
+	*                   and neighbors haven't changed, and write it back when they have.
 	*/
-	void RebuildMesh(const Vector3f& WorldPosition);
+	void RebuildMesh(const Vector3f& WorldPosition, const Apron& Neighbors, const uint32_t Lod = 0, FMeshCacheFile* MeshFile = nullptr);
+
+	/**
+	* Gets the level of detail of the last mesh built. Only used by the thread rebuilding the mesh.
+	*/
+	uint32_t GetLod() const { return mLod; }
 
 	/**
 	* Swaps the currently used mesh for rendering.
+	* @return Bytes uploaded to the GPU for the new mesh. Meshes shared with chunks that were swapped in before upload nothing.
 	*/
-	void SwapMeshBuffer(FPhysicsSystem& PhysicsSystem);
+	uint32_t SwapMeshBuffer(FPhysicsSystem& PhysicsSystem);
 
 	/**
 	* Checks if the chunk has been loaded.
@@ -112,81 +205,308 @@ public:
 
 	/**
 	* Renders active blocks in the chunk.
+	* @param Faces - Bit set of the NormalIDs of the faces to draw.
 	*/
-	void Render(const GLenum RenderMode = GL_TRIANGLES);
+	void Render(const GLenum RenderMode = GL_TRIANGLES, const uint32_t Faces = FChunkMesh::ALL_FACES);
 
 	/**
 	* Set a block in the chunk at a specific position.
+	* @return False if the block already had the ID, or the chunk isn't loaded or editable.
 	*/
-	void SetBlock(const Vector3i& Position, FBlockTypes::BlockID ID);
+	bool SetBlock(const Vector3i& Position, FBlockTypes::BlockID ID);
 
 	/**
 	* Retrieves the type of block in the chunk at a specific position.
 	*/
 	FBlockTypes::BlockID GetBlock(const Vector3i& Position) const;
 
+	/**
+	* Locks the blocks of the chunk for a reader that reads many of them, so each read can
+	* skip locking with GetBlockLocked(). The thread holding the lock can still edit the chunk.
+	*/
+	std::unique_lock<std::recursive_mutex> LockBlocks() const;
+
+	/**
+	* Retrieves the type of block at a position without locking. The lock from LockBlocks() must be held.
+	*/
+	FBlockTypes::BlockID GetBlockLocked(const Vector3i& Position) const;
+
 	/**
 	* Destroys a block in the chunk at a specific position.
-	* @return ID of the block that was destroyed.
+	* @return ID of the block that was destroyed. Air if nothing was destroyed or the chunk isn't loaded or editable.
 	*/
 	FBlockTypes::BlockID DestroyBlock(const Vector3i& Position);
 
+	/**
+	* Writes the parts of an edit that overlap this chunk. The block lock is held once for
+	* the whole edit and the block storage is repacked once after all writes.
+	* @param Edit - The edit to apply.
+	* @param ChunkOrigin - World position of the first block in this chunk.
+	* @param Voxels - Indices of the edit's voxels that lie within this chunk, in edit order.
+	* @param VoxelCount - Number of voxel indices.
+	* @param ChangesOut - Each write that changed a block is appended.
+	* @return True if any block was changed. False if the chunk isn't loaded or editable.
+	*/
+	bool ApplyEdit(const FBlockEdit& Edit, const Vector3i& ChunkOrigin, const uint32_t* Voxels, const uint32_t VoxelCount, std::vector<FBlockChange>& ChangesOut);
+
+	/**
+	* Copies the blocks on one face of the chunk, in the order used by Apron.
+	* @param Face - The NormalID of the face.
+	* @param BlocksOut - Memory for CHUNK_SIZE * CHUNK_SIZE block IDs.
+	* @param Lod - Level of detail. Above 0, the cells along the face are read as the chunk
+	*              would mesh them at that level.
+	* @return False if all of the blocks are air.
+	*/
+	bool ReadFace(const uint32_t Face, FBlockTypes::BlockID* BlocksOut, const uint32_t Lod = 0) const;
+
+	/**
+	* Copies the blocks along one edge of the chunk, in the order used by Apron.
+	* @param Edge - Index of the edge in Apron::Edges.
+	* @param BlocksOut - Memory for CHUNK_SIZE block IDs.
+	* @param Lod - Level of detail. Above 0, the cells along the edge are read as the chunk
+	*              would mesh them at that level.
+	* @return False if all of the blocks are air.
+	*/
+	bool ReadEdge(const uint32_t Edge, FBlockTypes::BlockID* BlocksOut, const uint32_t Lod = 0) const;
+
+	/**
+	* Gets the block in one corner of the chunk, or the cell in that corner at a lower level of detail.
+	* @param Corner - Index of the corner in Apron::Corners.
+	*/
+	FBlockTypes::BlockID ReadCorner(const uint32_t Corner, const uint32_t Lod = 0) const;
+
+	/**
+	* Marks the faces on a border of the chunk to be rebuilt, such as when blocks next to it
+	* in a neighbor have changed.
+	* @param Face - The NormalID of the border.
+	*/
+	void MarkBorderDirty(const uint32_t Face);
+
 	/**
 	* Checks if this chunk contains any blocks.
 	*/
 	bool IsEmpty() const { return mIsEmpty; }
 
+	/**
+	* Releases the block storage and keeps the blocks as RLE data. Blocks can still be read
+	* and the mesh rebuilt while hibernating. The storage is only restored when a block is
+	* set or destroyed. Uniform chunks hold no block pages and are not hibernated.
+	*/
+	void Hibernate();
+
+	/**
+	* Checks if the blocks of this chunk are only held as RLE data.
+	*/
+	bool IsHibernating() const;
+
+	/**
+	* Gets the number of bytes of RLE data held by all hibernating chunks.
+	*/
+	static uint32_t GetHibernatedMemoryUsage();
+
+	/**
+	* Replaces the blocks with their cells at a level of detail, so the chunk keeps
+	* (CHUNK_SIZE >> Lod)^3 block IDs, or one if every cell has the same type. The chunk can
+	* still be read and meshed at that level and past it, but can't be edited until it is
+	* loaded again. Uniform chunks, and chunks already keeping cells at the level or past it,
+	* are left as they are.
+	* @param BlockDataOut - RLE blocks are appended if a block was changed since the chunk was
+	*                       loaded, as they can't be unloaded once they are replaced.
+	* @param CellDataOut - The cells are appended if they were found from the chunk's blocks, in
+	*                      the format read by LoadCells().
+	*/
+	void Coarsen(const uint32_t Lod, std::vector<uint8_t>& BlockDataOut, std::vector<uint8_t>& CellDataOut);
+
+	/**
+	* Gets the level of detail of the cells kept in place of the chunk's blocks, or 0 if it
+	* keeps its blocks. Only changed by the thread loading and meshing the chunk.
+	*/
+	uint32_t GetCellLod() const { return mCellLod; }
+
+	/**
+	* Checks if the chunk's blocks can be edited. Chunks that only keep their cells refuse edits
+	* until they are loaded again. The lock from LockBlocks() must be held.
+	*/
+	bool IsEditable() const { return mCellLod == 0; }
+
+	/**
+	* Gets the number of bytes of cells kept by all coarsened chunks.
+	*/
+	static uint32_t GetCellMemoryUsage();
+
 private:
-	// Constants used for constructing quads with correct normals in GreedyMesh()
-	struct NormalID
+	friend void FBenchmarks::ChunkLayout();
+	friend void FBenchmarks::ChunkStreaming();
+
+private:
+	// Each face direction has a layer of faces on both sides of every slice of blocks
+	static const uint32_t LAYERS_PER_FACE = CHUNK_SIZE + 1;
+	static const uint32_t MESH_LAYER_COUNT = 6 * LAYERS_PER_FACE;
+	static_assert(CHUNK_SIZE <= 64, "Dirty slices are tracked in 64 bit masks.");
+
+	/**
+	* A mesh and collision shape built from a chunk's blocks. Meshes of chunks that haven't
+	* been edited are found by a hash of their blocks and neighbor blocks, so chunks with
+	* the same contents share one. Collision positions are relative to the chunk.
+	* \n
+	* Released meshes are kept in a free list with their buffers and collision objects, to
+	* be rebuilt in place by the next chunk that needs a mesh.
+	*/
+	struct SharedMesh
 	{
-		enum : uint32_t
-		{
-			East,
-			West,
-			Top,
-			Bottom,
-			North,
-			South
-		};
+		SharedMesh();
+
+		uint64_t                                    Hash;     // 0 if the mesh isn't shared
+		std::vector<uint8_t>                        Key;      // Runs of the blocks and neighbor blocks the mesh was built from
+		FChunkMesh::RenderData                      Render;
+		std::vector<Vector3f>                       Positions;
+		std::vector<uint32_t>                       Indices;
+		std::unique_ptr<btTriangleIndexVertexArray> Mesh;
+		std::unique_ptr<btBvhTriangleMeshShape>     Shape;    // Only holds this mesh's shape if there are quads
+		SharedMesh*                                 NextFree; // Next mesh in the free list
+	};
+
+	/**
+	* Deleter for shared meshes that returns them to the free list.
+	*/
+	struct MeshRecycler
+	{
+		void operator()(SharedMesh* Mesh) const;
+	};
+
+	using SharedMeshTable = std::unordered_map<uint64_t, std::weak_ptr<SharedMesh>, std::hash<uint64_t>, std::equal_to<uint64_t>,
+	                                           TRecyclingAllocator<std::pair<const uint64_t, std::weak_ptr<SharedMesh>>>>;
+
+	/**
+	* Mesh data from the last rebuild of an edited chunk. Quads are grouped by face
+	* direction and layer in the order GreedyMesh() builds them, so layers with no
+	* changed blocks can be copied into the next mesh instead of being rebuilt.
+	*/
+	struct MeshCache
+	{
+		FChunkMesh::QuadData Quads;
+		uint32_t             LayerStarts[MESH_LAYER_COUNT + 1]; // First quad of each layer
 	};
 
-private:
 	/**
 	* Voxel mesh algorithm to minimize triangle count on chunk meshes.
 	* Algorithm by Mikola Lysenko from http://0fps.net/2012/06/30/meshing-in-a-minecraft-game/
+	* @param Neighbors - Blocks around the chunk.
+	* @param Lod - Level of detail to mesh the blocks at.
+	* @param ChunkPosition - Chunk space position of the chunk, for finding its mesh in MeshFile.
+	* @param MeshFile - Mesh cache to read and write the mesh, or nullptr.
+	* @param IsSharedOut - Set if the mesh of a chunk with the same contents was found. Its
+	*                      collision shape is already built.
+	*/
+	std::shared_ptr<SharedMesh> GreedyMesh(const Apron& Neighbors, const uint32_t Lod, const Vector3i& ChunkPosition, FMeshCacheFile* MeshFile, bool& IsSharedOut);
+
+	/**
+	* Takes a mesh from the free list, or allocates one if the list is empty.
+	* @param QuadHint - Number of quads to reserve room for.
+	*/
+	static std::shared_ptr<SharedMesh> AcquireMesh(const uint32_t QuadHint);
+
+	/**
+	* Builds the collision shape of a new mesh from its quads.
+	*/
+	static void BuildCollisionShape(SharedMesh& Mesh);
+
+	/**
+	* Retrieves a block whether or not the chunk is hibernating. Chunks keeping cells read the
+	* cell holding the block. mBlockMutex must be held.
+	*/
+	FBlockTypes::BlockID ReadBlock(const Vector3i& Position) const;
+
+	/**
+	* Expands all blocks into a flat array whether or not the chunk is hibernating. Chunks
+	* keeping cells fill each cell's blocks with its type. mBlockMutex must be held.
+	* @param BlocksOut - Room for BLOCKS_PER_CHUNK + FRunLengthCodec::DECODE_PADDING block IDs.
+	*/
+	void UnpackBlocks(FBlockTypes::BlockID* BlocksOut) const;
+
+	/**
+	* Checks if the chunk is filled with one block type held by the block storage. mBlockMutex must be held.
+	*/
+	bool HasUniformBlocks() const;
+
+	/**
+	* Marks the slices holding a block as changed since the last rebuild. mBlockMutex must be held.
+	*/
+	void MarkDirty(const Vector3i& Position);
+
+	/**
+	* Restores the block storage of a hibernating chunk. mBlockMutex must be held.
+	*/
+	void Wake();
+
+	/**
+	* Frees the RLE data of a hibernating chunk. mBlockMutex must be held.
+	*/
+	void ReleaseHibernatedBlocks();
+
+	/**
+	* Frees the cells of a coarsened chunk. mBlockMutex must be held.
+	*/
+	void ReleaseCells();
+
+	/**
+	* Copies the quads of a layer from the mesh cache.
+	* @param Cache - Mesh data from the last rebuild.
+	* @param Layer - Index of the face direction and layer.
+	* @param QuadsOut - Location to place quad data.
+	*/
+	void AddCachedQuads(const MeshCache& Cache, const uint32_t Layer, FChunkMesh::QuadData& QuadsOut);
+
+	/**
+	* Adds the outer faces of a chunk filled with a single block type.
+	* @param BlockType - The type of block filling the chunk.
+	* @param Faces - Bit set of the NormalIDs of the faces to add.
+	* @param QuadsOut - Location to place quad data.
 	*/
-	void GreedyMesh(const Vector3f WorldPosition);
-
-	/**
-	* Adds a quad from 4 vertices based on if the quad is backfaced, the direction of the surface,
-	* and block type we are generating the quad for. Output is given through a given vertex and index
-	* list.
-	* @param Bottom left position
-	* @param Top left position
-	* @param Top right position
-	* @param Bottom right position
-	* @param IsBackFace - Used to specify vertex ordering.
-	* @param Side - Direction the surface is facing
-	* @param Type - The type of block the quad is used for.
-	* @param VerticesOut - Location to place vertex data.
-	* @param IndicesOut - Location to place index data.
-	*/
-	void AddQuad(	const Vector3f& BottomLeft, 
-					const Vector3f& TopLeft, 
-					const Vector3f& TopRight, 
-					const Vector3f& BottomRight,
-					const bool IsBackface, 
-					const uint32_t Side, 
-					const FBlock BlockType,
-					FChunkMesh::VertexData& VerticesOut,
-					FChunkMesh::IndexData& IndicesOut);
+	void AddUniformFaces(const FBlock BlockType, const uint32_t Faces, FChunkMesh::QuadData& QuadsOut);
 
 private:
-	FBlock* mBlocks;
+	FBlockStorage mBlocks;
+	std::vector<uint8_t> mHibernatedBlocks; // Slice offsets followed by RLE blocks while hibernating
+	std::vector<FBlockTypes::BlockID> mCells; // Cells kept in place of the blocks, by y, then x, then z. Empty if they're uniform.
+	uint32_t mCellLod;                        // Level of detail of the kept cells, 0 while the blocks are kept
+	bool mIsModified;                         // Set when a block is changed after the chunk is loaded
+	mutable std::recursive_mutex mBlockMutex; // Guards the blocks, cells and mIsModified between the game and loader threads
 	FChunkMesh* mMesh;
 	CollisionData* mCollisionData;
+	std::unique_ptr<MeshCache> mMeshCache; // Only used by the thread rebuilding the mesh
+	uint32_t mQuadHint;                    // Quad count of the last mesh built, only used by the thread rebuilding the mesh
+	uint32_t mLod;                         // Level of detail of the last mesh built, only used by the thread rebuilding the mesh
+	uint64_t mDirtySlices[3];              // Slices along x, y and z with blocks changed since the last rebuild, guarded by mBlockMutex
+	uint32_t mDirtyBorders;                // Bit set of NormalIDs with neighbor blocks changed since the last rebuild, guarded by mBlockMutex
 
 	std::atomic_bool mIsLoaded;
 	std::atomic_bool mIsEmpty;
-};
\ No newline at end of file
+
+	// Meshes that can be shared, by hash. Entries are removed as meshes are freed.
+	static std::mutex SharedMeshMutex;
+	static SharedMeshTable SharedMeshes;
+
+	// Released meshes waiting to be rebuilt
+	static std::mutex FreeMeshMutex;
+	static SharedMesh* FreeMeshes;
+};
+
+inline int32_t FChunk::BlockIndex(const Vector3i& Position)
+{
+	ASSERT(Position.x >= 0 && Position.x < CHUNK_SIZE &&
+		Position.y >= 0 && Position.y < CHUNK_SIZE &&
+		Position.z >= 0 && Position.z < CHUNK_SIZE);
+
+	return (int32_t)FChunkGeometry::BlockIndex(Position.x, Position.y, Position.z);
+}
+
+inline int32_t FChunk::BlockIndex(int32_t X, int32_t Y, int32_t Z)
+{
+	return (int32_t)FChunkGeometry::BlockIndex(X, Y, Z);
+}
+
+inline Vector3i FChunk::LocalPosition(const Vector3i& WorldPosition)
+{
+	return Vector3i{ WorldPosition.x & (CHUNK_SIZE - 1), WorldPosition.y & (CHUNK_SIZE - 1), WorldPosition.z & (CHUNK_SIZE - 1) };
+}
\ No newline at end of file
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+
+template <uint32_t EdgeShift>
+/**
+* Stores blocks in x/y/z linear order. Blocks along z are contiguous,
+* followed by rows along x, then slices along y.
+* @param EdgeShift - Log2 of the chunk edge length.
+*/
+struct TLinearLayout
+{
+	// Rows of blocks along z are contiguous in memory
+	static const bool CONTIGUOUS_Z = true;
+
+	static uint32_t Index(const uint32_t X, const uint32_t Y, const uint32_t Z)
+	{
+		return (Y << (2 * EdgeShift)) | (X << EdgeShift) | Z;
+	}
+
+	static uint32_t NextZ(const uint32_t Index)
+	{
+		return Index + 1;
+	}
+
+	static const char* Name() { return "Linear"; }
+};
+
+template <uint32_t EdgeShift>
+/**
+* Stores blocks in Morton (Z-order) order. The bits of each coordinate are
+* interleaved, z in the lowest bit, then x, then y, so blocks that are close in
+* any direction are usually close in memory.
+* @param EdgeShift - Log2 of the chunk edge length.
+*/
+struct TMortonLayout
+{
+	static_assert(EdgeShift <= 10, "Morton indices are limited to 10 bits per axis.");
+
+	// Rows of blocks along z are contiguous in memory
+	static const bool CONTIGUOUS_Z = false;
+
+	static uint32_t Index(const uint32_t X, const uint32_t Y, const uint32_t Z)
+	{
+		return (Spread(Y) << 2) | (Spread(X) << 1) | Spread(Z);
+	}
+
+	static uint32_t NextZ(const uint32_t Index)
+	{
+		// Setting every bit outside of z makes the carry skip over the x and y bits
+		const uint32_t Z = ((Index | ~Z_MASK) + 1) & Z_MASK;
+		return (Index & ~Z_MASK) | Z;
+	}
+
+	static const char* Name() { return "Morton"; }
+
+private:
+	static const uint32_t Z_MASK = 0x09249249 & ((1u << (3 * EdgeShift)) - 1);
+
+	/**
+	* Inserts two zero bits between each of the low 10 bits of a value.
+	*/
+	static uint32_t Spread(uint32_t Value)
+	{
+		Value = (Value | (Value << 16)) & 0x030000FF;
+		Value = (Value | (Value << 8)) & 0x0300F00F;
+		Value = (Value | (Value << 4)) & 0x030C30C3;
+		Value = (Value | (Value << 2)) & 0x09249249;
+		return Value;
+	}
+};
+
+template <uint32_t EdgeShift, template <uint32_t> class LayoutType>
+/**
+* Compile time description of chunk dimensions and the order blocks are stored
+* in memory. All index math is resolved at compile time to shifts and masks.
+* \n
+* Chunk data on disk is always ordered y, x, z, so region files only depend on the chunk
+* edge length and not on the memory layout.
+* @param EdgeShift - Log2 of the chunk edge length.
+* @param LayoutType - TLinearLayout or TMortonLayout.
+*/
+struct TChunkGeometry
+{
+	static_assert(EdgeShift >= 4 && EdgeShift <= 6, "Chunk edges of 16, 32 and 64 blocks are supported.");
+
+	typedef LayoutType<EdgeShift> Layout;
+
+	static const uint32_t EDGE_SHIFT = EdgeShift;
+	static const int32_t CHUNK_SIZE = 1 << EdgeShift;
+	static const int32_t BLOCKS_PER_CHUNK = 1 << (3 * EdgeShift);
+
+	/**
+	* Gets the index of a block from coordinates within the chunk.
+	*/
+	static uint32_t BlockIndex(const int32_t X, const int32_t Y, const int32_t Z)
+	{
+		return Layout::Index((uint32_t)X, (uint32_t)Y, (uint32_t)Z);
+	}
+
+	/**
+	* Gets the index of the block one step along z from a block index.
+	*/
+	static uint32_t NextZ(const uint32_t Index)
+	{
+		return Layout::NextZ(Index);
+	}
+};
+
+// Define CUBE_CHUNK_EDGE_SHIFT as 4, 5 or 6 for chunks of 16, 32 or 64 blocks. Define
+// CUBE_MORTON_CHUNK_LAYOUT to store chunk blocks in Morton order. Worlds are only
+// compatible with builds that use the same chunk edge.
+#ifndef CUBE_CHUNK_EDGE_SHIFT
+#define CUBE_CHUNK_EDGE_SHIFT 5
+#endif
+
+#ifdef CUBE_MORTON_CHUNK_LAYOUT
+typedef TChunkGeometry<CUBE_CHUNK_EDGE_SHIFT, TMortonLayout> FChunkGeometry;
+#else
+typedef TChunkGeometry<CUBE_CHUNK_EDGE_SHIFT, TLinearLayout> FChunkGeometry;
+#endif
@@ -6,8 +6,13 @@
 #include <string>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 #include "Chunk.h"
+#include "ChunkWorkerPool.h"
+#include "StreamGovernor.h"
+#include "Containers\MPSCRing.h"
 #include "LibNoise\noise.h"
 #include "LibNoise\noiseutils.h"
 #include "Utils/Singleton.h"
@@ -18,12 +23,37 @@
 
 class FPhysicsSystem;
 class FRenderSystem;
+class FVoxelCursor;
 
 /**
 * Class for managing a world.
+* \n
+* Chunks are streamed in by the loader thread in batches. Each batch goes through
+* unloading, region file I/O, decoding and meshing in stages, and the unload, decode and
+* mesh stages are spread over a pool of worker threads. A chunk is only touched by the job
+* that owns it during a stage. Reading the blocks of neighbors and other work that spans
+* chunks is done by the loader thread between stages. Meshes are swapped in by the main thread.
+* \n
+* Each chunk slot has an atomic state that tells which thread owns it. The loader thread
+* hands finished meshes to the main thread through a lock-free ring of slot indices, and
+* a slot is only ever in the ring once.
+* \n
+* Chunks are loaded nearest first, with chunks in view ahead of hidden ones. The loader
+* thread sleeps until the view changes, blocks are changed or meshes are swapped in.
+* \n
+* Meshes are swapped in within a per frame upload budget, and loading is throttled while
+* frames run over the frame budget. See FStreamGovernor.
+* \n
+* Chunks meshed at level of detail 2 or past it only keep their cells, a 64th as many block
+* IDs as they have blocks or fewer, so the far rings cost little memory as the view grows. Their
+* changed blocks are written to the region file as they are coarsened, and their cells
+* are kept in the mesh cache so they can be loaded again without their blocks. Chunks that
+* move nearer than their cells allow are loaded again.
 */
 class FChunkManager
 {
+	friend class FVoxelCursor;
+
 public:
 	FChunkManager();
 	~FChunkManager();
@@ -42,7 +72,8 @@ public:
 	void Render(FRenderSystem& Renderer, const GLenum RenderMode = GL_TRIANGLES);
 
 	/**
-	* Set a block in the world at a specific position.
+	* Set a block in the world at a specific position. Blocks in chunks that only keep their
+	* cells can't be set, and mOnEditRejected is invoked with the chunk.
 	*/
 	void SetBlock(const Vector3i& Position, FBlockTypes::BlockID ID);
 
@@ -52,10 +83,19 @@ public:
 	FBlockTypes::BlockID GetBlock(Vector3i Position) const;
 
 	/**
-	* Destroys a block in the world at a specific position.
+	* Destroys a block in the world at a specific position. Blocks in chunks that only keep
+	* their cells can't be destroyed, and mOnEditRejected is invoked with the chunk.
 	*/
 	void DestroyBlock(const Vector3i& Position);
 
+	/**
+	* Applies a batch of block writes. Each touched chunk is written once and queued for a
+	* single rebuild. Rather than an event per block, mOnBlocksChanged is invoked once with
+	* every block that was changed. Writes outside of loaded chunks are ignored. Chunks that
+	* only keep their cells aren't written, and mOnEditRejected is invoked with each of them.
+	*/
+	void ApplyEdit(const FBlockEdit& Edit);
+
 	/**
 	* Retrieves the size of the world in chunks.
 	*/
@@ -78,14 +118,136 @@ public:
 	/**
 	* Sets the world view distance. This is in terms
 	* of chunk space.
+	* \n
+	* Each slot of the chunk ring holds an FChunk and its mesh buffers. The ring is 2 * Distance + 1
+	* chunks wide and Distance + 1 chunks high, with each dimension rounded up to a power of two.
+	* Distances of 2^n - 1 fill the ring exactly. Other distances pay for unused slots, up to
+	* nearly 8 times as many in the worst case. The default of 15 fills its 16384 slots.
+	* \n
+	* Chunks past the distance of level of detail 2 only keep their cells, so larger distances
+	* mostly pay for the slots themselves.
 	*/
 	void SetViewDistance(const uint32_t Distance);
 
+	/**
+	* Sets the distance past which chunks are meshed at a level of detail. This is in terms
+	* of chunk space. Distances should grow with the level.
+	* @param Lod - Level of detail, from 1 to FChunk::LOD_LEVELS - 1.
+	* @param Distance - Chunks further than this from the camera's chunk along any axis use the level.
+	*                   Past the distance of level 2, chunks only keep their cells and can't be edited.
+	*/
+	void SetLodDistance(const uint32_t Lod, const uint32_t Distance);
+
 	/**
 	* Sets the physics system used by the chunk manager.
 	*/
 	void SetPhysicsSystem(FPhysicsSystem& Physics);
 
+	/**
+	* Sets if chunks are hibernated after they are loaded and meshed. Hibernated chunks
+	* only keep RLE block data until a block in them is changed. Off by default.
+	*/
+	void SetChunkHibernation(const bool Enabled);
+
+	/**
+	* Sets if meshes are kept in a mesh cache file next to each region file, so chunks
+	* that haven't changed since they were last meshed can skip the mesher when they are
+	* loaded. The cells of far chunks are kept in them too, so the chunks are loaded without
+	* reading their blocks. Caches are saved with the world. Off by default.
+	*/
+	void SetMeshCaching(const bool Enabled);
+
+	/**
+	* Sets the time each frame should take. Mesh uploads and chunk loading are throttled
+	* while frames run over it. 16.7 ms by default.
+	*/
+	void SetFrameBudget(const float Milliseconds);
+
+	/**
+	* Sets if the view distance is stepped down while frames stay over budget, and back up
+	* once there is headroom. Chunks past the stepped down distance are not drawn or loaded.
+	* Off by default.
+	*/
+	void SetViewDistanceScaling(const bool Enabled);
+
+	/**
+	* Gets the governor keeping streaming within the frame budget.
+	*/
+	const FStreamGovernor& GetStreamGovernor() const;
+
+	/**
+	* Gets the rate chunks were loaded at during the last stream, in chunks per second. A stream
+	* starts when chunks need to be loaded and ends once every loaded chunk is meshed and swapped in.
+	*/
+	float GetStreamRate() const;
+
+	/**
+	* Gets the number of threads chunks are streamed on.
+	*/
+	uint32_t GetStreamThreadCount() const;
+
+private:
+	/**
+	* States of a chunk slot. Slots go from Empty to Loading, Meshed, Uploading and Uploaded, then
+	* back to Loading each time they are rebuilt or reused for another chunk. The loader thread
+	* owns a slot while it is Loading, and the main thread while it is Uploading.
+	* \n
+	* Dirty and Queued are flags kept along with the state, as chunks can be changed while they
+	* are built or waiting to be swapped in. Replacing is set while the loader thread gives the
+	* slot another chunk's blocks, so the main thread leaves its blocks alone until they are loaded.
+	*/
+	struct ChunkState
+	{
+		enum : uint8_t
+		{
+			Empty,     // Holds no blocks
+			Loading,   // Being loaded or meshed by the loader thread
+			Meshed,    // Mesh is built and waiting to be swapped in
+			Uploading, // Mesh is being swapped in by the main thread
+			Uploaded,  // Mesh is swapped in
+			StateMask = 0x0f,
+			Replacing = 0x10, // Being unloaded and loaded with the blocks of the chunk at a new position
+			Waiting = 0x20, // Loaded without a mesh until its neighbors in range are loaded
+			Dirty = 0x40,   // Waiting in the rebuild list
+			Queued = 0x80   // Waiting in the mesh swap ring
+		};
+	};
+
+	/**
+	* A chunk waiting to be loaded. Requests are made when chunks come into range, and
+	* dropped when they leave it.
+	*/
+	struct LoadRequest
+	{
+		uint32_t Priority;   // Lower priorities are loaded first
+		uint32_t View;       // Queue view the priority was scored for
+		Vector3i Position;
+
+		// Heaps keep the lowest priority on top
+		bool operator<(const LoadRequest& Other) const { return Priority > Other.Priority; }
+	};
+
+	/**
+	* A chunk being loaded or rebuilt by the loader thread and its workers.
+	*/
+	struct StreamJob
+	{
+		Vector3i             Position;
+		Vector3i             UnloadPosition; // Position of the blocks the chunk held before being loaded
+		int32_t              Index;
+		uint32_t             Lod;
+		bool                 IsUnloading;
+		bool                 NeedsRebuild;
+		bool                 IsWaiting;      // The first mesh waits for the neighbors to load
+		FMeshCacheFile*      MeshFile;
+		uint32_t             CellLod;        // Level of detail of the cells read in place of the blocks, or 0
+		std::vector<uint8_t> BlockData;      // RLE blocks read from the region file, or cells read from the mesh cache
+		std::vector<uint8_t> UnloadData;     // RLE blocks the chunk held before, written to the region file
+		std::vector<uint8_t> SavedData;      // RLE blocks of a changed chunk written as it is coarsened
+		std::vector<uint8_t> CellData;       // Cells the chunk is coarsened to, kept in the mesh cache
+		FChunk::Apron        Neighbors;
+	};
+
 private:
 	void InitializeWorld();
 
@@ -103,16 +265,65 @@ private:
 
 	void ChunkLoaderThreadLoop();
 
+	/**
+	* Checks if the loader thread has anything to do. mLoaderMutex must be held.
+	*/
+	bool HasLoaderWork();
+
+	/**
+	* Wakes the loader thread after work is added for it. Must not be called while
+	* holding mRebuildListMutex.
+	*/
+	void WakeLoader();
+
+	/**
+	* Gives the loader thread the current view of the camera to load chunks around. Only used by the main thread.
+	* @param LoadDistance - View distance to load chunks to, after any steps taken down by the governor.
+	*/
+	void RefreshView(const Vector3i& CameraChunk, const int32_t LoadDistance);
+
+	/**
+	* Gets the view frustum of the main camera in chunk space, with chunk positions at the center of each chunk.
+	*/
+	FFrustum ChunkViewFrustum() const;
+
+	/**
+	* Gets the load priority of a chunk. Chunks are loaded nearest first, and chunks in view
+	* are loaded at the same time as hidden chunks twice as far away.
+	* @param ViewCenter - Chunk position of the camera.
+	* @param ViewFrustum - View frustum in chunk space.
+	*/
+	static uint32_t LoadPriority(const Vector3i& ChunkPosition, const Vector3i& ViewCenter, const FFrustum& ViewFrustum);
+
 	/**
 	* Processes the buffer swap list for chunks.
 	*/
 	void SwapChunkBuffers();
 
 	/**
-	* Updates the current load list
+	* Loads the next batches of chunks in the load list. The blocks of each batch are read
+	* while the batch before it is meshed.
 	*/
 	void UpdateLoadList();
 
+	/**
+	* Takes the next batch of chunks from the load queue. Only used by the loader thread.
+	* @param Jobs - Stream jobs to fill.
+	* @return Number of jobs claimed.
+	*/
+	uint32_t ClaimLoadJobs(std::vector<StreamJob>& Jobs);
+
+	/**
+	* Reads the RLE blocks of claimed chunks from their region files. Only used by the loader thread.
+	*/
+	void ReadChunkData(std::vector<StreamJob>& Jobs, const uint32_t JobCount);
+
+	/**
+	* Unloads the blocks the chunks of mStreamJobs held before, decodes their new blocks and queues
+	* rebuilds of the neighbors they change. Only used by the loader thread.
+	*/
+	void LoadStreamJobs(const uint32_t JobCount);
+
 	/**
 	* Rebuilds the chunks that have
 	* changed during the last update.
@@ -120,10 +331,105 @@ private:
 	void UpdateRebuildList();
 
 	/**
-	* Updates the currently visible chunks in the scene.
+	* Gathers the neighbor blocks of stream jobs that need a rebuild, then starts meshing them on
+	* the workers. The jobs are done once mWorkerPool.Wait() returns. Only used by the loader thread.
+	* @param JobCount - Number of jobs in mStreamJobs to mesh.
+	* @param Hibernate - If chunks are hibernated after they are meshed.
+	*/
+	void MeshStreamJobs(const uint32_t JobCount, const bool Hibernate);
+
+	/**
+	* Writes the changed blocks and the cells of the stream jobs coarsened while they were meshed.
+	* Only used by the loader thread, once the jobs are done.
+	*/
+	void SaveCoarsenedChunks(const uint32_t JobCount);
+
+	/**
+	* Checks if enough meshes are waiting to be swapped in that no more chunks should be loaded.
+	*/
+	bool IsSwapBacklogFull() const;
+
+	/**
+	* Queues a mesh swap for the chunk of each stream job. Only used by the loader thread.
+	*/
+	void QueueBufferSwaps(const uint32_t JobCount);
+
+	/**
+	* Takes a chunk slot for the loader thread, waiting for its mesh to be swapped in
+	* first if the main thread is in the middle of it. Clears the slot's dirty flag, as
+	* the chunk is rebuilt anyway. Only used by the loader thread.
+	* @param IsReplacing - If the slot is given another chunk's blocks. It is flagged until they are loaded.
+	*/
+	void ClaimChunk(const int32_t Index, const bool IsReplacing);
+
+	/**
+	* Marks a chunk slot as needing a rebuild.
+	* @return False if the slot holds no chunk or is already marked.
+	*/
+	bool MarkChunkDirty(const int32_t Index);
+
+	/**
+	* Changes the state of a chunk slot, keeping its flags.
+	* @return The state the slot was in, with its flags.
+	*/
+	uint8_t SetChunkState(const int32_t Index, const uint8_t State);
+
+	/**
+	* Records the stream rate once the stream in progress is finished. Only used by the loader thread.
+	*/
+	void UpdateStreamRate();
+
+	/**
+	* Checks if every chunk of the stream in progress has been meshed and swapped in. Only used by the loader thread.
+	*/
+	bool IsStreamFinished();
+
+	/**
+	* Requests loads for the chunks coming into range of the camera that aren't loaded. Only the
+	* slabs of the range that changed are scanned. Requests already queued are rescored, or dropped
+	* if their chunk left the range, as they reach the front of the queue. Only used by the loader thread.
 	*/
 	void UpdateVisibleList();
 
+	/**
+	* Requests loads for the chunks in a range that aren't loaded. Only used by the loader thread.
+	* @param Min, Max - Corners of the range, inclusive. Nothing is requested if Min is past Max on any axis.
+	* @param ViewCenter - Chunk position of the camera.
+	* @param ViewFrustum - View frustum in chunk space.
+	*/
+	void RequestLoads(const Vector3i& Min, const Vector3i& Max, const Vector3i& ViewCenter, const FFrustum& ViewFrustum);
+
+	/**
+	* Queues rebuilds for loaded chunks whose level of detail changed as the camera moved,
+	* along with their neighbors. Only the shells of chunks around the camera that can have
+	* crossed a level's distance are checked. Only used by the loader thread.
+	* @param ViewCenter - Chunk position of the camera.
+	*/
+	void UpdateLodLevels(const Vector3i& ViewCenter);
+
+	/**
+	* Queues a rebuild for a chunk and its neighbors if it isn't meshed at its level of detail.
+	* Chunks keeping cells coarser than their level are queued to be loaded again instead.
+	* Only used by the loader thread.
+	*/
+	void UpdateLodLevel(const int32_t Index);
+
+	/**
+	* Checks if a loaded chunk keeps cells coarser than its level of detail, and is waiting to be
+	* loaded again. Its blocks can't be read at its level until it is. Only used by the loader thread.
+	*/
+	bool IsAwaitingReload(const int32_t Index) const;
+
+	/**
+	* Checks if a chunk is inside the range the load queue was last filled for. Only used by the loader thread.
+	*/
+	bool IsInLoadRange(const Vector3i& ChunkPosition) const;
+
+	/**
+	* Gets the level of detail a chunk is meshed at. Only used by the loader thread.
+	*/
+	uint32_t LodLevel(const Vector3i& ChunkPosition) const;
+
 	/**
 	* Updates the render list.
 	*/
@@ -157,24 +463,162 @@ private:
 	*/
 	int32_t ChunkIndex(int32_t X, int32_t Y, int32_t Z) const;
 
+	/**
+	* Gets the index of the chunk holding a block. Slots being given another chunk's blocks
+	* don't hold it. The slot can be claimed by the loader thread right after, so only use
+	* this where a stale index is harmless.
+	* @param Position - World position of the block.
+	* @return The index into the chunks array, or -1 if the block is outside of the
+	*         world or its chunk is not loaded.
+	*/
+	int32_t LoadedChunkIndex(const Vector3i& Position) const;
+
+	/**
+	* Gets the index of the chunk holding a block and locks its blocks, so its slot keeps the
+	* chunk until the lock is released. Used to read and edit blocks from the main thread.
+	* @param Position - World position of the block.
+	* @param LockOut - Set to the chunk's block lock if the chunk is loaded.
+	* @return The index into the chunks array, or -1 if the block is outside of the
+	*         world or its chunk is not loaded.
+	*/
+	int32_t LockLoadedChunk(const Vector3i& Position, std::unique_lock<std::recursive_mutex>& LockOut) const;
+
+	/**
+	* Sets the dimensions of the chunk ring from the view distance.
+	*/
+	void UpdateRingSize();
+
+	/**
+	* Adds a chunk to the rebuild list if it holds blocks and is not already in it. Chunks waiting
+	* for their neighbors are left out, as they are meshed once the neighbors load. mRebuildListMutex must be held.
+	*/
+	void AddToRebuildList(const int32_t Index);
+
+	/**
+	* Adds the chunks next to a changed block to the rebuild list when the block is on
+	* their border. mRebuildListMutex must be held.
+	* @param Position - World position of the block.
+	*/
+	void AddBorderNeighborsToRebuildList(const Vector3i& Position);
+
+	/**
+	* Marks the border of a neighbor toward a chunk to be rebuilt, and adds the neighbor to
+	* the rebuild list. mRebuildListMutex must be held.
+	* @param Offset - Position of the neighbor from the chunk. Each axis is -1, 0 or 1.
+	*/
+	void RebuildBorder(const int32_t Neighbor, const Vector3i& Offset);
+
+	/**
+	* Gets the index of a chunk's neighbor if the neighbor's blocks are loaded. Only used by the loader thread.
+	* @param ChunkPosition - Position of the chunk.
+	* @param Face - NormalID of the chunk's face toward the neighbor.
+	* @return The index into the chunks array, or -1 if the neighbor is not loaded.
+	*/
+	int32_t LoadedNeighborIndex(const Vector3i& ChunkPosition, const uint32_t Face) const;
+
+	/**
+	* Gets the index of a chunk's neighbor across a face, edge or corner if the neighbor's blocks are loaded.
+	* @param Offset - Position of the neighbor from the chunk.
+	*/
+	int32_t LoadedNeighborIndex(const Vector3i& ChunkPosition, const Vector3i& Offset) const;
+
+	/**
+	* Checks if a chunk position is inside the world.
+	*/
+	bool IsInWorld(const Vector3i& ChunkPosition) const;
+
+	/**
+	* Reads the blocks around a chunk from its loaded neighbors, across each face, edge and
+	* corner. Only used by the loader thread. Blocks of neighbors at a different level of
+	* detail are left open, so the chunks on both sides close their border. So are the blocks
+	* of neighbors waiting to be loaded again.
+	* @param Lod - Level of detail of the chunk.
+	* @return True if no part of the apron is waiting on a neighbor inside the world to be loaded.
+	*/
+	bool GatherApron(const Vector3i& ChunkPosition, const uint32_t Lod, FChunk::Apron& ApronOut) const;
+
+	/**
+	* Gets the mesh cache to rebuild a chunk with. Only used by the loader thread.
+	* @param IsApronComplete - If every neighbor of the chunk has been gathered. Meshes built
+	*                          while neighbors are still loading are not cached.
+	* @return The mesh cache of the chunk's region, or nullptr if meshes aren't cached.
+	*/
+	FMeshCacheFile* GetMeshCacheFile(const Vector3i& ChunkPosition, const bool IsApronComplete);
+
+	/**
+	* Queues rebuilds for the neighbors of a newly loaded chunk that may have faces covered or occluded by it.
+	* Only used by the loader thread.
+	* Neighbors loaded in the same batch gather the blocks of this chunk themselves, so they aren't rebuilt.
+	*/
+	void RebuildNeighbors(const int32_t Index, const Vector3i& ChunkPosition);
+
+	/**
+	* Checks if a newly loaded chunk's first mesh should wait for its neighbors. With meshes
+	* cached, a chunk meshed before its neighbors load is built twice and its first mesh can't
+	* be cached, so it is left empty until its apron is complete. Only used by the loader thread.
+	*/
+	bool MustWaitForApron(const Vector3i& ChunkPosition) const;
+
+	/**
+	* Checks if any neighbor of a chunk is inside the load range but not loaded yet. Only used by the loader thread.
+	*/
+	bool IsApronPending(const Vector3i& ChunkPosition) const;
+
+	/**
+	* Adds a chunk waiting for its neighbors to the rebuild list once none of them are still to be loaded.
+	* Only used by the loader thread.
+	*/
+	void RebuildIfApronLoaded(const int32_t Index);
+
 private:
 	FWorldFileSystem      mFileSystem;
 	FChunk*               mChunks;        // All world chunks
-	Vector4i*             mChunkPositions;
+	Vector4i*             mChunkPositions; // Positions of the swapped in meshes. Only used by the main thread.
+	Vector4i*             mLoadedChunkPositions; // Positions of the blocks held by each chunk. Only written by the loader
+	                                             // thread while the slot is flagged as being replaced.
+	std::atomic<uint8_t>* mChunkStates;   // ChunkState of each slot, with its flags
 	std::vector<uint32_t> mRenderList;    // Index list of chunks to render
-	std::queue<Vector3i>  mLoadList;      // Index list of chunks to be loaded
+	std::vector<LoadRequest> mLoadQueue;  // Heap of chunks to be loaded. Only used by the loader thread.
 	std::deque<uint32_t>  mRebuildList;   // Index list of chunks to be rebuilt
-	std::deque<Vector3i>  mBufferSwapQueue;
+	TMPSCRing<uint32_t>   mBufferSwapRing; // Indices of chunks with meshes to swap in
+	std::atomic<uint32_t> mQueuedSwaps;    // Entries in the swap ring
 	std::thread           mLoaderThread;
 	std::mutex            mRebuildListMutex;
-	std::mutex            mBufferSwapMutex;
+	std::mutex            mLoaderMutex;   // Guards the view given to the loader thread and its sleep
+	std::condition_variable mLoaderWake;
 	std::atomic_bool      mNeedsToRefreshVisibleList;
 	std::atomic_bool      mMustShutdown;
+	std::atomic_bool      mHibernateChunks;
+	std::atomic_bool      mCacheMeshes;
+
+	// Streaming data. Only used by the loader thread, other than the stream rate.
+	FChunkWorkerPool       mWorkerPool;
+	std::vector<StreamJob> mStreamJobs;
+	std::vector<StreamJob> mNextStreamJobs; // Batch read from disk while mStreamJobs is meshed
+	uint64_t               mStreamStart;    // System time the stream in progress started at, or 0
+	uint32_t               mStreamedChunks; // Chunks loaded by the stream in progress
+	Vector3i               mVisibleMin;     // Range of chunks the load queue was last filled for. Every chunk in
+	Vector3i               mVisibleMax;     // it that isn't loaded is either queued or in a load batch.
+	uint32_t               mQueueView;      // Incremented for each view given to the loader thread
+	Vector3i               mQueueCenter;    // Camera chunk and frustum of the current view
+	FFrustum               mQueueFrustum;
+	std::vector<int32_t>   mApronWaitList;  // Chunks flagged as waiting for their neighbors. Entries are dropped once the flag is cleared.
+	std::atomic<float>     mStreamRate;
+	FStreamGovernor        mStreamGovernor;
 
 	// Rendering data
 	Vector3i mLastCameraChunk;
+	Vector3f mLastViewDirection; // Direction the camera faced when the view was last refreshed
+	Vector3i mViewCenter;        // Camera chunk of the last view given to the loader thread
+	int32_t  mLoadDistance;      // View distance of the last view given to the loader thread
+	FFrustum mViewFrustum;       // Chunk space view frustum of the last view given to the loader thread
+	Vector3i mLodCenter; // Camera chunk the levels of detail were last chosen around. Only used by the loader thread.
+	std::atomic<uint32_t> mLodDistances[FChunk::LOD_LEVELS - 1];
+	std::atomic_bool      mLodDistancesChanged; // Set until the loader thread moves chunks to their levels for new distances
 	int32_t mWorldSize;
 	int32_t mViewDistance;
+	int32_t mHorizontalShift; // Log2 of the chunk ring size along x and z
+	int32_t mVerticalShift;   // Log2 of the chunk ring size along y
 
 	// Physics Data
 	FPhysicsSystem* mPhysicsSystem;
@@ -183,9 +627,13 @@ public:
 	// Block events
 	using BlockSetEventType = void(*)(Vector3i, FBlockTypes::BlockID);
 	using BlockDestroyEventType = void(*)(Vector3i, FBlockTypes::BlockID);
+	using BlocksChangedEventType = void(*)(const std::vector<FBlockChange>&);
+	using EditRejectedEventType = void(*)(Vector3i);
 
 	TEvent<Vector3i, FBlockTypes::BlockID> mOnBlockDestroy;
 	TEvent<Vector3i, FBlockTypes::BlockID> mOnBlockSet;
+	TEvent<const std::vector<FBlockChange>&> mOnBlocksChanged;
+	TEvent<Vector3i> mOnEditRejected; // Chunk space position of a chunk that refused an edit, as it only keeps its cells
 };
 
 
@@ -195,15 +643,11 @@ inline int32_t FChunkManager::ChunkIndex(Vector3i Position) const
 		Position.y >= 0 && Position.y < mWorldSize &&
 		Position.z >= 0 && Position.z < mWorldSize)
 
-	// Normalize the position
-	const int32_t HorizontalBounds = 2 * mViewDistance + 1;
-	const int32_t VerticalBounds = mViewDistance + 1;
-	const Vector3i PositionToIndex{ HorizontalBounds, HorizontalBounds * HorizontalBounds, 1 };
+	// Ring dimensions are powers of two, so positions wrap with masks
+	const int32_t HorizontalMask = (1 << mHorizontalShift) - 1;
+	const int32_t VerticalMask = (1 << mVerticalShift) - 1;
 
-	// Bit shift for mod operation
-	Position = Vector3i{ Position.x % HorizontalBounds, Position.y % VerticalBounds, Position.z % HorizontalBounds };
-
-	return Vector3i::Dot(Position, PositionToIndex);
+	return ((Position.y & VerticalMask) << (2 * mHorizontalShift)) | ((Position.x & HorizontalMask) << mHorizontalShift) | (Position.z & HorizontalMask);
 }
 
 inline int32_t FChunkManager::ChunkIndex(int32_t X, int32_t Y, int32_t Z) const 
@@ -213,5 +657,22 @@ inline int32_t FChunkManager::ChunkIndex(int32_t X, int32_t Y, int32_t Z) const
 
 inline uint32_t FChunkManager::ChunkCount() const
 {
-	return (2 * mViewDistance + 1) * (mViewDistance + 1) * (2 * mViewDistance + 1);
+	return 1u << (2 * mHorizontalShift + mVerticalShift);
+}
+
+inline int32_t FChunkManager::LoadedChunkIndex(const Vector3i& Position) const
+{
+	// Negative positions wrap to large unsigned values
+	const uint32_t BlockWorldSize = (uint32_t)mWorldSize << FChunkGeometry::EDGE_SHIFT;
+	if ((uint32_t)Position.x >= BlockWorldSize || (uint32_t)Position.y >= BlockWorldSize || (uint32_t)Position.z >= BlockWorldSize)
+		return -1;
+
+	const Vector3i ChunkPosition{ Position.x >> FChunkGeometry::EDGE_SHIFT, Position.y >> FChunkGeometry::EDGE_SHIFT, Position.z >> FChunkGeometry::EDGE_SHIFT };
+	const int32_t Index = ChunkIndex(ChunkPosition);
+
+	// Positions are only written while the slot is flagged as being replaced
+	if (mChunkStates[Index] & ChunkState::Replacing)
+		return -1;
+
+	return (mLoadedChunkPositions[Index] == Vector4i(ChunkPosition, 1)) ? Index : -1;
 }
\ No newline at end of file
@@ -7,11 +7,22 @@
 #include "GL\glew.h"
 #include "Math\Vector3.h"
 #include "Common.h"
+#include "BlockTypes.h"
+#include "ChunkGeometry.h"
 
 
 /**
 * A double buffered mesh used to construct and render
-* chunks.
+* chunks. Meshes are built as a list of quads. Quads are either read
+* straight from a storage buffer by the vertex shader, or expanded to
+* vertices and indices when they are uploaded. Chunks with the same
+* blocks can share the same render data.
+* \n
+* Quads facing the same direction are kept together, so faces that can't be
+* seen from the camera can be left out of a draw.
+* \n
+* Ambient occlusion is baked into each corner of a quad by the mesher and
+* darkens the block color.
 */
 class FChunkMesh
 {
@@ -21,94 +32,200 @@ public:
 	struct FrontBuffer{};
 
 	/**
-	* Compressed rendering data for a chunk vertex.
+	* Compressed rendering data for a chunk vertex. Positions are relative to the chunk,
+	* which is placed in the world by the chunk origin uniform when it is drawn.
 	*/
 	struct Vertex
 	{
-		Vector3f Position;
-		uint8_t  BlockType;
-		uint8_t  NormalID;
+		uint32_t PositionNormal; // x, y and z in 7 bits each, a 3 bit NormalID, then 2 bits of occlusion. The top 6 bits are unused.
+		uint32_t BlockData;      // Block type in the low 16 bits. The high bits are unused.
 	};
+	static_assert(sizeof(Vertex) == 8, "Chunk vertices should be packed into 8 bytes.");
+
+	/**
+	* Compressed data for a quad of faces. The quad's first corner is stored like a vertex
+	* position. It spans Width cells along u = (d + 1) % 3 and Height cells along
+	* v = (d + 2) % 3, where d is the axis of its NormalID.
+	*/
+	struct Quad
+	{
+		uint32_t PositionNormal; // Same as Vertex::PositionNormal for the first corner, but with the occlusion of all 4 corners
+		uint32_t SizeBlock;      // Block type in the low 16 bits, then width and height in 7 bits each
+	};
+	static_assert(sizeof(Quad) == 8, "Chunk quads should be packed into 8 bytes.");
+
+	// Bits for each axis of a vertex position. Positions range from 0 to CHUNK_SIZE inclusive.
+	static const uint32_t POSITION_BITS = 7;
+	static const uint32_t POSITION_MASK = (1 << POSITION_BITS) - 1;
+	static const uint32_t NORMAL_SHIFT = 3 * POSITION_BITS;
+	static const uint32_t NORMAL_MASK = 7;
+	static const uint32_t SIZE_SHIFT = 16;
+
+	// Ambient occlusion from 0, fully occluded, to 3, open. Quads hold one value for each corner in QUAD_CORNERS order.
+	static const uint32_t OCCLUSION_SHIFT = NORMAL_SHIFT + 3;
+	static const uint32_t OCCLUSION_BITS = 2;
+	static const uint32_t OCCLUSION_MASK = (1 << OCCLUSION_BITS) - 1;
+	static const uint32_t UNOCCLUDED = 0xFF;
+	static_assert(FChunkGeometry::CHUNK_SIZE <= POSITION_MASK, "Vertex positions must fit in POSITION_BITS.");
+
+	// Meshes with no more vertices than this are drawn with 16 bit indices
+	static const uint32_t MAX_SHORT_INDEX_VERTICES = 1 << 16;
+
+	// Corners of a quad in vertex order, as steps along u and v
+	static const int32_t QUAD_CORNERS[4][2];
+
+	// Vertices of the two triangles of a quad. Back faces are wound the other way.
+	static const uint32_t QUAD_INDICES[2][6];
+
+	// Bit set of every NormalID, for drawing all faces
+	static const uint32_t ALL_FACES = 0x3F;
 
 public:
 	static GLuint BufferUsageMode;
 
-	using VertexData = std::vector<Vertex>;
-	using VertexDataPtr = std::unique_ptr<VertexData>;
+	// If quads are pulled by the vertex shader instead of being expanded to vertices.
+	// Must be set before any chunk meshes are created.
+	static bool UseQuadPulling;
 
+	using VertexData = std::vector<Vertex>;
 	using IndexData = std::vector<uint32_t>;
-	using IndexDataPtr = std::unique_ptr<IndexData>;
+
+	using QuadData = std::vector<Quad>;
+
+	/**
+	* Quads of a mesh and the GL buffers they are uploaded to. Buffers are created the
+	* first time the data is swapped in, and deleted by the GL thread once no mesh uses it.
+	*/
+	struct RenderData
+	{
+		RenderData();
+		~RenderData();
+
+		/**
+		* Clears the quads and releases uploaded buffers so the data can be built again.
+		* The quad capacity is kept.
+		*/
+		void Reset();
+
+		/**
+		* Finds the quads facing each direction. Quads must be grouped by NormalID.
+		*/
+		void FindFaceRanges();
+
+		QuadData Quads;
+		uint32_t FaceStarts[6]; // First quad of each NormalID
+		uint32_t FaceCounts[6]; // Number of quads of each NormalID
+		GLuint   Buffers[2];    // Only used by the GL thread
+		GLenum   IndexType;     // Type of the uploaded indices when quads aren't pulled
+		bool     IsUploaded;
+	};
+
+	using RenderDataPtr = std::shared_ptr<RenderData>;
 
 public:
 	FChunkMesh();
 	~FChunkMesh();
 
 	/**
-	* Add vertex data to the active buffer. This is uncompressed vertex
-	* position data to be used this physics.
+	* Packs a chunk vertex.
+	* @param X, Y, Z - Position of the vertex within the chunk.
+	* @param NormalID - Direction the face is facing.
+	* @param BlockType - Type of the block the face belongs to.
+	* @param Occlusion - Ambient occlusion of the vertex.
 	*/
-	void AddVertexData(VertexDataPtr Vertices);
+	static Vertex PackVertex(const int32_t X, const int32_t Y, const int32_t Z, const uint32_t NormalID, const FBlockTypes::BlockID BlockType, const uint32_t Occlusion = OCCLUSION_MASK);
 
 	/**
-	* Add index data to the active buffer.
+	* Gets the position of a vertex within its chunk.
 	*/
-	void AddIndexData(IndexDataPtr Indices);
+	static Vector3i UnpackPosition(const Vertex& PackedVertex);
 
 	/**
-	* Render this mesh using the active buffer.
+	* Packs a quad of faces.
+	* @param Position - First corner of the quad within the chunk.
+	* @param Width - Cells covered along u.
+	* @param Height - Cells covered along v.
+	* @param NormalID - Direction the faces are facing.
+	* @param BlockType - Type of the block the faces belong to.
+	* @param Occlusion - Ambient occlusion of each corner, OCCLUSION_BITS each in QUAD_CORNERS order.
 	*/
-	void Render(GLenum RenderMode = GL_TRIANGLES);
+	static Quad PackQuad(const Vector3i& Position, const uint32_t Width, const uint32_t Height, const uint32_t NormalID, const FBlockTypes::BlockID BlockType, const uint32_t Occlusion = UNOCCLUDED);
 
 	/**
-	* Swap the active buffer with the back buffer.
+	* Gets the direction a quad is facing.
 	*/
-	void SwapBuffer();
+	static uint32_t GetNormalID(const Quad& PackedQuad);
 
 	/**
-	* Clear data held by the inactive vertex and index
-	* buffers.
+	* Gets the ambient occlusion of a corner of a quad.
+	* @param Corner - Index into QUAD_CORNERS.
 	*/
-	void ClearBackBuffer();
+	static uint32_t GetOcclusion(const Quad& PackedQuad, const uint32_t Corner);
+
+	/**
+	* Checks if a quad should be split along its other diagonal, from corner 1 to 3. Quads are split
+	* between the corners that are least occluded together so occlusion isn't smeared along the diagonal.
+	*/
+	static bool IsSplitFlipped(const Quad& PackedQuad);
+
+	/**
+	* Gets the corners of a quad within its chunk, in the order of QUAD_CORNERS.
+	*/
+	static void QuadCorners(const Quad& PackedQuad, Vector3i CornersOut[4]);
+
+	/**
+	* Add render data to the inactive buffer.
+	*/
+	void AddRenderData(RenderDataPtr Data);
 
 	/**
-	* Get vertex position data for the inactive mesh buffer.
+	* Render this mesh using the active buffer.
+	* @param Faces - Bit set of the NormalIDs of the faces to draw.
 	*/
-	const Vertex* GetVertexData(BackBuffer) const;
+	void Render(GLenum RenderMode = GL_TRIANGLES, const uint32_t Faces = ALL_FACES);
 
 	/**
-	* Get vertex position data for the active mesh buffer.
+	* Swap the active buffer with the back buffer. Render data is uploaded here if
+	* no other mesh has uploaded it. Vertices and indices are built from the quads
+	* when quads aren't pulled.
+	* @return Bytes uploaded to the GPU.
 	*/
-	const Vertex* GetVertexData(FrontBuffer) const;
+	uint32_t SwapBuffer();
 
 	/**
-	* Get the vertex count for the inactive mesh buffer.
+	* Clear data held by the inactive buffer. Cleared buffers share one empty render data.
 	*/
-	uint32_t GetVertexCount(BackBuffer) const;
+	void ClearBackBuffer();
 
 	/**
-	* Get the vertex count for the active mesh buffer.
+	* Get quad data for the inactive mesh buffer.
 	*/
-	uint32_t GetVertexCount(FrontBuffer) const;
+	const Quad* GetQuadData(BackBuffer) const;
 
 	/**
-	* Get index data for the inactive mesh buffer.
+	* Get quad data for the active mesh buffer.
 	*/
-	const uint32_t* GetIndexData(BackBuffer) const;
+	const Quad* GetQuadData(FrontBuffer) const;
 
 	/**
-	* Get index data for the active mesh buffer.
+	* Get the quad count for the inactive mesh buffer.
 	*/
-	const uint32_t* GetIndexData(FrontBuffer) const;
+	uint32_t GetQuadCount(BackBuffer) const;
 
 	/**
-	* Get the index count for the inavtive mesh buffer.
+	* Get the quad count for the active mesh buffer.
 	*/
-	uint32_t GetIndexCount(BackBuffer) const;
+	uint32_t GetQuadCount(FrontBuffer) const;
 
+private:
 	/**
-	* Get the index count for the active mesh buffer.
+	* Creates the GL data for render data. Must be called on the GL thread.
+	* @return Bytes uploaded.
 	*/
-	uint32_t GetIndexCount(FrontBuffer) const;
+	static uint32_t Upload(RenderData& Data);
+
+	// Render data held by cleared buffers
+	static const RenderDataPtr EmptyData;
 
 private:
 	struct Buffer
@@ -121,52 +238,67 @@ private:
 	};
 
 private:
-	VertexDataPtr   mVertices[2];
-	IndexDataPtr    mIndices[2];
+	RenderDataPtr   mData[2];
 
-	// GL buffers held by this object
+	// Vertex array for the active buffer. Pulled quads are kept in the render data's vertex buffer.
 	GLuint mVertexArray;
-	GLuint mBuffers[2];
 
 	std::atomic_bool mActiveBuffer;
 };
 
-inline const FChunkMesh::Vertex* FChunkMesh::GetVertexData(FChunkMesh::BackBuffer) const
+inline FChunkMesh::Vertex FChunkMesh::PackVertex(const int32_t X, const int32_t Y, const int32_t Z, const uint32_t NormalID, const FBlockTypes::BlockID BlockType, const uint32_t Occlusion)
+{
+	Vertex PackedVertex;
+	PackedVertex.PositionNormal = (uint32_t)X | ((uint32_t)Y << POSITION_BITS) | ((uint32_t)Z << (2 * POSITION_BITS)) | (NormalID << NORMAL_SHIFT) | (Occlusion << OCCLUSION_SHIFT);
+	PackedVertex.BlockData = BlockType;
+	return PackedVertex;
+}
+
+inline Vector3i FChunkMesh::UnpackPosition(const Vertex& PackedVertex)
+{
+	const uint32_t Packed = PackedVertex.PositionNormal;
+	return Vector3i{ (int32_t)(Packed & POSITION_MASK), (int32_t)((Packed >> POSITION_BITS) & POSITION_MASK), (int32_t)((Packed >> (2 * POSITION_BITS)) & POSITION_MASK) };
+}
+
+inline FChunkMesh::Quad FChunkMesh::PackQuad(const Vector3i& Position, const uint32_t Width, const uint32_t Height, const uint32_t NormalID, const FBlockTypes::BlockID BlockType, const uint32_t Occlusion)
 {
-	return mVertices[!mActiveBuffer]->data();
+	Quad PackedQuad;
+	PackedQuad.PositionNormal = PackVertex(Position.x, Position.y, Position.z, NormalID, BlockType, Occlusion).PositionNormal;
+	PackedQuad.SizeBlock = (uint32_t)BlockType | (Width << SIZE_SHIFT) | (Height << (SIZE_SHIFT + POSITION_BITS));
+	return PackedQuad;
 }
 
-inline uint32_t FChunkMesh::GetVertexCount(FChunkMesh::BackBuffer) const
+inline uint32_t FChunkMesh::GetNormalID(const Quad& PackedQuad)
 {
-	return mVertices[!mActiveBuffer]->size();
+	return (PackedQuad.PositionNormal >> NORMAL_SHIFT) & NORMAL_MASK;
 }
 
-inline const uint32_t* FChunkMesh::GetIndexData(FChunkMesh::BackBuffer) const
+inline uint32_t FChunkMesh::GetOcclusion(const Quad& PackedQuad, const uint32_t Corner)
 {
-	return mIndices[!mActiveBuffer]->data();
+	return (PackedQuad.PositionNormal >> (OCCLUSION_SHIFT + Corner * OCCLUSION_BITS)) & OCCLUSION_MASK;
 }
 
-inline uint32_t FChunkMesh::GetIndexCount(FChunkMesh::BackBuffer) const
+inline bool FChunkMesh::IsSplitFlipped(const Quad& PackedQuad)
 {
-	return mIndices[!mActiveBuffer]->size();
+	return GetOcclusion(PackedQuad, 0) + GetOcclusion(PackedQuad, 2) < GetOcclusion(PackedQuad, 1) + GetOcclusion(PackedQuad, 3);
 }
 
-inline const FChunkMesh::Vertex* FChunkMesh::GetVertexData(FChunkMesh::FrontBuffer) const
+inline const FChunkMesh::Quad* FChunkMesh::GetQuadData(FChunkMesh::BackBuffer) const
 {
-	return mVertices[mActiveBuffer]->data();
+	return mData[!mActiveBuffer]->Quads.data();
 }
 
-inline uint32_t FChunkMesh::GetVertexCount(FChunkMesh::FrontBuffer) const
+inline uint32_t FChunkMesh::GetQuadCount(FChunkMesh::BackBuffer) const
 {
-	return mVertices[mActiveBuffer]->size();
+	return mData[!mActiveBuffer]->Quads.size();
 }
 
-inline const uint32_t* FChunkMesh::GetIndexData(FChunkMesh::FrontBuffer) const
+inline const FChunkMesh::Quad* FChunkMesh::GetQuadData(FChunkMesh::FrontBuffer) const
 {
-	return mIndices[mActiveBuffer]->data();
+	return mData[mActiveBuffer]->Quads.data();
 }
 
-inline uint32_t FChunkMesh::GetIndexCount(FChunkMesh::FrontBuffer) const
+inline uint32_t FChunkMesh::GetQuadCount(FChunkMesh::FrontBuffer) const
 {
-	return mIndices[mActiveBuffer]->size();
+	return mData[mActiveBuffer]->Quads.size();
 }
\ No newline at end of file
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+
+/**
+* Pool of worker threads that run a stage of chunk jobs at once. Run() hands out
+* job indices to the workers and the calling thread, and returns once every job of
+* the stage is done, so the caller can safely read the results of one stage before
+* starting the next.
+* \n
+* Dispatch() starts a stage without waiting for it, so the calling thread can do work of
+* its own, such as file I/O, while the workers run the jobs. Wait() then joins in on the
+* jobs that are left and returns once the stage is done.
+* \n
+* Workers give back their cached block pages and thread slots when the pool is stopped.
+*/
+class FChunkWorkerPool
+{
+public:
+	/**
+	* Constructs a pool without workers. Jobs run on the calling thread until it is started.
+	*/
+	FChunkWorkerPool();
+
+	/**
+	* Stops the workers.
+	*/
+	~FChunkWorkerPool();
+
+	FChunkWorkerPool(const FChunkWorkerPool& Other) = delete;
+	FChunkWorkerPool& operator=(const FChunkWorkerPool& Other) = delete;
+
+	/**
+	* Starts the worker threads. The pool must be stopped.
+	* @param WorkerCount - Number of threads to start, not counting the thread calling Run().
+	*/
+	void Start(const uint32_t WorkerCount);
+
+	/**
+	* Waits for the workers to finish and exit.
+	*/
+	void Stop();
+
+	/**
+	* Runs jobs on the workers and the calling thread, and waits for all of them to finish.
+	* Jobs are given out in index order, but may finish in any order. Must only be called
+	* by one thread at a time.
+	* @param JobCount - Number of jobs to run.
+	* @param Job - Called once with each index from 0 to JobCount - 1.
+	*/
+	void Run(const uint32_t JobCount, const std::function<void(uint32_t)>& Job);
+
+	/**
+	* Starts running jobs on the workers and returns without waiting for them. Wait() must be
+	* called before the next stage is started or the results are read. Stages too small to
+	* wake the workers for are left for Wait() to run.
+	* @param JobCount - Number of jobs to run.
+	* @param Job - Called once with each index from 0 to JobCount - 1. Copied by the pool.
+	*/
+	void Dispatch(const uint32_t JobCount, const std::function<void(uint32_t)>& Job);
+
+	/**
+	* Runs the jobs left in the dispatched stage on the calling thread, and waits for the workers to finish theirs.
+	*/
+	void Wait();
+
+	/**
+	* Gets the number of threads that run jobs, including the thread calling Run().
+	*/
+	uint32_t GetThreadCount() const;
+
+	/**
+	* Gets the number of workers to start so every core has a thread, leaving one
+	* core for the main thread and one for the thread calling Run().
+	*/
+	static uint32_t DefaultWorkerCount();
+
+private:
+	/**
+	* Runs the jobs of each stage after LastStage until the pool is stopped.
+	*/
+	void WorkerLoop(uint32_t LastStage);
+
+	/**
+	* Takes and runs jobs of the current stage until none are left.
+	*/
+	void RunJobs();
+
+private:
+	std::vector<std::thread>                mWorkers;
+	std::mutex                              mMutex;
+	std::condition_variable                 mStageReady;
+	std::condition_variable                 mStageDone;
+	std::function<void(uint32_t)>           mJob;      // Job of the current stage
+	uint32_t                                mJobCount;
+	std::atomic<uint32_t>                   mNextJob;
+	uint32_t                                mStage;    // Incremented for each call to Run()
+	uint32_t                                mBusyWorkers;
+	bool                                    mIsWorkerStage; // If the workers were woken for the current stage
+	bool                                    mMustStop;
+};
+
+inline uint32_t FChunkWorkerPool::GetThreadCount() const
+{
+	return (uint32_t)mWorkers.size() + 1;
+}
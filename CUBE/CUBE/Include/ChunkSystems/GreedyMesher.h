@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "BlockTypes.h"
+#include "ChunkGeometry.h"
+
+/**
+* Finds the quads of a chunk mesh with bit masks. Each block type in a chunk gets a 64 bit mask
+* for every row of blocks along each axis. The faces of a layer are a row masked with the
+* row next to it. Quads are widened along a row with bit scans and grown by masking the rows
+* after it.
+* \n
+* Builds the same quads in the same order as the per-cell greedy mesher by Mikola Lysenko
+* (http://0fps.net/2012/06/30/meshing-in-a-minecraft-game/). Faces are built between blocks of
+* different types. Each quad starts at the first open cell of its layer in row order, widens
+* along u, then grows along v.
+* \n
+* Ambient occlusion is found for each corner of a face from the three blocks next to it in the
+* slice in front of the face. Faces only join a quad when all of their corners match, so
+* quads with baked occlusion are the ones the per-cell mesher would build if it compared
+* occlusion with types. Where the slice reaches past the chunk, blocks are sampled from the
+* neighbor faces, edges and corners, so faces at the chunk's edges match those of the chunk beside them.
+*/
+class FGreedyMesher
+{
+public:
+	static const int32_t CHUNK_SIZE = FChunkGeometry::CHUNK_SIZE;
+	static_assert(CHUNK_SIZE <= 64, "Rows of blocks are kept in 64 bit masks.");
+
+	/**
+	* A quad of faces of one block type. Cells are named by the two axes after the
+	* face's axis, u = (d + 1) % 3 and v = (d + 2) % 3.
+	*/
+	struct FQuad
+	{
+		uint8_t              U;      // First cell of the quad
+		uint8_t              V;
+		uint8_t              Width;  // Cells along u
+		uint8_t              Height; // Cells along v
+		uint8_t              Occlusion; // 2 bits for each corner at (0, 0), (0, 1), (1, 1) and (1, 0) along u and v. 3 is open.
+		FBlockTypes::BlockID Type;
+	};
+
+	// Occlusion of quads that aren't next to any blocks
+	static const uint8_t UNOCCLUDED = 0xFF;
+
+public:
+	/**
+	* Constructs a mesher with no blocks.
+	*/
+	FGreedyMesher();
+
+	/**
+	* Builds the row masks of a chunk. Must be called before BuildLayer().
+	* @param Blocks - BLOCKS_PER_CHUNK block IDs in block index order.
+	* @param Neighbors - Blocks just outside each face, indexed like FChunk::Apron.
+	* @param Edges - Blocks just outside each edge, indexed like FChunk::Apron. Only used for occlusion.
+	* @param Corners - Blocks just outside each corner, indexed like FChunk::Apron. Only used for occlusion.
+	*/
+	void SetBlocks(const FBlockTypes::BlockID* Blocks, const FBlockTypes::BlockID (*Neighbors)[CHUNK_SIZE * CHUNK_SIZE],
+	               const FBlockTypes::BlockID (*Edges)[CHUNK_SIZE], const FBlockTypes::BlockID* Corners);
+
+	/**
+	* Sets if ambient occlusion is found for the quads built. When it isn't, quads are
+	* left unoccluded. On by default.
+	*/
+	void SetOcclusion(const bool IsEnabled);
+
+	/**
+	* Finds the quads of a layer of faces.
+	* @param Face - NormalID of the faces. Faces toward the positive end of an axis are even.
+	* @param Depth - Position along the face's axis of the blocks the faces belong to.
+	* @param QuadsOut - Quads are appended in the order their first cells are found.
+	*/
+	void BuildLayer(const uint32_t Face, const int32_t Depth, std::vector<FQuad>& QuadsOut);
+
+	/**
+	* Gets the bytes reserved by the mesher's buffers. Buffers are kept between chunks, so
+	* this only grows when a chunk needs more room than the chunks before it.
+	*/
+	size_t GetCapacity() const;
+
+private:
+	// Per type, rows along u for each slice of each axis, then rows of each neighbor face
+	static const uint32_t AXIS_ROWS = CHUNK_SIZE * CHUNK_SIZE;
+	static const uint32_t ROWS_PER_TYPE = 3 * AXIS_ROWS + 6 * CHUNK_SIZE;
+
+	/**
+	* Gets the mask of a row of blocks along u.
+	* @param Type - Index of the block type in mTypes, or the number of types for every solid block.
+	* @param Axis - The axis the rows are sliced along.
+	* @param Depth - Position of the slice along the axis.
+	* @param Row - Position of the row along v.
+	*/
+	uint64_t& SliceRow(const uint32_t Type, const int32_t Axis, const int32_t Depth, const int32_t Row)
+	{
+		return mRows[Type * ROWS_PER_TYPE + (Axis * CHUNK_SIZE + Depth) * CHUNK_SIZE + Row];
+	}
+
+	/**
+	* Gets the mask of a row of neighbor blocks outside of a face.
+	*/
+	uint64_t& NeighborRow(const uint32_t Type, const uint32_t Face, const int32_t Row)
+	{
+		return mRows[Type * ROWS_PER_TYPE + 3 * AXIS_ROWS + Face * CHUNK_SIZE + Row];
+	}
+
+	/**
+	* Finds the solid blocks of the slice in front of a layer, and the neighbor blocks around it.
+	* @param Face - NormalID of the layer's faces.
+	* @param Next - Position of the slice along the face's axis. May be just outside the chunk.
+	*/
+	void FindOccluders(const uint32_t Face, const int32_t Next);
+
+	/**
+	* Finds the occlusion of the corners of a face from the occluders of its layer.
+	* @param U, V - Cell of the face.
+	*/
+	uint8_t FaceOcclusion(const int32_t U, const int32_t V) const;
+
+	/**
+	* Checks if an occluder holds a solid block. Cells may be one step outside the slice.
+	*/
+	uint32_t IsOccluder(const int32_t U, const int32_t V) const;
+
+	/**
+	* Open faces of a type in a layer that share the same corner occlusion.
+	*/
+	struct FFaceGroup
+	{
+		uint32_t Type;      // Index of the block type in mTypes
+		uint8_t  Occlusion;
+	};
+
+private:
+	std::vector<FBlockTypes::BlockID> mTypes;        // Block types in the chunk other than air
+	std::vector<uint64_t>             mRows;         // ROWS_PER_TYPE masks for each type, then for every block that isn't air
+	std::vector<uint64_t>             mFaceRows;     // Open faces of each type in the layer being built
+	std::vector<uint32_t>             mLayerTypes;   // Types with open faces in the layer being built
+	std::vector<FBlockTypes::BlockID> mLinearBlocks; // Blocks in linear order for layouts without contiguous rows
+
+	std::vector<FFaceGroup>           mGroups;       // Face groups of the layer being built
+	std::vector<uint64_t>             mGroupRows;    // Open faces of each group
+
+	uint64_t mOccluderRows[CHUNK_SIZE + 2]; // Solid blocks of the slice in front of the layer, for rows -1 to CHUNK_SIZE
+	uint64_t mOccluderEdges[2];             // Solid blocks just before and just after the rows along u, a bit for each row
+	uint32_t mOccluderCorners;              // Solid blocks past the slice along both u and v. Bit 1 is past the end of u and bit 2 past the end of v.
+	uint64_t mEdgeRows[12];                 // Solid blocks of each neighbor edge
+	uint32_t mCorners;                      // Solid blocks of the neighbor corners, a bit for each
+	bool     mIsOcclusionEnabled;
+};
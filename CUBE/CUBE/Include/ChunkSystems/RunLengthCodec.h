@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+
+#include "BlockTypes.h"
+#include "ChunkGeometry.h"
+
+/**
+* Run-length codec for chunk block data. Runs are found along z, rows are visited
+* in y, x order, and each run is a block ID followed by a length byte. This is the
+* format used by region files.
+* \n
+* Run boundaries are found 16 or 32 blocks at a time with SIMD compares, and runs are
+* decoded with wide stores. Neither direction allocates memory.
+*/
+namespace FRunLengthCodec
+{
+	// Size of each run in bytes
+	static const uint32_t RUN_SIZE = sizeof(FBlockTypes::BlockID) + sizeof(uint8_t);
+
+	// Max number of bytes written by Encode(), a run for every block
+	static const uint32_t MAX_ENCODED_SIZE = FChunkGeometry::BLOCKS_PER_CHUNK * RUN_SIZE;
+
+	// Number of blocks Decode() may write past the end of a chunk
+	static const uint32_t DECODE_PADDING = 16 / sizeof(FBlockTypes::BlockID);
+
+	/**
+	* Encodes the blocks of a chunk.
+	* @param Blocks - BLOCKS_PER_CHUNK block IDs in block index order.
+	* @param DataOut - Memory for at least MAX_ENCODED_SIZE bytes.
+	* @param SliceOffsetsOut - Optional memory for CHUNK_SIZE offsets to the first run of each y slice.
+	* @return The number of bytes written.
+	*/
+	uint32_t Encode(const FBlockTypes::BlockID* Blocks, uint8_t* DataOut, uint32_t* SliceOffsetsOut = nullptr);
+
+	/**
+	* Decodes the blocks of a chunk. Blocks past the end of the data are set to air.
+	* @param Data - RLE block data.
+	* @param DataSize - Size of the data in bytes.
+	* @param BlocksOut - Memory for BLOCKS_PER_CHUNK + DECODE_PADDING block IDs.
+	*/
+	void Decode(const uint8_t* Data, const uint32_t DataSize, FBlockTypes::BlockID* BlocksOut);
+
+	/**
+	* Decodes a single y slice of a chunk. Blocks past the end of the data are set to air.
+	* @param SliceData - Encoded data starting at the first run of the slice.
+	* @param DataEnd - End of the encoded chunk data.
+	* @param BlocksOut - Memory for CHUNK_SIZE * CHUNK_SIZE + DECODE_PADDING block IDs. Rows along z
+	*                    are placed one after another in x order.
+	*/
+	void DecodeSlice(const uint8_t* SliceData, const uint8_t* DataEnd, FBlockTypes::BlockID* BlocksOut);
+
+	/**
+	* Reads a single block from encoded data without decoding the rest of the chunk.
+	* @param SliceData - Encoded data starting at the first run of the y slice holding the block.
+	* @param X - X position of the block in the chunk.
+	* @param Z - Z position of the block in the chunk.
+	*/
+	FBlockTypes::BlockID ReadBlock(const uint8_t* SliceData, const int32_t X, const int32_t Z);
+}
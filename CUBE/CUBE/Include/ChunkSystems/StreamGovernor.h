@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+
+/**
+* Keeps chunk streaming within the frame budget. Each frame, mesh uploads are capped by
+* a byte and a time budget. The byte budget shrinks while frames run over the target
+* frame time and grows back while there is headroom.
+* \n
+* Frames that stay over budget also throttle loading, by shrinking the batches the loader
+* thread loads. If view distance scaling is enabled, the view distance is then stepped down
+* until frames are back on budget, and stepped back up once there is headroom again.
+* \n
+* Only the load batch size can be read from other threads. Everything else is used by the main thread.
+*/
+class FStreamGovernor
+{
+public:
+	/**
+	* Constructs a governor with a target of 60 frames per second.
+	*/
+	FStreamGovernor();
+
+	FStreamGovernor(const FStreamGovernor& Other) = delete;
+	FStreamGovernor& operator=(const FStreamGovernor& Other) = delete;
+
+	/**
+	* Sets the time each frame should take in seconds.
+	*/
+	void SetTargetFrameTime(const float Seconds);
+
+	/**
+	* Sets if the view distance is stepped down while frames stay over budget. Off by default.
+	*/
+	void SetViewScaling(const bool Enabled);
+
+	/**
+	* Sets the most the view distance can be stepped down by. Steps already taken past it are given back.
+	*/
+	void SetMaxViewDistanceCut(const uint32_t Steps);
+
+	/**
+	* Updates the budgets with the time the last frame took. Called once per frame.
+	* @param FrameSeconds - Real time the last frame took.
+	*/
+	void Update(const float FrameSeconds);
+
+	/**
+	* Starts the upload budget of a frame.
+	*/
+	void BeginUploads();
+
+	/**
+	* Records an upload done during the frame.
+	* @param Bytes - Bytes uploaded to the GPU.
+	*/
+	void AddUpload(const uint32_t Bytes);
+
+	/**
+	* Checks if the frame has spent its upload budget. The upload that spends it is allowed
+	* to go over, so at least one mesh is uploaded each frame.
+	*/
+	bool IsUploadBudgetSpent() const;
+
+	/**
+	* Gets the number of chunks the loader thread should load at once. Can be called from any thread.
+	* @param MaxBatchSize - Batch size when loading isn't throttled.
+	*/
+	uint32_t GetLoadBatchSize(const uint32_t MaxBatchSize) const;
+
+	/**
+	* Gets the number of chunks the view distance is stepped down by.
+	*/
+	uint32_t GetViewDistanceCut() const;
+
+	/**
+	* Gets the smoothed time frames are taking in seconds.
+	*/
+	float GetAverageFrameTime() const;
+
+	/**
+	* Gets the bytes each frame can upload.
+	*/
+	uint32_t GetUploadByteBudget() const;
+
+	/**
+	* Gets the bytes uploaded during the last frame.
+	*/
+	uint32_t GetUploadedBytes() const;
+
+private:
+	float                 mTargetFrameTime;
+	float                 mAverageFrameTime;
+	int32_t               mPressureFrames;   // Frames in a row over budget, or negative for frames in a row with headroom
+	uint32_t              mUploadByteBudget;
+	uint64_t              mUploadCycleBudget;
+	uint64_t              mUploadStart;      // System time the frame's uploads started at
+	uint32_t              mUploadedBytes;    // Bytes uploaded so far this frame
+	std::atomic<uint32_t> mLoadThrottle;     // Load batches are halved for each step
+	uint32_t              mViewDistanceCut;
+	uint32_t              mMaxViewDistanceCut;
+	bool                  mScaleViewDistance;
+};
+
+inline uint32_t FStreamGovernor::GetViewDistanceCut() const
+{
+	return mViewDistanceCut;
+}
+
+inline float FStreamGovernor::GetAverageFrameTime() const
+{
+	return mAverageFrameTime;
+}
+
+inline uint32_t FStreamGovernor::GetUploadByteBudget() const
+{
+	return mUploadByteBudget;
+}
+
+inline uint32_t FStreamGovernor::GetUploadedBytes() const
+{
+	return mUploadedBytes;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "Chunk.h"
+
+class FChunkManager;
+
+/**
+* Reads blocks of the world from a position that can be moved around. The chunk
+* holding the current block is cached, so stepping to neighboring blocks only looks up a
+* chunk again when a chunk boundary is crossed. Useful for raycasts and other scans
+* that visit blocks close to each other.
+* \n
+* Cursors hold the block lock of the chunk they are in, so blocks are read without locking
+* each one. Loader threads wait for the cursor to leave before changing that chunk.
+* \n
+* Cursors should only be used on the game thread and not kept across frames, as the chunk
+* manager may load a different chunk into the cached chunk's place.
+*/
+class FVoxelCursor
+{
+public:
+	/**
+	* Constructs a cursor at a block.
+	* @param ChunkManager - The world to read blocks from.
+	* @param Position - World position of the block.
+	*/
+	FVoxelCursor(const FChunkManager& ChunkManager, const Vector3i& Position);
+
+	FVoxelCursor(FVoxelCursor&& Other);
+
+	FVoxelCursor(const FVoxelCursor& Other) = delete;
+	FVoxelCursor& operator=(const FVoxelCursor& Other) = delete;
+
+	/**
+	* Moves the cursor to any block.
+	*/
+	void MoveTo(const Vector3i& Position);
+
+	/**
+	* Moves the cursor along x. Steps of 1 or -1 are the cheapest.
+	*/
+	void StepX(const int32_t Step);
+
+	/**
+	* Moves the cursor along y. Steps of 1 or -1 are the cheapest.
+	*/
+	void StepY(const int32_t Step);
+
+	/**
+	* Moves the cursor along z. Steps of 1 or -1 are the cheapest.
+	*/
+	void StepZ(const int32_t Step);
+
+	/**
+	* Retrieves the type of block at the cursor. Blocks outside of the world or
+	* in chunks that are not loaded are air.
+	*/
+	FBlockTypes::BlockID GetBlock() const;
+
+	/**
+	* Gets the world position of the cursor.
+	*/
+	const Vector3i& GetPosition() const { return mPosition; }
+
+	/**
+	* Checks if the block at the cursor is in a loaded chunk.
+	*/
+	bool IsLoaded() const { return mChunk != nullptr; }
+
+private:
+	/**
+	* Finds the chunk holding the current position and moves the block lock to it.
+	*/
+	void FindChunk();
+
+private:
+	const FChunkManager*                   mChunkManager;
+	const FChunk*                          mChunk;         // Chunk holding the cursor, nullptr if it is not loaded
+	std::unique_lock<std::recursive_mutex> mChunkLock;     // Block lock of mChunk
+	Vector3i                               mPosition;
+	Vector3i                               mLocalPosition; // Position of the cursor within mChunk
+};
+
+inline void FVoxelCursor::StepX(const int32_t Step)
+{
+	mPosition.x += Step;
+	mLocalPosition.x += Step;
+
+	// Negative positions wrap to large unsigned values
+	if ((uint32_t)mLocalPosition.x >= (uint32_t)FChunk::CHUNK_SIZE)
+		FindChunk();
+}
+
+inline void FVoxelCursor::StepY(const int32_t Step)
+{
+	mPosition.y += Step;
+	mLocalPosition.y += Step;
+
+	if ((uint32_t)mLocalPosition.y >= (uint32_t)FChunk::CHUNK_SIZE)
+		FindChunk();
+}
+
+inline void FVoxelCursor::StepZ(const int32_t Step)
+{
+	mPosition.z += Step;
+	mLocalPosition.z += Step;
+
+	if ((uint32_t)mLocalPosition.z >= (uint32_t)FChunk::CHUNK_SIZE)
+		FindChunk();
+}
+
+inline FBlockTypes::BlockID FVoxelCursor::GetBlock() const
+{
+	return mChunk ? mChunk->GetBlockLocked(mLocalPosition) : (FBlockTypes::BlockID)FBlock::AIR_BLOCK_ID;
+}
@@ -1,4 +1,5 @@
 #pragma once
 
 #define WIN_ALIGN(Size) __declspec(align(Size))
+#define THREAD_LOCAL __declspec(thread)
 #define FOR(i, Num) for(int32_t i = 0; i < Num; i++)
\ No newline at end of file
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <memory>
+
+#include "Misc\Assertions.h"
+
+template <typename ElementType>
+/**
+* Bounded lock-free queue that any number of threads can push to and a single thread pops
+* from. Each cell holds a sequence number that tells producers when the cell is free and the
+* consumer when its element has been written, so no thread ever waits on a lock.
+* \n
+* @tparam ElementType - Type of the queued elements. Should be cheap to copy.
+*/
+class TMPSCRing
+{
+public:
+	/**
+	* Constructs a ring with no capacity. Init() must be called before it is used.
+	*/
+	TMPSCRing();
+
+	TMPSCRing(const TMPSCRing& Other) = delete;
+	TMPSCRing& operator=(const TMPSCRing& Other) = delete;
+
+	/**
+	* Sets the capacity of the ring and empties it. Must not be called while other threads use the ring.
+	* @param Capacity - Number of elements the ring can hold. Rounded up to a power of two.
+	*/
+	void Init(const uint32_t Capacity);
+
+	/**
+	* Adds an element to the back of the ring. Can be called from any thread.
+	* @return False if the ring is full.
+	*/
+	bool Push(const ElementType& Element);
+
+	/**
+	* Takes the element at the front of the ring. Must only be called by the consumer thread.
+	* @return False if the ring is empty.
+	*/
+	bool Pop(ElementType& ElementOut);
+
+	/**
+	* Gets the number of elements the ring can hold.
+	*/
+	uint32_t GetCapacity() const;
+
+private:
+	struct Cell
+	{
+		std::atomic<uint32_t> Sequence; // Position the cell can be pushed at, or one past the position it was pushed at
+		ElementType           Element;
+	};
+
+private:
+	std::unique_ptr<Cell[]> mCells;
+	uint32_t                mMask;
+	std::atomic<uint32_t>   mTail; // Next position to push at
+	uint32_t                mHead; // Next position to pop from. Only used by the consumer.
+};
+
+template <typename ElementType>
+TMPSCRing<ElementType>::TMPSCRing()
+	: mCells()
+	, mMask(0)
+	, mTail()
+	, mHead(0)
+{
+	mTail = 0;
+}
+
+template <typename ElementType>
+void TMPSCRing<ElementType>::Init(const uint32_t Capacity)
+{
+	uint32_t Size = 1;
+	while (Size < Capacity)
+		Size <<= 1;
+
+	mCells.reset(new Cell[Size]);
+	mMask = Size - 1;
+
+	// Each cell starts free for the first position that maps to it
+	for (uint32_t i = 0; i < Size; i++)
+		mCells[i].Sequence.store(i, std::memory_order_relaxed);
+
+	mTail.store(0, std::memory_order_relaxed);
+	mHead = 0;
+}
+
+template <typename ElementType>
+bool TMPSCRing<ElementType>::Push(const ElementType& Element)
+{
+	ASSERT(mCells);
+
+	uint32_t Position = mTail.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		Cell& Target = mCells[Position & mMask];
+		const int32_t Difference = (int32_t)(Target.Sequence.load(std::memory_order_acquire) - Position);
+
+		if (Difference == 0)
+		{
+			// Claim the position, then publish the element to the consumer
+			if (mTail.compare_exchange_weak(Position, Position + 1, std::memory_order_relaxed))
+			{
+				Target.Element = Element;
+				Target.Sequence.store(Position + 1, std::memory_order_release);
+				return true;
+			}
+		}
+		else if (Difference < 0)
+		{
+			// The cell still holds an element from a lap ago
+			return false;
+		}
+		else
+		{
+			// Another producer took the position
+			Position = mTail.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+template <typename ElementType>
+bool TMPSCRing<ElementType>::Pop(ElementType& ElementOut)
+{
+	ASSERT(mCells);
+
+	Cell& Target = mCells[mHead & mMask];
+	if ((int32_t)(Target.Sequence.load(std::memory_order_acquire) - (mHead + 1)) < 0)
+		return false;
+
+	ElementOut = Target.Element;
+
+	// Free the cell for the position one lap ahead
+	Target.Sequence.store(mHead + mMask + 1, std::memory_order_release);
+	mHead++;
+	return true;
+}
+
+template <typename ElementType>
+inline uint32_t TMPSCRing<ElementType>::GetCapacity() const
+{
+	return mMask + 1;
+}
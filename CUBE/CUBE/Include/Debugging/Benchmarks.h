@@ -0,0 +1,42 @@
+#pragma once
+
+/**
+* Micro benchmarks for engine systems. Results are printed with FDebug::PrintF.
+* Benchmarks block the calling thread until they finish.
+*/
+namespace FBenchmarks
+{
+	/**
+	* Measures allocate and free throughput of a mutex guarded FPoolAllocator and
+	* FConcurrentPoolAllocator with 1, 2, 4, 8 and 16 threads using the same pool.
+	*/
+	void PoolContention();
+
+	/**
+	* Measures RLE loading and unloading, greedy meshing and random block edits of a
+	* terrain chunk with the FChunkGeometry the game was built with. Must be called
+	* from a thread with an OpenGL context.
+	*/
+	void ChunkLayout();
+
+	/**
+	* Compares FGreedyMesher with the per-cell greedy mesher it replaced on a terrain chunk,
+	* and checks that both build the same quads for every layer. Also times FGreedyMesher with
+	* baked ambient occlusion.
+	*/
+	void GreedyMesher();
+
+	/**
+	* Measures how many chunks per second the chunk worker pool loads, meshes and unloads
+	* with 1, 2, 4 and so on threads, up to one for each core. Must be called from a thread
+	* with an OpenGL context.
+	*/
+	void ChunkStreaming();
+
+	/**
+	* Compares the throughput of FRunLengthCodec with per-run scalar loops on the chunks
+	* of a saved world, and checks that both produce the same bytes as the world files.
+	* @param WorldName - Name of a world in the Worlds directory.
+	*/
+	void RunLengthCodec(const wchar_t* WorldName);
+}
@@ -58,6 +58,12 @@ public:
 	* Retrieves the size of this file.
 	*/
 	virtual uint32_t GetFileSize() const = 0;
+
+	/**
+	* Ends the file at the current file pointer, discarding any data after it.
+	* @return True if the file was truncated.
+	*/
+	virtual bool Truncate() = 0;
 };
 
 /**
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "FileIO\GenericFile.h"
+#include "Math\Vector3.h"
+#include "ChunkSystems\ChunkMesh.h"
+
+/**
+* Sidecar file of a region that keeps the quads built for its chunks, so chunks that
+* haven't changed since they were meshed can read their mesh instead of building it again.
+* Each chunk has an entry for every level of detail, keyed by the hash of the blocks and
+* neighbor blocks the mesh was built from. A chunk that is rewritten hashes differently, so
+* its old meshes are never read again.
+* \n
+* Chunks far enough to be coarsened also keep their cells, so they can be loaded without
+* reading and merging their blocks. Cells are removed whenever the chunk's blocks are written.
+* \n
+* Files sit next to their region file with a .vgm extension, and are recreated when they
+* were written by a different MESH_VERSION or chunk geometry. Blocks left behind by meshes
+* that outgrew them are reused by later meshes, and free space at the end of the file is
+* truncated. Meshes and cells can be read and written from any number of threads.
+*/
+class FMeshCacheFile
+{
+public:
+	// Must be bumped whenever the mesher builds different quads from the same blocks, or the file layout changes
+	static const uint32_t MESH_VERSION = 2;
+
+public:
+	/**
+	* Constructs an unbound mesh cache file.
+	*/
+	FMeshCacheFile();
+
+	/**
+	* Loads the mesh cache of a region, creating it if it doesn't exist or is out of date.
+	* @param WorldName - The name of the world the region is a part of.
+	* @param RegionPosition - The position of the region.
+	* @return True if the file was loaded successfully.
+	*/
+	bool Load(const wchar_t* WorldName, const Vector3i& RegionPosition);
+
+	/**
+	* Checks if the file has been loaded.
+	*/
+	bool IsLoaded() const;
+
+	/**
+	* Checks if the mesh cache of a region has been created.
+	*/
+	static bool Exists(const wchar_t* WorldName, const Vector3i& RegionPosition);
+
+	/**
+	* Reads the mesh of a chunk if it was built from the same blocks.
+	* @param ChunkPosition - Chunk space position of the chunk.
+	* @param Lod - Level of detail of the mesh.
+	* @param Hash - Hash of the blocks and neighbor blocks the mesh is built from.
+	* @param QuadsOut - Replaced with the quads of the mesh. Only changed if the mesh is found.
+	* @return True if a mesh with the same hash was found.
+	*/
+	bool ReadMesh(const Vector3i& ChunkPosition, const uint32_t Lod, const uint64_t Hash, FChunkMesh::QuadData& QuadsOut);
+
+	/**
+	* Writes the mesh of a chunk, replacing the last mesh written for its level of detail.
+	* @param ChunkPosition - Chunk space position of the chunk.
+	* @param Lod - Level of detail of the mesh.
+	* @param Hash - Hash of the blocks and neighbor blocks the mesh was built from. Must not be 0.
+	* @param Quads - Quads of the mesh.
+	* @return False if the mesh could not be written. The chunk's last mesh is not read again.
+	*/
+	bool WriteMesh(const Vector3i& ChunkPosition, const uint32_t Lod, const uint64_t Hash, const FChunkMesh::QuadData& Quads);
+
+	/**
+	* Reads the cells a chunk was coarsened to, if it was coarsened to a level no coarser than a limit.
+	* @param ChunkPosition - Chunk space position of the chunk.
+	* @param MaxLod - Coarsest level of detail to read cells at.
+	* @param CellDataOut - Replaced with the cells, in the format read by FChunk::LoadCells(). Only changed if they are found.
+	* @param LodOut - Set to the level of detail of the cells if they are found.
+	* @return True if the chunk's cells were found.
+	*/
+	bool ReadCells(const Vector3i& ChunkPosition, const uint32_t MaxLod, std::vector<uint8_t>& CellDataOut, uint32_t& LodOut);
+
+	/**
+	* Writes the cells a chunk was coarsened to, replacing its last cells.
+	* @param ChunkPosition - Chunk space position of the chunk.
+	* @param Lod - Level of detail of the cells.
+	* @param CellData - Cells written by FChunk::Coarsen().
+	* @return False if the cells could not be written. The chunk's last cells are not read again.
+	*/
+	bool WriteCells(const Vector3i& ChunkPosition, const uint32_t Lod, const std::vector<uint8_t>& CellData);
+
+	/**
+	* Removes the cells of a chunk, such as when its blocks have changed.
+	*/
+	void RemoveCells(const Vector3i& ChunkPosition);
+
+	/**
+	* Gets the number of meshes found and not found by ReadMesh() in every mesh cache file.
+	*/
+	static uint32_t GetHits();
+	static uint32_t GetMisses();
+
+private:
+	struct FileHeader
+	{
+		uint32_t Magic;
+		uint32_t Version;    // MESH_VERSION of the mesher that wrote the file
+		uint32_t ChunkSize;
+		uint32_t QuadSize;
+	};
+
+	/**
+	* Lookup table entry for a mesh or cells. Data is stored in blocks after the lookup table.
+	* Data that outgrows its block is moved to a free block, or a new block at the end of the file.
+	*/
+	struct LookupEntry
+	{
+		uint64_t Hash;     // 0 if nothing has been written. Cell entries hold 1 once written.
+		uint32_t Offset;   // Start of the data's block in the file
+		uint32_t Size;     // Bytes of data
+		uint32_t Capacity; // Bytes that fit in the block
+		uint32_t Lod;      // Level of detail of cells. Unused by meshes, which have an entry per level.
+	};
+	static_assert(sizeof(LookupEntry) == 24, "Mesh cache entries should be packed into 24 bytes.");
+
+	/**
+	* Gets the path of the mesh cache of a region.
+	*/
+	static std::wstring GetFilepath(const wchar_t* WorldName, const Vector3i& RegionPosition);
+
+	/**
+	* Gets the lookup table index of a chunk's mesh at a level of detail, or of its cells with FChunk::LOD_LEVELS.
+	*/
+	static uint32_t GetTableIndex(const Vector3i& ChunkPosition, const uint32_t Entry);
+
+	/**
+	* Writes the data of an entry, moving it to a larger block if it doesn't fit. mFileMutex must be held.
+	* @return False if the data could not be written. The entry's last data is not read again.
+	*/
+	bool WriteData(const uint32_t Index, const uint64_t Hash, const uint32_t Lod, const uint8_t* Data, const uint32_t Size);
+
+	/**
+	* Reads or writes an entry of the lookup table. Writes return false if the entry could not be written.
+	*/
+	void ReadEntry(const uint32_t Index, LookupEntry& EntryOut);
+	bool WriteEntry(const uint32_t Index, const LookupEntry& Entry);
+
+	/**
+	* Writes zeros at the current position of the file.
+	* @return False if the zeros could not be written.
+	*/
+	bool WritePadding(uint32_t Size);
+
+	/**
+	* Finds the space between the blocks of the lookup table and adds it to the free blocks.
+	* Space after the last block is truncated.
+	*/
+	void FindFreeBlocks();
+
+	/**
+	* Takes the start of the first free block with room for a number of bytes, or the end of the file.
+	*/
+	uint32_t AllocateBlock(const uint32_t Size);
+
+	/**
+	* Adds a block to the free blocks, merging it with the free blocks beside it.
+	* Blocks at the end of the file are truncated.
+	*/
+	void FreeBlock(uint32_t Offset, uint32_t Size);
+
+private:
+	std::unique_ptr<IFileHandle> mFile;
+	std::map<uint32_t, uint32_t> mFreeBlocks; // Size in bytes of each free block by its offset
+	std::mutex                   mFileMutex;  // Held while the file or free blocks are used
+};
+
+inline bool FMeshCacheFile::IsLoaded() const
+{
+	return mFile != nullptr;
+}
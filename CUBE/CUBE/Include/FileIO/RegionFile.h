@@ -3,6 +3,8 @@
 #include <cstdint>
 #include "Math\Vector3.h"
 #include "SystemResources\SystemFile.h"
+#include "ChunkSystems\ChunkGeometry.h"
+#include "ChunkSystems\BlockTypes.h"
 #include <memory>
 
 /**
@@ -47,20 +49,19 @@ public:
 	bool Load(const wchar_t* WorldName, const Vector3i& RegionPosition);
 
 	/**
-	* Retrieve info about a specific chunk.
+	* Retrieve the size of the data for a specific chunk.
 	* @param ChunkPosition - Position of the chunk within this region.
-	* @param SizeOut - To put the size, in bytes, of the data for the chunk.
-	* @param SectorOffsetOut - The sector offset for this chunks data.
+	* @return The size, in bytes, of the data for the chunk. 0 if the chunk is not in the file.
 	*/
-	void GetChunkDataInfo(const Vector3i& ChunkPosition, uint32_t& SizeOut, uint32_t& SectorOffsetOut);
+	uint32_t GetChunkDataSize(const Vector3i& ChunkPosition);
 
 	/**
 	* Retrieves the data for the layout of a chunk.
- 	* @param SectorOffset - The offset of the chunks sector. Can be retrieved from GetChunkDataInfo().
+ 	* @param ChunkPosition - Position of the chunk within this region.
 	* @param DataOut - To put the chunk data.
-	* @param DataSize - The size of this chunks data. Can be retrieved from GetChunkDataInfo().
+	* @param DataSize - The size of this chunks data. Can be retrieved from GetChunkDataSize().
 	*/
-	void GetChunkData(const uint32_t SectorOffset, uint8_t* DataOut, const uint32_t DataSize);
+	void GetChunkData(const Vector3i& ChunkPosition, uint8_t* DataOut, const uint32_t DataSize);
 
 	/**
 	* Writes data for a chunk to file.
@@ -73,20 +74,31 @@ public:
 public:
 	/**
 	* Lookup table entry for a chunk in the region file.
-	* If NumOfSectors is 0, then this chunk is currently not in the
-	* region file and needs to be appended.
+	* If NumOfSectors is 0, then this chunk either has no sectors in the
+	* region file and needs to be appended, or its data is small enough to
+	* be stored inline in the entry. Inline entries set INLINE_DATA_FLAG in Offset,
+	* with the data size in bits 16-17 and the data in bits 0-15.
 	*/
 	struct LookupEntry
 	{
 		uint32_t Offset : 24;       // Sector offset of a chunk
 		uint32_t NumOfSectors : 8;  // Number of sectors a chunk consumes
+
+		bool HasInlineData() const;
 	};
 
 	struct RegionData
 	{
-		static const uint32_t REGION_SIZE = 16;
+		// Each region spans 512 blocks on each axis, so a region holds 16 chunks of 32 blocks
+		static const uint32_t REGION_SIZE = 512 >> FChunkGeometry::EDGE_SHIFT;
 		static const uint32_t SECTOR_SIZE = 4096;
+		static const uint32_t INLINE_DATA_SIZE = 2;      // Max size of chunk data stored in the lookup table
+		static const uint32_t INLINE_DATA_FLAG = 1 << 23;
 		LookupEntry ChunkEntry[REGION_SIZE * REGION_SIZE * REGION_SIZE];
+		// Worst case RLE chunk data, a run for every block, must fit in the max sectors of an entry
+		static_assert(FChunkGeometry::BLOCKS_PER_CHUNK * (sizeof(FBlockTypes::BlockID) + 1) + 4 <= 255 * SECTOR_SIZE,
+			"Chunk data would not fit in a lookup entry.");
+
 		// Sectors will follow the lookup table.
 		// Each sector is 4KiB and contains RLE chunk data.
 		// Chunk data starts with 4 byte data size at the beginning
@@ -104,6 +116,12 @@ private:
 	*/
 	void RelocateAndAddChunkData(LookupEntry& RelocationEntry, const uint8_t* Data, const uint32_t DataSize);
 
+	/**
+	* Shifts all chunk data after an entry's sectors to the left, releasing the sectors. The file is
+	* truncated to the end of the shifted data and left positioned there. The entry itself is not modified.
+	*/
+	void RemoveChunkSectors(const LookupEntry& RemovedEntry);
+
 	uint32_t GetTableIndex(Vector3i Position);
 
 private:
@@ -111,6 +129,11 @@ private:
 	std::unique_ptr<IFileHandle> mRegionFile;
 };
 
+inline bool FRegionFile::LookupEntry::HasInlineData() const
+{
+	return NumOfSectors == 0 && (Offset & RegionData::INLINE_DATA_FLAG) != 0;
+}
+
 inline uint32_t FRegionFile::GetTableIndex(Vector3i Position)
 {
 	const Vector3i PositionToIndex{ (int32_t)FRegionFile::RegionData::REGION_SIZE, (int32_t)FRegionFile::RegionData::REGION_SIZE * FRegionFile::RegionData::REGION_SIZE, 1 };
@@ -4,6 +4,7 @@
 #include <unordered_map>
 
 #include "RegionFile.h"
+#include "MeshCacheFile.h"
 #include "Math\Vector3.h"
 
 class FWorldFileSystem
@@ -68,16 +69,26 @@ public:
 	void GetChunkData(const Vector3i& ChunkPosition, std::vector<uint8_t>& DataOut);
 
 	/**
-	* Writes data for a chunk within the currently loaded world.
+	* Writes data for a chunk within the currently loaded world. Cells kept for the chunk in
+	* its region's mesh cache are removed, as they no longer match its blocks.
 	* @param ChunkPosition - The chunk space position of the chunk.
 	* @param Data - Buffer containing chunk data.
 	*/
 	void WriteChunkData(const Vector3i& ChunkPosition, const std::vector<uint8_t>& Data);
 
+	/**
+	* Gets the mesh cache of the region holding a chunk. The cache is loaded the first time
+	* it is needed. The chunk's region file must be referenced.
+	* @param ChunkPosition - The chunk space position of the chunk.
+	* @return The region's mesh cache, or nullptr if it couldn't be loaded.
+	*/
+	FMeshCacheFile* GetMeshCacheFile(const Vector3i& ChunkPosition);
+
 private:
 	struct RegionFileRecord
 	{
 		FRegionFile File;
+		FMeshCacheFile MeshFile;
 		uint32_t ReferenceCount;
 	};
 
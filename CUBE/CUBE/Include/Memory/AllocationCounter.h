@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+* Counts heap allocations made through the global operator new, and through Bullet once
+* it is given Allocate() and Free(). Only allocations made by threads inside a counting
+* scope are counted, so the allocations of one path, like chunk streaming, can be followed
+* no matter which code makes them.
+*/
+namespace FAllocationCounter
+{
+	/**
+	* Counts the allocations of the calling thread until it goes out of scope. Scopes can be nested.
+	*/
+	class FScope
+	{
+	public:
+		FScope();
+		~FScope();
+
+		FScope(const FScope& Other) = delete;
+		FScope& operator=(const FScope& Other) = delete;
+
+	private:
+		bool mWasCounting;
+	};
+
+	/**
+	* Gets the number of allocations made inside counting scopes.
+	*/
+	uint32_t GetAllocations();
+
+	/**
+	* Allocates from the heap like the global operator new, without throwing.
+	* Matches the allocation hook of btAlignedAllocSetCustom().
+	*/
+	void* Allocate(size_t Size);
+
+	/**
+	* Frees memory from Allocate(). Matches the free hook of btAlignedAllocSetCustom().
+	*/
+	void Free(void* Data);
+}
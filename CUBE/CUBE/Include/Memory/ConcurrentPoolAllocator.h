@@ -0,0 +1,409 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include "Misc/Assertions.h"
+#include "MemoryUtil.h"
+#include "Common.h"
+
+#include <algorithm>
+
+/**
+* Assigns each thread a small index that can be used to look up per-thread
+* data without thread local storage in every object. Slots are claimed on first
+* use and should be released by threads that exit before the program does, so
+* the slot can be given to a new thread.
+*/
+namespace FThreadSlot
+{
+	// Max number of threads that can hold a slot at once
+	static const int32_t MAX_THREADS = 64;
+
+	// Returned when every slot is taken
+	static const int32_t NO_SLOT = -1;
+
+	/**
+	* Gets the slot of the calling thread, claiming one if needed.
+	* @return The slot index, or NO_SLOT if all slots are taken.
+	*/
+	int32_t Get();
+
+	/**
+	* Releases the slot of the calling thread.
+	*/
+	void Release();
+}
+
+template <uint32_t ElementSize, uint32_t BlockSize>
+/**
+* Thread safe, fixed capacity pool allocator. Each thread allocates from and frees to
+* its own magazine of cached elements. Magazines are refilled from and flushed to a shared
+* lock-free free list in batches, so threads only touch shared state once every BATCH_SIZE
+* operations. The shared free list is a stack of batches indexed by element, with a tag in
+* the head to guard against ABA.
+* \n
+* Address space for the pool is reserved up front and committed as elements are first used.
+* Threads that exit should call FlushThreadCache() on each pool they used, then FThreadSlot::Release().
+* \n
+* @param ElementSize The size of each allocation object.
+* @param BlockSize The max number of objects contained in the pool.
+*/
+class FConcurrentPoolAllocator
+{
+public:
+	// Number of elements cached by each thread
+	static const uint32_t MAGAZINE_SIZE = 64;
+
+	// Number of elements moved between a magazine and the shared free list at once
+	static const uint32_t BATCH_SIZE = MAGAZINE_SIZE / 2;
+
+	// Bytes committed at a time
+	static const uint32_t COMMIT_SIZE = 2 * 1024 * 1024;
+
+public:
+	/**
+	* Ctor
+	* Constructs a thread safe pool allocator with specified alignment.
+	* @param Alignment for each allocation
+	*/
+	FConcurrentPoolAllocator(uint32_t Alignment)
+		: mMagazines()
+		, mMemory(nullptr)
+		, mReservedMemory(nullptr)
+		, mElementStride(0)
+		, mPoolSize(0)
+		, mFreeListHead(PackHead(INVALID_INDEX, 0))
+		, mNextUnused(0)
+		, mCommittedElements(0)
+		, mCommittedBytes(0)
+		, mCommitMutex()
+		, mObjectsConstructed(0)
+	{
+		ASSERT(0 < BlockSize && "BlockSize must be larger that 0");
+		ASSERT(ElementSize >= sizeof(FreeNode) && "ElementSize must at least the size of a free list node.");
+		ASSERT((Alignment & (Alignment - 1)) == 0x0 && "Alignment must be a power of 2.");
+		ASSERT(Alignment <= COMMIT_SIZE);
+
+		// The byte gap between each allocation
+		mElementStride = (std::max(ElementSize, Alignment) + Alignment - 1) & ~(Alignment - 1);
+		mPoolSize = ((size_t)mElementStride * BlockSize + COMMIT_SIZE - 1) & ~((size_t)COMMIT_SIZE - 1);
+
+		// Reserve the whole pool, aligned to the commit size
+		mReservedMemory = static_cast<uint8_t*>(FMemory::ReserveVirtual(ReservedSize()));
+		ASSERT(mReservedMemory);
+
+		const uintptr_t AlignMask = COMMIT_SIZE - 1;
+		mMemory = reinterpret_cast<uint8_t*>((reinterpret_cast<uintptr_t>(mReservedMemory) + AlignMask) & ~AlignMask);
+		FMemory::AdviseHugePages(mMemory, mPoolSize);
+	}
+
+	~FConcurrentPoolAllocator()
+	{
+		ASSERT(mObjectsConstructed == 0 && "All objects should be back in the pool on destruction.");
+		FMemory::ReleaseVirtual(mReservedMemory, ReservedSize());
+	}
+
+	/**
+	* Allocate a new element from the memory pool.
+	* If the memory pool is empty, nullptr is returned.
+	*/
+	void* Allocate()
+	{
+		uint32_t Index = INVALID_INDEX;
+		const int32_t Slot = FThreadSlot::Get();
+
+		if (Slot != FThreadSlot::NO_SLOT)
+		{
+			Magazine& Cache = mMagazines[Slot];
+			if (Cache.Count == 0)
+				Refill(Cache);
+
+			if (Cache.Count == 0)
+				return nullptr;
+
+			Index = Cache.Elements[--Cache.Count];
+		}
+		else
+		{
+			// Threads without a slot use batches of one element
+			Index = PopBatch();
+			if (Index != INVALID_INDEX)
+			{
+				const uint32_t Rest = Node(Index)->NextInBatch.load(std::memory_order_relaxed);
+				if (Rest != INVALID_INDEX)
+					PushBatch(Rest, LastInBatch(Rest));
+			}
+			else
+			{
+				uint32_t Taken;
+				Index = TakeUnused(1, Taken);
+			}
+
+			if (Index == INVALID_INDEX)
+				return nullptr;
+		}
+
+		mObjectsConstructed.fetch_add(1, std::memory_order_relaxed);
+		return mMemory + (size_t)Index * mElementStride;
+	}
+
+	/**
+	* Release an object back into the memory pool.
+	*/
+	void Free(void* Data)
+	{
+		ASSERT(Data >= mMemory && Data < mMemory + (size_t)BlockSize * mElementStride);
+		ASSERT(mObjectsConstructed > 0);
+		mObjectsConstructed.fetch_sub(1, std::memory_order_relaxed);
+
+		const uint32_t Index = (uint32_t)((static_cast<uint8_t*>(Data) - mMemory) / mElementStride);
+		const int32_t Slot = FThreadSlot::Get();
+
+		if (Slot != FThreadSlot::NO_SLOT)
+		{
+			Magazine& Cache = mMagazines[Slot];
+			if (Cache.Count == MAGAZINE_SIZE)
+				FlushBatch(Cache, BATCH_SIZE);
+
+			Cache.Elements[Cache.Count++] = Index;
+		}
+		else
+		{
+			Node(Index)->NextInBatch.store(INVALID_INDEX, std::memory_order_relaxed);
+			PushBatch(Index, Index);
+		}
+	}
+
+	/**
+	* Returns all elements cached by the calling thread to the shared free list.
+	*/
+	void FlushThreadCache()
+	{
+		const int32_t Slot = FThreadSlot::Get();
+		if (Slot == FThreadSlot::NO_SLOT)
+			return;
+
+		Magazine& Cache = mMagazines[Slot];
+		while (Cache.Count > 0)
+			FlushBatch(Cache, std::min(Cache.Count, BATCH_SIZE));
+	}
+
+	/**
+	* Gets the max number of objects that can be
+	* allocated from the pool.
+	*/
+	uint32_t Capacity() const
+	{
+		return BlockSize;
+	}
+
+	/**
+	* Returns the number of objects in the pool
+	* that are constructed.
+	*/
+	uint32_t Size() const
+	{
+		return mObjectsConstructed.load(std::memory_order_relaxed);
+	}
+
+private:
+	// Disable copy ctor and copy assignment
+	FConcurrentPoolAllocator(const FConcurrentPoolAllocator& Other) = delete;
+	FConcurrentPoolAllocator& operator=(const FConcurrentPoolAllocator& Other) = delete;
+
+	static const uint32_t INVALID_INDEX = 0xFFFFFFFF;
+
+	/**
+	* Layout of a free element while it is in the shared free list.
+	*/
+	struct FreeNode
+	{
+		std::atomic<uint32_t> NextInBatch; // Next element of the same batch
+		std::atomic<uint32_t> NextBatch;   // First element of the next batch in the free list
+	};
+
+	/**
+	* Per-thread element cache. Aligned to avoid false sharing between threads.
+	*/
+	WIN_ALIGN(64)
+	struct Magazine
+	{
+		Magazine() : Count(0) {}
+		uint32_t Count;
+		uint32_t Elements[MAGAZINE_SIZE];
+	};
+
+	size_t ReservedSize() const
+	{
+		// An extra commit block is reserved so the pool can be aligned for huge pages
+		return mPoolSize + COMMIT_SIZE;
+	}
+
+	FreeNode* Node(const uint32_t Index) const
+	{
+		return reinterpret_cast<FreeNode*>(mMemory + (size_t)Index * mElementStride);
+	}
+
+	uint32_t LastInBatch(uint32_t Index) const
+	{
+		uint32_t Next = Node(Index)->NextInBatch.load(std::memory_order_relaxed);
+		while (Next != INVALID_INDEX)
+		{
+			Index = Next;
+			Next = Node(Index)->NextInBatch.load(std::memory_order_relaxed);
+		}
+		return Index;
+	}
+
+	/**
+	* The free list head packs a tag in the high 32 bits and the first element
+	* of the top batch in the low 32 bits. The tag changes with every update.
+	*/
+	static uint64_t PackHead(const uint32_t Index, const uint32_t Tag)
+	{
+		return ((uint64_t)Tag << 32) | Index;
+	}
+
+	/**
+	* Pushes a linked batch of elements onto the shared free list.
+	*/
+	void PushBatch(const uint32_t First, const uint32_t Last)
+	{
+		uint64_t OldHead = mFreeListHead.load(std::memory_order_relaxed);
+		uint64_t NewHead;
+		do
+		{
+			Node(First)->NextBatch.store((uint32_t)OldHead, std::memory_order_relaxed);
+			NewHead = PackHead(First, (uint32_t)(OldHead >> 32) + 1);
+		} while (!mFreeListHead.compare_exchange_weak(OldHead, NewHead, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	/**
+	* Pops a batch from the shared free list.
+	* @return The first element of the batch, or INVALID_INDEX if the list is empty.
+	*/
+	uint32_t PopBatch()
+	{
+		uint64_t OldHead = mFreeListHead.load(std::memory_order_acquire);
+		uint64_t NewHead;
+		do
+		{
+			const uint32_t First = (uint32_t)OldHead;
+			if (First == INVALID_INDEX)
+				return INVALID_INDEX;
+
+			// The element may be taken by another thread while this reads it. Its memory stays committed
+			// and the tag will have changed, so the exchange fails and this retries.
+			const uint32_t NextBatch = Node(First)->NextBatch.load(std::memory_order_relaxed);
+			NewHead = PackHead(NextBatch, (uint32_t)(OldHead >> 32) + 1);
+		} while (!mFreeListHead.compare_exchange_weak(OldHead, NewHead, std::memory_order_acquire, std::memory_order_acquire));
+
+		return (uint32_t)OldHead;
+	}
+
+	/**
+	* Moves the newest elements of a magazine to the shared free list as one batch.
+	*/
+	void FlushBatch(Magazine& Cache, const uint32_t Count)
+	{
+		const uint32_t Start = Cache.Count - Count;
+		for (uint32_t i = Start; i < Cache.Count - 1; i++)
+			Node(Cache.Elements[i])->NextInBatch.store(Cache.Elements[i + 1], std::memory_order_relaxed);
+		Node(Cache.Elements[Cache.Count - 1])->NextInBatch.store(INVALID_INDEX, std::memory_order_relaxed);
+
+		PushBatch(Cache.Elements[Start], Cache.Elements[Cache.Count - 1]);
+		Cache.Count = Start;
+	}
+
+	/**
+	* Refills an empty magazine with a batch from the shared free list, or with
+	* elements that have never been allocated.
+	*/
+	void Refill(Magazine& Cache)
+	{
+		uint32_t Index = PopBatch();
+		if (Index != INVALID_INDEX)
+		{
+			while (Index != INVALID_INDEX)
+			{
+				Cache.Elements[Cache.Count++] = Index;
+				Index = Node(Index)->NextInBatch.load(std::memory_order_relaxed);
+			}
+			return;
+		}
+
+		uint32_t Taken;
+		const uint32_t Start = TakeUnused(BATCH_SIZE, Taken);
+		if (Start == INVALID_INDEX)
+			return;
+
+		// Hand out lower addresses first
+		for (uint32_t i = Start + Taken; i > Start; i--)
+			Cache.Elements[Cache.Count++] = i - 1;
+	}
+
+	/**
+	* Takes elements that have never been allocated. Elements are only taken once their memory
+	* is committed, so none are lost when committing fails.
+	* @param MaxCount - Most elements to take. Fewer are taken at the end of the pool.
+	* @param TakenOut - Number of elements taken.
+	* @return The first element taken, or INVALID_INDEX if the pool is exhausted or memory could not be committed.
+	*/
+	uint32_t TakeUnused(const uint32_t MaxCount, uint32_t& TakenOut)
+	{
+		TakenOut = 0;
+		if (mNextUnused.load(std::memory_order_relaxed) >= BlockSize)
+			return INVALID_INDEX;
+
+		// Unused elements are only taken while the pool grows, so the lock is rarely contended
+		std::lock_guard<std::mutex> Lock(mCommitMutex);
+		const uint32_t Start = mNextUnused.load(std::memory_order_relaxed);
+		if (Start >= BlockSize)
+			return INVALID_INDEX;
+
+		// If only part of the range could be committed, take that part and leave the rest unused
+		uint32_t End = std::min(Start + MaxCount, BlockSize);
+		if (!Commit(End))
+		{
+			End = mCommittedElements.load(std::memory_order_relaxed);
+			if (End <= Start)
+				return INVALID_INDEX;
+		}
+
+		mNextUnused.store(End, std::memory_order_relaxed);
+		TakenOut = End - Start;
+		return Start;
+	}
+
+	/**
+	* Makes sure the first ElementCount elements are committed. mCommitMutex must be held.
+	* @return False if memory could not be committed.
+	*/
+	bool Commit(const uint32_t ElementCount)
+	{
+		while (mCommittedElements.load(std::memory_order_relaxed) < ElementCount)
+		{
+			if (!FMemory::CommitVirtual(mMemory + mCommittedBytes, COMMIT_SIZE))
+				return false;
+
+			mCommittedBytes += COMMIT_SIZE;
+			mCommittedElements.store((uint32_t)std::min<size_t>(mCommittedBytes / mElementStride, BlockSize), std::memory_order_release);
+		}
+
+		return true;
+	}
+
+private:
+	Magazine              mMagazines[FThreadSlot::MAX_THREADS];
+	uint8_t*              mMemory;             // Start of the first element
+	uint8_t*              mReservedMemory;     // Start of the reserved range
+	uint32_t              mElementStride;      // The byte gap between each allocation
+	size_t                mPoolSize;           // Usable bytes in the pool
+	std::atomic<uint64_t> mFreeListHead;       // Tagged head of the shared free list
+	std::atomic<uint32_t> mNextUnused;         // Next element that has never been allocated
+	std::atomic<uint32_t> mCommittedElements;  // Number of elements backed by committed memory
+	size_t                mCommittedBytes;
+	std::mutex            mCommitMutex;
+	std::atomic<uint32_t> mObjectsConstructed; // Number of active objects from the pool
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <cstddef>
 
 #define ALIGNED_ALLOC(Alignment) \
 	void* operator new(size_t Size) { return FMemory::AllocateAligned(Size, (Alignment)); }  \
@@ -41,4 +42,39 @@ namespace FMemory
 	* @param Data to be freed.
 	*/
 	void FreeAligned(void* Data);
+
+	/**
+	* Reserves a range of virtual address space without committing any
+	* physical memory to it. The range must be committed with FMemory::CommitVirtual
+	* before it is used and released with FMemory::ReleaseVirtual.
+	* @param Bytes Size of the range to reserve.
+	* @return Start of the reserved range, or nullptr if the reservation failed.
+	*/
+	void* ReserveVirtual(const size_t Bytes);
+
+	/**
+	* Commits physical memory to part of a reserved range. Committed memory is zeroed.
+	* @param Address Start of the range to commit. Must be page aligned.
+	* @param Bytes Size of the range to commit.
+	* @return True if the memory was committed.
+	*/
+	bool CommitVirtual(void* Address, const size_t Bytes);
+
+	/**
+	* Releases a range reserved with FMemory::ReserveVirtual.
+	* @param Address Start of the reserved range.
+	* @param Bytes Size of the reserved range.
+	*/
+	void ReleaseVirtual(void* Address, const size_t Bytes);
+
+	/**
+	* Hints that a reserved range should be backed by huge pages when committed.
+	* This is a no-op on platforms without transparent huge pages.
+	*/
+	void AdviseHugePages(void* Address, const size_t Bytes);
+
+	/**
+	* Gets the size of a virtual memory page.
+	*/
+	size_t GetVirtualPageSize();
 }
\ No newline at end of file
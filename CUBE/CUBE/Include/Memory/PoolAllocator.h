@@ -131,7 +131,7 @@ private:
 
 
 
-template <typename ElementType, uint32_t BlockSize>
+template <typename ElementType, uint32_t BlockSize, template <uint32_t, uint32_t> class PoolType = FPoolAllocator>
 /**
 * A wrapper class of FPoolAllocator for conveniently creating a 
 * pool for a specific object type. All functions are inlined, so
@@ -140,12 +140,16 @@ template <typename ElementType, uint32_t BlockSize>
 * \n
 * @param ElementType The object contained within the pool
 * @param BlockSize The max number of objects contained in the pool.
+* @param PoolType The pool implementation to use, such as FPoolAllocator or FVirtualPoolAllocator.
 */
-class FPoolAllocatorType : private FPoolAllocator<sizeof(ElementType), BlockSize>
+class FPoolAllocatorType : private PoolType<sizeof(ElementType), BlockSize>
 {
+private:
+	using BasePool = PoolType<sizeof(ElementType), BlockSize>;
+
 public:
 	FPoolAllocatorType(uint8_t Alignment)
-		:FPoolAllocator(Alignment)
+		:BasePool(Alignment)
 	{
 
 	}
@@ -158,7 +162,7 @@ public:
 	*/
 	ElementType* Allocate()
 	{
-		return reinterpret_cast<ElementType*>(FPoolAllocator::Allocate());
+		return reinterpret_cast<ElementType*>(BasePool::Allocate());
 	}
 
 	/**
@@ -169,7 +173,7 @@ public:
 	void Free(ElementType* Data)
 	{
 		Data->~ElementType();
-		FPoolAllocator::Free((void*)Data);
+		BasePool::Free((void*)Data);
 	}
 
 	/**
@@ -178,7 +182,7 @@ public:
 	*/
 	uint32_t Capacity() const
 	{
-		return FPoolAllocator::Capacity();
+		return BasePool::Capacity();
 	}
 
 	/**
@@ -187,6 +191,6 @@ public:
 	*/
 	uint32_t Size() const
 	{
-		return FPoolAllocator::Size();
+		return BasePool::Size();
 	}
 };
\ No newline at end of file
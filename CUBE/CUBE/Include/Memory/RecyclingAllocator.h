@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <algorithm>
+
+/**
+* Heap use shared by all recycling allocators.
+*/
+namespace FRecyclingAllocatorStats
+{
+	/**
+	* Gets the number of blocks allocated from the heap because no freed block could be reused.
+	*/
+	uint32_t GetHeapAllocations();
+
+	/**
+	* Counts a block allocated from the heap.
+	*/
+	void AddHeapAllocation();
+}
+
+template <typename T>
+/**
+* STL allocator that keeps freed single element blocks in a free list, to be handed out to
+* the next allocation of the same type instead of going back to the heap. Useful for the
+* control blocks of shared pointers and the nodes of containers that are created and released
+* at a steady rate. Arrays are allocated from the heap.
+* \n
+* Free lists are shared by every allocator of a type and never shrink.
+*/
+class TRecyclingAllocator
+{
+public:
+	typedef T              value_type;
+	typedef T*             pointer;
+	typedef const T*       const_pointer;
+	typedef T&             reference;
+	typedef const T&       const_reference;
+	typedef std::size_t    size_type;
+	typedef std::ptrdiff_t difference_type;
+
+	template <typename U>
+	struct rebind
+	{
+		typedef TRecyclingAllocator<U> other;
+	};
+
+public:
+	TRecyclingAllocator() {}
+
+	template <typename U>
+	TRecyclingAllocator(const TRecyclingAllocator<U>&) {}
+
+	T* allocate(const size_type Count)
+	{
+		if (Count == 1)
+		{
+			std::lock_guard<std::mutex> Lock(FreeMutex);
+			if (FreeList)
+			{
+				FreeBlock* Block = FreeList;
+				FreeList = Block->Next;
+				return reinterpret_cast<T*>(Block);
+			}
+		}
+
+		FRecyclingAllocatorStats::AddHeapAllocation();
+		return static_cast<T*>(::operator new(std::max(sizeof(T) * Count, sizeof(FreeBlock))));
+	}
+
+	void deallocate(T* Pointer, const size_type Count)
+	{
+		if (Count != 1)
+		{
+			::operator delete(Pointer);
+			return;
+		}
+
+		std::lock_guard<std::mutex> Lock(FreeMutex);
+		FreeBlock* Block = reinterpret_cast<FreeBlock*>(Pointer);
+		Block->Next = FreeList;
+		FreeList = Block;
+	}
+
+	template <typename U, typename... Args>
+	void construct(U* Pointer, Args&&... Arguments)
+	{
+		::new ((void*)Pointer) U(std::forward<Args>(Arguments)...);
+	}
+
+	template <typename U>
+	void destroy(U* Pointer)
+	{
+		Pointer->~U();
+	}
+
+	size_type max_size() const
+	{
+		return ((size_type)-1) / sizeof(T);
+	}
+
+	pointer address(reference Value) const { return &Value; }
+	const_pointer address(const_reference Value) const { return &Value; }
+
+	template <typename U>
+	bool operator==(const TRecyclingAllocator<U>&) const { return true; }
+
+	template <typename U>
+	bool operator!=(const TRecyclingAllocator<U>&) const { return false; }
+
+private:
+	struct FreeBlock
+	{
+		FreeBlock* Next;
+	};
+
+	static std::mutex FreeMutex;
+	static FreeBlock* FreeList;
+};
+
+template <typename T>
+std::mutex TRecyclingAllocator<T>::FreeMutex;
+
+template <typename T>
+typename TRecyclingAllocator<T>::FreeBlock* TRecyclingAllocator<T>::FreeList = nullptr;
\ No newline at end of file
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cstdint>
+#include "Misc/Assertions.h"
+#include "MemoryUtil.h"
+
+#include <algorithm>
+
+template <uint32_t ElementSize, uint32_t BlockSize>
+/**
+* Pool allocator that reserves address space for its elements up front, but
+* only commits memory as elements are handed out. Unlike FPoolAllocator, the free list
+* is built lazily: new elements come from a bump pointer and only freed elements are
+* linked into the free list, so constructing the pool touches no memory.
+* When the reserved space runs out, another segment of BlockSize elements is reserved,
+* so the pool can grow past BlockSize. Reserved segments are advised to be backed by huge
+* pages on platforms that support it. Committed memory is kept until the pool is destroyed.
+* \n
+* @param ElementSize The size of each allocation object.
+* @param BlockSize The number of objects reserved for each segment of the pool.
+*/
+class FVirtualPoolAllocator
+{
+public:
+	// Max number of segments the pool can grow to
+	static const uint32_t MAX_SEGMENTS = 16;
+
+	// Bytes committed at a time. Matches the common huge page size.
+	static const uint32_t COMMIT_SIZE = 2 * 1024 * 1024;
+
+public:
+	/**
+	* Ctor
+	* Constructs a pool allocator with specified alignment. No memory is
+	* reserved until the first allocation.
+	* @param Alignment for each allocation
+	*/
+	FVirtualPoolAllocator(uint32_t Alignment)
+		: mSegments()
+		, mSegmentCount(0)
+		, mElementStride(0)
+		, mSegmentSize(0)
+		, mNextFreeBlock(nullptr)
+		, mNextUnused(nullptr)
+		, mCommitEnd(nullptr)
+		, mSegmentEnd(nullptr)
+		, mObjectsConstructed(0)
+	{
+		ASSERT(0 < BlockSize && "BlockSize must be larger that 0");
+		ASSERT(ElementSize >= sizeof(PoolElement) && "ElementSize must at least the size of a standard pointer type.");
+		ASSERT((Alignment & (Alignment - 1)) == 0x0 && "Alignment must be a power of 2.");
+		ASSERT(Alignment <= COMMIT_SIZE);
+
+		// The byte gap between each allocation
+		mElementStride = (std::max(ElementSize, Alignment) + Alignment - 1) & ~(Alignment - 1);
+
+		// Each segment is a whole number of commit blocks
+		mSegmentSize = ((size_t)mElementStride * BlockSize + COMMIT_SIZE - 1) & ~((size_t)COMMIT_SIZE - 1);
+	}
+
+	~FVirtualPoolAllocator()
+	{
+		ASSERT(mObjectsConstructed == 0 && "All objects should be back in the pool on destruction.");
+
+		for (uint32_t i = 0; i < mSegmentCount; i++)
+		{
+			FMemory::ReleaseVirtual(mSegments[i], mSegmentSize + COMMIT_SIZE);
+		}
+	}
+
+	/**
+	* Allocate a new element from the memory pool.
+	* If the pool can't grow any further, nullptr is returned.
+	*/
+	void* Allocate()
+	{
+		void* Memory = nullptr;
+
+		if (mNextFreeBlock)
+		{
+			// Reuse a freed element
+			Memory = mNextFreeBlock;
+			mNextFreeBlock = mNextFreeBlock->Next;
+		}
+		else
+		{
+			// Take a new element from the end of the segment
+			if (mNextUnused == mSegmentEnd && !AddSegment())
+				return nullptr;
+
+			while (mNextUnused + mElementStride > mCommitEnd)
+			{
+				if (!FMemory::CommitVirtual(mCommitEnd, COMMIT_SIZE))
+					return nullptr;
+
+				mCommitEnd += COMMIT_SIZE;
+			}
+
+			Memory = mNextUnused;
+			mNextUnused += mElementStride;
+		}
+
+		mObjectsConstructed++;
+		return Memory;
+	}
+
+	/**
+	* Release an object back into the memory pool.
+	*/
+	void Free(void* Data)
+	{
+		ASSERT(mObjectsConstructed > 0);
+		mObjectsConstructed--;
+		PoolElement* Element = (PoolElement*)Data;
+		Element->Next = mNextFreeBlock;
+		mNextFreeBlock = Element;
+	}
+
+	/**
+	* Gets the number of objects that the pool has reserved
+	* space for. The pool grows when this is exceeded.
+	*/
+	uint32_t Capacity() const
+	{
+		return mSegmentCount * (uint32_t)(mSegmentSize / mElementStride);
+	}
+
+	/**
+	* Returns the number of objects in the pool
+	* that are constructed.
+	*/
+	uint32_t Size() const
+	{
+		return mObjectsConstructed;
+	}
+
+private:
+	// Disable copy ctor and copy assignment
+	FVirtualPoolAllocator(const FVirtualPoolAllocator& Other) = delete;
+	FVirtualPoolAllocator& operator=(const FVirtualPoolAllocator& Other) = delete;
+
+	struct PoolElement
+	{
+		PoolElement* Next{nullptr};
+	};
+
+	/**
+	* Reserves a new segment of address space and moves the bump pointer to it.
+	* @return True if the segment was reserved.
+	*/
+	bool AddSegment()
+	{
+		if (mSegmentCount == MAX_SEGMENTS)
+			return false;
+
+		// Reserve an extra commit block so the segment can be aligned for huge pages
+		uint8_t* RawMemory = static_cast<uint8_t*>(FMemory::ReserveVirtual(mSegmentSize + COMMIT_SIZE));
+		if (!RawMemory)
+			return false;
+
+		mSegments[mSegmentCount++] = RawMemory;
+
+		const uintptr_t AlignMask = COMMIT_SIZE - 1;
+		uint8_t* SegmentStart = reinterpret_cast<uint8_t*>((reinterpret_cast<uintptr_t>(RawMemory) + AlignMask) & ~AlignMask);
+		FMemory::AdviseHugePages(SegmentStart, mSegmentSize);
+
+		mNextUnused = SegmentStart;
+		mCommitEnd = SegmentStart;
+		mSegmentEnd = SegmentStart + (mSegmentSize / mElementStride) * mElementStride;
+		return true;
+	}
+
+private:
+	uint8_t*      mSegments[MAX_SEGMENTS]; // Start of each reserved range
+	uint32_t      mSegmentCount;
+	uint32_t      mElementStride;          // The byte gap between each allocation
+	size_t        mSegmentSize;            // Usable bytes in each segment
+	PoolElement*  mNextFreeBlock;          // Entry into the freelist
+	uint8_t*      mNextUnused;             // Next element that has never been allocated
+	uint8_t*      mCommitEnd;              // End of committed memory in the current segment
+	uint8_t*      mSegmentEnd;             // End of the last element in the current segment
+	uint32_t      mObjectsConstructed;     // Number of active objects from the pool
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace FBit
+{
+	/**
+	* Gets the index of the lowest set bit.
+	* @param Value - Must not be 0.
+	*/
+	inline uint32_t CountTrailingZeros(const uint32_t Value)
+	{
+#ifdef _MSC_VER
+		unsigned long Index;
+		_BitScanForward(&Index, Value);
+		return (uint32_t)Index;
+#else
+		return (uint32_t)__builtin_ctz(Value);
+#endif
+	}
+
+	/**
+	* Gets the index of the lowest set bit of a 64 bit value.
+	* @param Value - Must not be 0.
+	*/
+	inline uint32_t CountTrailingZeros64(const uint64_t Value)
+	{
+#if defined(_MSC_VER) && defined(_M_X64)
+		unsigned long Index;
+		_BitScanForward64(&Index, Value);
+		return (uint32_t)Index;
+#elif defined(_MSC_VER)
+		const uint32_t Low = (uint32_t)Value;
+		return Low ? CountTrailingZeros(Low) : 32 + CountTrailingZeros((uint32_t)(Value >> 32));
+#else
+		return (uint32_t)__builtin_ctzll(Value);
+#endif
+	}
+
+	template <uint32_t Size>
+	/**
+	* Transposes a square matrix of bits in place, so bit c of row r becomes bit r of row c.
+	* Swaps the off diagonal halves of ever smaller blocks, taking log2(Size) passes over the rows.
+	* @param Size - Number of rows and of bits used in each row. A power of two no larger than 64.
+	*/
+	inline void Transpose(uint64_t* Rows)
+	{
+		static_assert(Size >= 2 && Size <= 64 && (Size & (Size - 1)) == 0, "Bit matrices must be a power of two of up to 64 bits.");
+
+		// Low half of each group of 2 * Width bits, for widths of 1 to 32 bits
+		static const uint64_t LOW_HALVES[6] =
+		{
+			0x5555555555555555ull,
+			0x3333333333333333ull,
+			0x0F0F0F0F0F0F0F0Full,
+			0x00FF00FF00FF00FFull,
+			0x0000FFFF0000FFFFull,
+			0x00000000FFFFFFFFull
+		};
+
+		uint32_t Level = 0;
+		while ((2u << Level) < Size)
+			Level++;
+
+		for (uint32_t Width = Size / 2; Width != 0; Width >>= 1, Level--)
+		{
+			const uint64_t Mask = LOW_HALVES[Level];
+
+			// Visit the first row of each pair of rows Width apart
+			for (uint32_t k = 0; k < Size; k = ((k | Width) + 1) & ~Width)
+			{
+				const uint64_t Swap = ((Rows[k] >> Width) ^ Rows[k | Width]) & Mask;
+				Rows[k] ^= Swap << Width;
+				Rows[k | Width] ^= Swap;
+			}
+		}
+	}
+}
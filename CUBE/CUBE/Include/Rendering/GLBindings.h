@@ -28,6 +28,14 @@ namespace GLUniformBindings
 	};
 }
 
+namespace GLStorageBindings
+{
+	enum : uint32_t
+	{
+		ChunkQuads = 0,
+	};
+}
+
 namespace GLTextureBindings
 {
 	enum : uint32_t
@@ -8,6 +8,7 @@
 #include "ImageEffects\IImageEffect.h"
 #include "Utils\Event.h"
 #include "Math\Vector2.h"
+#include "Math\Vector3.h"
 
 class FChunkManager;
 
@@ -32,6 +33,12 @@ public:
 	*/
 	void SetModelTransform(const FTransform& WorldTransform);
 
+	/**
+	* Sets the world position of the chunk being rendered. Chunk vertices
+	* are relative to this position.
+	*/
+	void SetChunkOrigin(const Vector3i& WorldPosition);
+
 	/**
 	* Renders the scene.
 	*/
@@ -139,6 +146,7 @@ private:
 	FChunkManager&        mChunkManager;
 	FShaderProgram        mDeferredRender;
 	FShaderProgram        mChunkRender;
+	FUniform              mChunkOrigin;
 	PostProcessContainer  mPostProcesses;
 	//FBox                  mViewAABB;
 
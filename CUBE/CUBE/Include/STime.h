@@ -13,6 +13,14 @@ public:
 		return mDeltaTime;
 	}
 
+	/**
+	* Gets the real time the last frame took in seconds, without the game clock's time scale.
+	*/
+	static float GetFrameTime()
+	{
+		return mFrameTime;
+	}
+
 	static float GetFixedUpdate()
 	{
 		return mFixedUpdate;
@@ -37,6 +45,7 @@ private:
 	static uint64_t mFrameStart;
 	static uint64_t mFrameEnd;
 	static float mDeltaTime;
+	static float mFrameTime;
 	static float mFixedUpdate;
 };
 
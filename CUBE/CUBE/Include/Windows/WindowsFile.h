@@ -32,6 +32,8 @@ public:
 
 	uint32_t GetFileSize() const override;
 
+	bool Truncate() override;
+
 private:
 	/**
 	* Moves the current file pointer a specified distance based on
@@ -0,0 +1,85 @@
+#version 430 core
+
+#include "UniformBlocks.glsl"
+
+// Quads of the chunk being drawn. x holds the chunk local xyz of the first corner in 7 bits
+// each, a 3 bit normal ID, then the ambient occlusion of each corner in 2 bits each. y holds
+// the block type in the low 16 bits, then the width and height in 7 bits each.
+layout(std430, binding = 0) readonly buffer ChunkQuads
+{
+	uvec2 Quads[];
+};
+
+out VS_OUT 
+{
+	vec3 Normal;
+	vec3 Color;
+	float Occlusion;
+	flat uint MaterialID;
+} vs_out;
+
+layout(binding = 4) uniform sampler1D BlockColors;
+
+// World position of the chunk being drawn
+uniform ivec3 ChunkOrigin;
+
+const vec3 BlockNormals[6] =
+{
+	vec3( 1,  0,  0),
+	vec3(-1,  0,  0),
+	vec3( 0,  1,  0),
+	vec3( 0, -1,  0),
+	vec3( 0,  0,  1),
+	vec3( 0,  0, -1)
+};
+
+// Brightness of each level of baked ambient occlusion, from fully occluded to open
+const float OcclusionLevels[4] = { 0.5, 0.65, 0.8, 1.0 };
+
+// Corners of a quad as steps along u and v
+const ivec2 QuadCorners[4] = { ivec2(0, 0), ivec2(0, 1), ivec2(1, 1), ivec2(1, 0) };
+
+// Corners of the two triangles of a quad. Back faces are wound the other way.
+const int QuadIndices[12] =
+{
+	0, 3, 2, 0, 2, 1,
+	0, 1, 2, 2, 3, 0
+};
+
+void main()
+{
+	// Each quad is drawn with 6 vertices
+	uvec2 Quad = Quads[gl_VertexID / 6];
+	uint NormalID = (Quad.x >> 21) & 0x7;
+
+	// Unpack color
+	vs_out.Color = texelFetch(BlockColors, int(Quad.y & 0xFFFF), 0).xyz;
+
+	// Lookup normal with table
+	vec3 WorldNormal = BlockNormals[NormalID];
+	vs_out.Normal = mat3(Transforms.View) * WorldNormal;
+
+	vs_out.MaterialID = uint(gl_VertexID);
+
+	// Step from the first corner along the quad's u and v axes
+	int d = int(NormalID / 2);
+	int u = (d + 1) % 3;
+	int v = (d + 2) % 3;
+	int CornerID = QuadIndices[(NormalID & 1) * 6 + gl_VertexID % 6];
+
+	// Split the quad between its least occluded corners by starting each triangle one corner later
+	uvec4 CornerOcclusion = (uvec4(Quad.x) >> uvec4(24, 26, 28, 30)) & 0x3;
+	if (CornerOcclusion.x + CornerOcclusion.z < CornerOcclusion.y + CornerOcclusion.w)
+		CornerID = (CornerID + 1) % 4;
+
+	ivec2 Corner = QuadCorners[CornerID];
+	vs_out.Occlusion = OcclusionLevels[CornerOcclusion[CornerID]];
+
+	ivec3 LocalPosition = ivec3(Quad.x & 0x7F, (Quad.x >> 7) & 0x7F, (Quad.x >> 14) & 0x7F);
+	LocalPosition[u] += Corner.x * int((Quad.y >> 16) & 0x7F);
+	LocalPosition[v] += Corner.y * int((Quad.y >> 23) & 0x7F);
+
+	vec4 WorldPosition = vec4(vec3(ChunkOrigin + LocalPosition), 1.0);
+
+	gl_Position = Transforms.Projection * Transforms.View * WorldPosition;
+}
\ No newline at end of file
@@ -2,18 +2,24 @@
 
 #include "UniformBlocks.glsl"
 
-layout (location = 0) in vec4 iPosition;
-layout (location = 4) in uint Normal8_Block8;
+// Chunk local xyz in 7 bits each, a 3 bit normal ID, then 2 bits of ambient occlusion
+layout (location = 0) in uint Position21_Normal3;
+// Block type in the low 16 bits
+layout (location = 4) in uint Block16;
 
 out VS_OUT 
 {
 	vec3 Normal;
 	vec3 Color;
+	float Occlusion;
 	flat uint MaterialID;
 } vs_out;
 
 layout(binding = 4) uniform sampler1D BlockColors;
 
+// World position of the chunk being drawn
+uniform ivec3 ChunkOrigin;
+
 const vec3 BlockNormals[6] =
 {
 	vec3( 1,  0,  0),
@@ -24,16 +30,24 @@ const vec3 BlockNormals[6] =
 	vec3( 0,  0, -1)
 };
 
+// Brightness of each level of baked ambient occlusion, from fully occluded to open
+const float OcclusionLevels[4] = { 0.5, 0.65, 0.8, 1.0 };
+
 void main()
 {
 	// Unpack color
-	vs_out.Color = texelFetch(BlockColors, int(Normal8_Block8 & 0xFF), 0).xyz;
+	vs_out.Color = texelFetch(BlockColors, int(Block16 & 0xFFFF), 0).xyz;
 
 	// Unpack normal and lookup with table
-	vec3 WorldNormal = BlockNormals[(Normal8_Block8 & 0xFF00) >> 8];
+	vec3 WorldNormal = BlockNormals[(Position21_Normal3 >> 21) & 0x7];
 	vs_out.Normal = mat3(Transforms.View) * WorldNormal;
 
+	vs_out.Occlusion = OcclusionLevels[(Position21_Normal3 >> 24) & 0x3];
 	vs_out.MaterialID = uint(gl_VertexID);
 
-	gl_Position = Transforms.Projection * Transforms.View * iPosition;
+	// Unpack the chunk local position and move it into the world
+	ivec3 LocalPosition = ivec3(Position21_Normal3 & 0x7F, (Position21_Normal3 >> 7) & 0x7F, (Position21_Normal3 >> 14) & 0x7F);
+	vec4 WorldPosition = vec4(vec3(ChunkOrigin + LocalPosition), 1.0);
+
+	gl_Position = Transforms.Projection * Transforms.View * WorldPosition;
 }
\ No newline at end of file
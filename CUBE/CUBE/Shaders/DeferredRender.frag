@@ -6,15 +6,17 @@ in VS_OUT
 {
 	vec3 Normal;
 	vec3 Color;
+	float Occlusion; // Ambient occlusion baked into chunk meshes
 	flat uint MaterialID;
 } fs_in;
 
 void main()
 {
 	uvec4 OutVec0 = uvec4(0);
+	vec3 Color = fs_in.Color * fs_in.Occlusion;
 
-	OutVec0.x = packHalf2x16(fs_in.Color.xy);
-	OutVec0.y = packHalf2x16(vec2(fs_in.Color.z, fs_in.Normal.x));
+	OutVec0.x = packHalf2x16(Color.xy);
+	OutVec0.y = packHalf2x16(vec2(Color.z, fs_in.Normal.x));
 	OutVec0.z = packHalf2x16(fs_in.Normal.yz);
 	OutVec0.w = fs_in.MaterialID;
 
@@ -0,0 +1,138 @@
+#include "ChunkSystems\BlockEdit.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	/**
+	* Gets the largest integer whose square is no more than a value.
+	*/
+	int32_t FloorSqrt(const int32_t Value)
+	{
+		int32_t Root = (int32_t)std::sqrt((float)Value);
+
+		// Correct for float rounding
+		while (Root * Root > Value)
+			Root--;
+		while ((Root + 1) * (Root + 1) <= Value)
+			Root++;
+
+		return Root;
+	}
+}
+
+bool FBlockEdit::FOperation::RowSpan(const int32_t X, const int32_t Y, int32_t& ZMinOut, int32_t& ZMaxOut) const
+{
+	const int32_t DX = X - Center.x;
+	const int32_t DY = Y - Center.y;
+	int32_t Remaining = 0;
+
+	switch (Shape)
+	{
+	case EShape::Box:
+		ZMinOut = Min.z;
+		ZMaxOut = Max.z;
+		return true;
+	case EShape::Sphere:
+		Remaining = RadiusSquared - DX * DX - DY * DY;
+		break;
+	case EShape::Cylinder:
+		Remaining = RadiusSquared - DX * DX;
+		break;
+	default:
+		return false;
+	}
+
+	if (Remaining < 0)
+		return false;
+
+	const int32_t HalfWidth = FloorSqrt(Remaining);
+	ZMinOut = Center.z - HalfWidth;
+	ZMaxOut = Center.z + HalfWidth;
+	return true;
+}
+
+FBlockEdit::FBlockEdit()
+	: mOperations()
+	, mVoxels()
+{
+}
+
+void FBlockEdit::SetBox(const Vector3i& Min, const Vector3i& Max, const FBlockTypes::BlockID ID)
+{
+	AddShape(EShape::Box, Min, Max, Min, 0, ID);
+}
+
+void FBlockEdit::SetSphere(const Vector3i& Center, const uint32_t Radius, const FBlockTypes::BlockID ID)
+{
+	const int32_t R = (int32_t)Radius;
+	AddShape(EShape::Sphere, Center - Vector3i{ R, R, R }, Center + Vector3i{ R, R, R }, Center, R, ID);
+}
+
+void FBlockEdit::SetCylinder(const Vector3i& BaseCenter, const uint32_t Radius, const uint32_t Height, const FBlockTypes::BlockID ID)
+{
+	if (Height == 0)
+		return;
+
+	const int32_t R = (int32_t)Radius;
+	AddShape(EShape::Cylinder, BaseCenter - Vector3i{ R, 0, R }, BaseCenter + Vector3i{ R, (int32_t)Height - 1, R }, BaseCenter, R, ID);
+}
+
+void FBlockEdit::SetBlock(const Vector3i& Position, const FBlockTypes::BlockID ID)
+{
+	const FVoxel Voxel{ Position, ID };
+	SetBlocks(&Voxel, 1);
+}
+
+void FBlockEdit::SetBlocks(const FVoxel* Voxels, const uint32_t Count)
+{
+	if (Count == 0)
+		return;
+
+	// Extend the last operation if it is also a voxel list
+	if (mOperations.empty() || mOperations.back().Shape != EShape::Voxels)
+	{
+		FOperation Operation;
+		Operation.Shape = EShape::Voxels;
+		Operation.ID = 0;
+		Operation.Min = Voxels[0].Position;
+		Operation.Max = Voxels[0].Position;
+		Operation.Center = Voxels[0].Position;
+		Operation.RadiusSquared = 0;
+		Operation.FirstVoxel = (uint32_t)mVoxels.size();
+		Operation.VoxelCount = 0;
+		mOperations.push_back(Operation);
+	}
+
+	FOperation& Operation = mOperations.back();
+	for (uint32_t i = 0; i < Count; i++)
+	{
+		const Vector3i& Position = Voxels[i].Position;
+		Operation.Min = Vector3i{ std::min(Operation.Min.x, Position.x), std::min(Operation.Min.y, Position.y), std::min(Operation.Min.z, Position.z) };
+		Operation.Max = Vector3i{ std::max(Operation.Max.x, Position.x), std::max(Operation.Max.y, Position.y), std::max(Operation.Max.z, Position.z) };
+	}
+
+	mVoxels.insert(mVoxels.end(), Voxels, Voxels + Count);
+	Operation.VoxelCount += Count;
+}
+
+void FBlockEdit::Clear()
+{
+	mOperations.clear();
+	mVoxels.clear();
+}
+
+void FBlockEdit::AddShape(const EShape Shape, const Vector3i& Min, const Vector3i& Max, const Vector3i& Center, const int32_t Radius, const FBlockTypes::BlockID ID)
+{
+	FOperation Operation;
+	Operation.Shape = Shape;
+	Operation.ID = ID;
+	Operation.Min = Min;
+	Operation.Max = Max;
+	Operation.Center = Center;
+	Operation.RadiusSquared = Radius * Radius;
+	Operation.FirstVoxel = 0;
+	Operation.VoxelCount = 0;
+	mOperations.push_back(Operation);
+}
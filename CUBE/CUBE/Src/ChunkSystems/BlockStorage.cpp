@@ -0,0 +1,342 @@
+#include "ChunkSystems\BlockStorage.h"
+
+#include <atomic>
+#include <cstring>
+
+FConcurrentPoolAllocator<FBlockStorage::PAGE_SIZE, FBlockStorage::PAGE_POOL_SIZE> FBlockStorage::PageAllocator(FBlockStorage::PAGE_SIZE);
+
+namespace
+{
+	std::atomic<uint32_t> PagesInUse(0);
+
+	/**
+	* Allocates a single zeroed page. Falls back to the heap when the page pool can't grow.
+	* @param FromHeapOut - Set to true if the page was allocated from the heap.
+	*/
+	uint32_t* AllocatePage(bool& FromHeapOut)
+	{
+		void* Page = FBlockStorage::PageAllocator.Allocate();
+
+		FromHeapOut = (Page == nullptr);
+		if (FromHeapOut)
+			Page = FMemory::AllocateAligned(FBlockStorage::PAGE_SIZE, 16);
+
+		PagesInUse++;
+		std::memset(Page, 0, FBlockStorage::PAGE_SIZE);
+		return static_cast<uint32_t*>(Page);
+	}
+
+	/**
+	* Frees a page allocated with AllocatePage.
+	*/
+	void FreePage(uint32_t* Page, const bool FromHeap)
+	{
+		PagesInUse--;
+
+		if (FromHeap)
+		{
+			FMemory::FreeAligned(Page);
+		}
+		else
+		{
+			FBlockStorage::PageAllocator.Free(Page);
+		}
+	}
+
+	/**
+	* Gets the smallest supported index width that can address a number of palette entries.
+	*/
+	uint32_t BitsForPaletteSize(const uint32_t PaletteSize)
+	{
+		uint32_t Bits = 1;
+		while ((1u << Bits) < PaletteSize)
+			Bits *= 2;
+		return Bits;
+	}
+}
+
+FBlockStorage::FBlockStorage()
+	: mPages()
+	, mPalette()
+	, mPaletteCounts()
+	, mPaletteSize(0)
+	, mBitsPerBlock(0)
+	, mHeapPages(0)
+	, mUniformID(FBlock::AIR_BLOCK_ID)
+{
+}
+
+FBlockStorage::~FBlockStorage()
+{
+	FreePages();
+}
+
+uint32_t FBlockStorage::GetPagesInUse()
+{
+	return PagesInUse;
+}
+
+void FBlockStorage::FlushThreadCache()
+{
+	PageAllocator.FlushThreadCache();
+}
+
+FBlockTypes::BlockID FBlockStorage::Set(const uint32_t Index, const FBlockTypes::BlockID ID)
+{
+	ASSERT(Index < BLOCK_COUNT);
+
+	if (IsUniform())
+	{
+		if (ID == mUniformID)
+			return mUniformID;
+
+		// First differing block, start with a palette of only the uniform ID
+		AllocatePages(1);
+		mPalette[0] = mUniformID;
+		mPaletteCounts[0] = BLOCK_COUNT;
+		mPaletteSize = 1;
+	}
+
+	if (IsDirect())
+	{
+		const FBlockTypes::BlockID OldID = static_cast<FBlockTypes::BlockID>(ReadIndex(Index));
+		WriteIndex(Index, ID);
+		return OldID;
+	}
+
+	const uint32_t OldEntry = ReadIndex(Index);
+	const FBlockTypes::BlockID OldID = mPalette[OldEntry];
+
+	if (OldID == ID)
+		return OldID;
+
+	// Release the old entry first so it can be reused by the new ID
+	mPaletteCounts[OldEntry]--;
+
+	const uint32_t NewEntry = FindOrAddPaletteEntry(ID);
+	if (IsDirect())
+	{
+		WriteIndex(Index, ID);
+	}
+	else
+	{
+		mPaletteCounts[NewEntry]++;
+		WriteIndex(Index, NewEntry);
+
+		// Drop the pages if every block now uses this entry
+		if (mPaletteCounts[NewEntry] == BLOCK_COUNT)
+			SetUniform(ID);
+	}
+
+	return OldID;
+}
+
+void FBlockStorage::Pack(const FBlockTypes::BlockID* Blocks)
+{
+	FreePages();
+	mPaletteSize = 0;
+
+	// Build the palette. Runs of the same ID are common, so cache the last lookup.
+	bool IsDirectData = false;
+	uint32_t LastEntry = 0;
+
+	for (uint32_t i = 0; i < BLOCK_COUNT; i++)
+	{
+		const FBlockTypes::BlockID ID = Blocks[i];
+		if (mPaletteSize == 0 || mPalette[LastEntry] != ID)
+		{
+			LastEntry = 0;
+			while (LastEntry < mPaletteSize && mPalette[LastEntry] != ID)
+				LastEntry++;
+
+			if (LastEntry == mPaletteSize)
+			{
+				if (mPaletteSize == MAX_PALETTE_SIZE)
+				{
+					IsDirectData = true;
+					break;
+				}
+
+				mPalette[mPaletteSize] = ID;
+				mPaletteCounts[mPaletteSize] = 0;
+				mPaletteSize++;
+			}
+		}
+
+		mPaletteCounts[LastEntry]++;
+	}
+
+	// Nothing to store for blocks of a single ID
+	if (!IsDirectData && mPaletteSize == 1)
+	{
+		SetUniform(mPalette[0]);
+		return;
+	}
+
+	if (IsDirectData)
+	{
+		mPaletteSize = 0;
+		AllocatePages(BITS_PER_ID);
+
+		for (uint32_t i = 0; i < BLOCK_COUNT; i++)
+			WriteIndex(i, Blocks[i]);
+	}
+	else
+	{
+		AllocatePages(BitsForPaletteSize(mPaletteSize));
+
+		LastEntry = 0;
+		for (uint32_t i = 0; i < BLOCK_COUNT; i++)
+		{
+			const FBlockTypes::BlockID ID = Blocks[i];
+			if (mPalette[LastEntry] != ID)
+			{
+				LastEntry = 0;
+				while (mPalette[LastEntry] != ID)
+					LastEntry++;
+			}
+
+			WriteIndex(i, LastEntry);
+		}
+	}
+}
+
+void FBlockStorage::Unpack(FBlockTypes::BlockID* BlocksOut) const
+{
+	if (IsUniform())
+	{
+		std::fill(BlocksOut, BlocksOut + BLOCK_COUNT, mUniformID);
+		return;
+	}
+
+	// Extract every index held in each word
+	const uint32_t BlocksPerWord = 32 / mBitsPerBlock;
+	const uint32_t WordCount = BLOCK_COUNT / BlocksPerWord;
+	const uint32_t Mask = (1u << mBitsPerBlock) - 1;
+	const bool Direct = IsDirect();
+
+	for (uint32_t w = 0; w < WordCount; w++)
+	{
+		uint32_t Word = mPages[w / WORDS_PER_PAGE][w % WORDS_PER_PAGE];
+		for (uint32_t i = 0; i < BlocksPerWord; i++)
+		{
+			const uint32_t Value = Word & Mask;
+			*BlocksOut++ = Direct ? static_cast<FBlockTypes::BlockID>(Value) : mPalette[Value];
+			Word >>= mBitsPerBlock;
+		}
+	}
+}
+
+void FBlockStorage::Clear()
+{
+	SetUniform(FBlock::AIR_BLOCK_ID);
+}
+
+void FBlockStorage::SetUniform(const FBlockTypes::BlockID ID)
+{
+	FreePages();
+	mPaletteSize = 0;
+	mUniformID = ID;
+}
+
+uint32_t FBlockStorage::FindOrAddPaletteEntry(const FBlockTypes::BlockID ID)
+{
+	// Look for the ID or an unused entry to recycle
+	uint32_t FreeEntry = mPaletteSize;
+	for (uint32_t i = 0; i < mPaletteSize; i++)
+	{
+		if (mPalette[i] == ID)
+			return i;
+
+		if (mPaletteCounts[i] == 0 && FreeEntry == mPaletteSize)
+			FreeEntry = i;
+	}
+
+	if (FreeEntry < mPaletteSize)
+	{
+		mPalette[FreeEntry] = ID;
+		return FreeEntry;
+	}
+
+	// Widen the indices if the palette is full
+	if (mPaletteSize == (1u << mBitsPerBlock))
+	{
+		const uint32_t NewBits = mBitsPerBlock * 2;
+		if (NewBits >= BITS_PER_ID)
+		{
+			Resize(BITS_PER_ID);
+			return 0;
+		}
+
+		Resize(NewBits);
+	}
+
+	mPalette[mPaletteSize] = ID;
+	mPaletteCounts[mPaletteSize] = 0;
+	return mPaletteSize++;
+}
+
+void FBlockStorage::Resize(const uint32_t BitsPerBlock)
+{
+	ASSERT(BitsPerBlock > mBitsPerBlock);
+
+	// Hold on to the old pages while the new ones are filled
+	uint32_t* OldPages[MAX_PAGES];
+	std::memcpy(OldPages, mPages, sizeof(mPages));
+	const uint32_t OldBits = mBitsPerBlock;
+	const uint32_t OldHeapPages = mHeapPages;
+	const uint32_t OldMask = (1u << OldBits) - 1;
+	const uint32_t OldPageCount = PageCount(OldBits);
+
+	AllocatePages(BitsPerBlock);
+
+	const bool ToDirect = IsDirect();
+	for (uint32_t i = 0; i < BLOCK_COUNT; i++)
+	{
+		const uint32_t BitIndex = i * OldBits;
+		const uint32_t Word = BitIndex >> 5;
+		const uint32_t Value = (OldPages[Word / WORDS_PER_PAGE][Word % WORDS_PER_PAGE] >> (BitIndex & 31)) & OldMask;
+
+		WriteIndex(i, ToDirect ? mPalette[Value] : Value);
+	}
+
+	if (ToDirect)
+		mPaletteSize = 0;
+
+	for (uint32_t i = 0; i < OldPageCount; i++)
+		FreePage(OldPages[i], (OldHeapPages & (1u << i)) != 0);
+}
+
+void FBlockStorage::AllocatePages(const uint32_t BitsPerBlock)
+{
+	mHeapPages = 0;
+	mBitsPerBlock = BitsPerBlock;
+
+	const uint32_t Count = PageCount(BitsPerBlock);
+	for (uint32_t i = 0; i < MAX_PAGES; i++)
+	{
+		if (i < Count)
+		{
+			bool FromHeap = false;
+			mPages[i] = AllocatePage(FromHeap);
+			mHeapPages |= (FromHeap ? 1u : 0u) << i;
+		}
+		else
+		{
+			mPages[i] = nullptr;
+		}
+	}
+}
+
+void FBlockStorage::FreePages()
+{
+	const uint32_t Count = PageCount(mBitsPerBlock);
+	for (uint32_t i = 0; i < Count; i++)
+	{
+		FreePage(mPages[i], (mHeapPages & (1u << i)) != 0);
+		mPages[i] = nullptr;
+	}
+
+	mHeapPages = 0;
+	mBitsPerBlock = 0;
+}
@@ -1,57 +1,394 @@
 #include "ChunkSystems\Chunk.h"
+#include "ChunkSystems\GreedyMesher.h"
+#include "FileIO\MeshCacheFile.h"
 #include "Rendering\UniformBlockStandard.h"
 #include "Debugging\ConsoleOutput.h"
 #include "Debugging\DebugText.h"
 #include "Rendering\Screen.h"
 #include "ChunkSystems\ChunkManager.h"
 #include "Physics\PhysicsSystem.h"
+#include "Memory\ConcurrentPoolAllocator.h"
 
-FPoolAllocator<sizeof(FBlock) * FChunk::BLOCKS_PER_CHUNK, FChunk::POOL_SIZE> FChunk::ChunkAllocator(__alignof(FChunk));
-FPoolAllocatorType<FChunkMesh, FChunk::POOL_SIZE> FChunk::MeshAllocator(__alignof(FChunkMesh));
-FPoolAllocatorType<FChunk::CollisionData, FChunk::POOL_SIZE> FChunk::CollisionAllocator(__alignof(FChunk::CollisionData));
+#include <algorithm>
+#include <cstring>
 
-int32_t FChunk::BlockIndex(Vector3i Position)
+FPoolAllocatorType<FChunkMesh, FChunk::POOL_SIZE, FVirtualPoolAllocator> FChunk::MeshAllocator(__alignof(FChunkMesh));
+FPoolAllocatorType<FChunk::CollisionData, FChunk::POOL_SIZE, FVirtualPoolAllocator> FChunk::CollisionAllocator(__alignof(FChunk::CollisionData));
+
+bool FChunk::ShareMeshes = true;
+std::mutex FChunk::SharedMeshMutex;
+FChunk::SharedMeshTable FChunk::SharedMeshes;
+std::mutex FChunk::FreeMeshMutex;
+FChunk::SharedMesh* FChunk::FreeMeshes = nullptr;
+
+namespace
 {
-	ASSERT(Position.x >= 0 && Position.x < CHUNK_SIZE &&
-		Position.y >= 0 && Position.y < CHUNK_SIZE &&
-		Position.z >= 0 && Position.z < CHUNK_SIZE);
+	// Hibernated block data starts with the offset of each y slice in the RLE data
+	const uint32_t SLICE_TABLE_SIZE = FChunk::CHUNK_SIZE * sizeof(uint32_t);
+
+	std::atomic<uint32_t> HibernatedBytes(0);
+	std::atomic<uint32_t> CellBytes(0);
+
+	/**
+	* Buffers used to build meshes and to expand blocks, kept by each thread between chunks.
+	* Chunks are too large to expand on the stacks of worker threads.
+	*/
+	struct MeshScratch
+	{
+		FGreedyMesher                     Mesher;
+		std::vector<FGreedyMesher::FQuad> Quads;
+		std::vector<uint8_t>              Key;   // Key of the chunk being meshed, sized for the largest key
+		FBlockTypes::BlockID              Blocks[FChunk::BLOCKS_PER_CHUNK + FRunLengthCodec::DECODE_PADDING];
+	};
+
+	// Scratch of each thread slot, created the first time a thread in the slot uses it
+	MeshScratch* ThreadScratch[FThreadSlot::MAX_THREADS] = {};
+
+	/**
+	* Gets the scratch of the calling thread. Only one function at a time can use a thread's scratch.
+	* @param LocalScratch - Holds a scratch for threads without a slot until the caller returns.
+	*/
+	MeshScratch& GetThreadScratch(std::unique_ptr<MeshScratch>& LocalScratch)
+	{
+		const int32_t ThreadSlot = FThreadSlot::Get();
+		if (ThreadSlot == FThreadSlot::NO_SLOT)
+		{
+			LocalScratch.reset(new MeshScratch{});
+			return *LocalScratch;
+		}
+
+		if (!ThreadScratch[ThreadSlot])
+			ThreadScratch[ThreadSlot] = new MeshScratch{};
+
+		return *ThreadScratch[ThreadSlot];
+	}
+
+	/**
+	* Makes room for a number of elements in a buffer. Buffers that grow get a quarter more
+	* room than asked for, so meshes a little larger than the largest so far fit.
+	*/
+	template <typename T>
+	void Reserve(std::vector<T>& Buffer, const size_t Count)
+	{
+		if (Count > Buffer.capacity())
+			Buffer.reserve(Count + Count / 4);
+	}
+
+	// Most blocks in a cell at the lowest level of detail
+	const uint32_t MAX_CELL_SIZE = 1 << (FChunk::LOD_LEVELS - 1);
+	const uint32_t MAX_CELL_BLOCKS = MAX_CELL_SIZE * MAX_CELL_SIZE * MAX_CELL_SIZE;
+
+	// Blocks read by FChunk::ReadFace(), one cell deep, followed by a decoded slice
+	const uint32_t FACE_SCRATCH_BLOCKS = (MAX_CELL_SIZE + 1) * FChunk::CHUNK_SIZE * FChunk::CHUNK_SIZE + FRunLengthCodec::DECODE_PADDING;
+
+	/**
+	* Finds the type a group of blocks or cells is merged into. Groups that are at least half
+	* solid take their most common solid type, with ties going to the lowest ID.
+	* @param Cell - Blocks of the group in any order. They are sorted.
+	*/
+	FBlockTypes::BlockID CellType(FBlockTypes::BlockID* Cell, const uint32_t Count)
+	{
+		std::sort(Cell, Cell + Count);
+
+		FBlockTypes::BlockID Type = FBlock::AIR_BLOCK_ID;
+		uint32_t Solid = 0;
+		uint32_t MostBlocks = 0;
+		for (uint32_t i = 0; i < Count;)
+		{
+			uint32_t Run = 1;
+			while (i + Run < Count && Cell[i + Run] == Cell[i])
+				Run++;
+
+			if (Cell[i] != FBlock::AIR_BLOCK_ID)
+			{
+				Solid += Run;
+				if (Run > MostBlocks)
+				{
+					MostBlocks = Run;
+					Type = Cell[i];
+				}
+			}
+
+			i += Run;
+		}
+
+		return (2 * Solid >= Count) ? Type : (FBlockTypes::BlockID)FBlock::AIR_BLOCK_ID;
+	}
+
+	/**
+	* Finds the type of a cell at a level of detail by merging the 8 cells of the level before
+	* it that it holds, down to its blocks. A cell's type only depends on the cells it holds
+	* at any level before it.
+	* @param Cell - The CellSize^3 blocks of the cell, with the third axis changing fastest
+	*               and the first axis slowest. They are overwritten.
+	*/
+	FBlockTypes::BlockID MergeCell(FBlockTypes::BlockID* Cell, int32_t CellSize)
+	{
+		FBlockTypes::BlockID Group[8];
+		for (; CellSize > 1; CellSize /= 2)
+		{
+			// Merged cells are packed at the front. Each lands before the first cell it merges,
+			// so no cell is overwritten before it is merged.
+			const int32_t Half = CellSize / 2;
+			for (int32_t i = 0; i < Half; i++)
+			{
+				for (int32_t j = 0; j < Half; j++)
+				{
+					for (int32_t k = 0; k < Half; k++)
+					{
+						for (int32_t n = 0; n < 8; n++)
+							Group[n] = Cell[((2 * i + (n >> 2)) * CellSize + 2 * j + ((n >> 1) & 1)) * CellSize + 2 * k + (n & 1)];
+
+						Cell[(i * Half + j) * Half + k] = CellType(Group, 8);
+					}
+				}
+			}
+		}
+
+		return Cell[0];
+	}
+
+	/**
+	* Gets the index of the cell holding a block in cells kept at a level of detail.
+	*/
+	uint32_t CellIndex(const int32_t X, const int32_t Y, const int32_t Z, const uint32_t Lod)
+	{
+		const int32_t Size = FChunk::CHUNK_SIZE >> Lod;
+		return (uint32_t)(((Y >> Lod) * Size + (X >> Lod)) * Size + (Z >> Lod));
+	}
+
+	/**
+	* Replaces each cell of blocks with its cell type.
+	* @param Blocks - BLOCKS_PER_CHUNK block IDs in block index order.
+	* @param Lod - Level of detail. Cells are 2^Lod blocks across.
+	*/
+	void DownsampleBlocks(FBlockTypes::BlockID* Blocks, const uint32_t Lod)
+	{
+		const int32_t CellSize = 1 << Lod;
+		FBlockTypes::BlockID Cell[MAX_CELL_BLOCKS];
+
+		for (int32_t y = 0; y < FChunk::CHUNK_SIZE; y += CellSize)
+		{
+			for (int32_t x = 0; x < FChunk::CHUNK_SIZE; x += CellSize)
+			{
+				for (int32_t z = 0; z < FChunk::CHUNK_SIZE; z += CellSize)
+				{
+					uint32_t Count = 0;
+					for (int32_t i = 0; i < CellSize; i++)
+						for (int32_t j = 0; j < CellSize; j++)
+							for (int32_t k = 0; k < CellSize; k++)
+								Cell[Count++] = Blocks[FChunk::BlockIndex(x + j, y + i, z + k)];
+
+					const FBlockTypes::BlockID Type = MergeCell(Cell, CellSize);
+					for (int32_t i = 0; i < CellSize; i++)
+						for (int32_t j = 0; j < CellSize; j++)
+							for (int32_t k = 0; k < CellSize; k++)
+								Blocks[FChunk::BlockIndex(x + j, y + i, z + k)] = Type;
+				}
+			}
+		}
+	}
+
+	/**
+	* Checks if a layer of faces borders a changed slice of blocks. Layer n lies between slices n - 1 and n.
+	*/
+	bool IsLayerDirty(const uint64_t DirtySlices, const int32_t Layer)
+	{
+		const bool BeforeDirty = (Layer > 0) && ((DirtySlices >> (Layer - 1)) & 1);
+		const bool AfterDirty = (Layer < FChunk::CHUNK_SIZE) && ((DirtySlices >> Layer) & 1);
+		return BeforeDirty || AfterDirty;
+	}
+
+	/**
+	* Checks which blocks on a face of a uniform chunk would be covered by its neighbor.
+	* @return 0 if none are, 1 if some are, 2 if all are.
+	*/
+	uint32_t FaceCoverage(const FBlockTypes::BlockID* NeighborBlocks, const FBlockTypes::BlockID ID)
+	{
+		uint32_t Covered = 0;
+		for (int32_t i = 0; i < FChunk::CHUNK_SIZE * FChunk::CHUNK_SIZE; i++)
+			Covered += (NeighborBlocks[i] == ID);
+
+		if (Covered == 0)
+			return 0;
+		return (Covered == FChunk::CHUNK_SIZE * FChunk::CHUNK_SIZE) ? 2 : 1;
+	}
+
+	/**
+	* Checks if the edges and corners of the apron around a face only hold air. Blocks in
+	* them occlude the faces along the rim of the face.
+	*/
+	bool IsRimOpen(const FChunk::Apron& Neighbors, const uint32_t Face)
+	{
+		const int32_t d = Face / 2;
+		const uint32_t Side = Face & 1;
+
+		for (uint32_t Edge = 0; Edge < 12; Edge++)
+		{
+			// Edges along the face's axis don't touch it, and the rest touch it on one side of the axis
+			const int32_t a = Edge / 4;
+			if (a == d || ((Edge >> (a == (d + 1) % 3 ? 1 : 0)) & 1) != Side)
+				continue;
+
+			for (int32_t i = 0; i < FChunk::CHUNK_SIZE; i++)
+				if (Neighbors.Edges[Edge][i] != FBlock::AIR_BLOCK_ID)
+					return false;
+		}
+
+		for (uint32_t Corner = 0; Corner < 8; Corner++)
+			if (((Corner >> d) & 1) == Side && Neighbors.Corners[Corner] != FBlock::AIR_BLOCK_ID)
+				return false;
+
+		return true;
+	}
+
+	/**
+	* Hashes data 8 bytes at a time.
+	* @param Size - Size of the data. Must be a multiple of 8.
+	* @param Hash - Hash of any data before this data.
+	*/
+	uint64_t HashWords(const void* Data, const size_t Size, uint64_t Hash)
+	{
+		const uint8_t* Bytes = (const uint8_t*)Data;
+		for (size_t i = 0; i < Size; i += sizeof(uint64_t))
+		{
+			uint64_t Word;
+			std::memcpy(&Word, Bytes + i, sizeof(Word));
+			Hash = (Hash ^ Word) * 0x9E3779B97F4A7C15ull;
+			Hash ^= Hash >> 29;
+		}
+
+		return Hash;
+	}
+
+	// Runs in shared mesh keys are a block ID followed by a 16 bit length
+	const uint32_t KEY_RUN_SIZE = sizeof(FBlockTypes::BlockID) + sizeof(uint16_t);
+
+	// Largest shared mesh key, with a run for every block and neighbor block
+	const uint32_t MAX_KEY_SIZE = (FChunk::BLOCKS_PER_CHUNK + 6 * FChunk::CHUNK_SIZE * FChunk::CHUNK_SIZE + 12 * FChunk::CHUNK_SIZE + 8) * KEY_RUN_SIZE;
 
-	const Vector3i PositionToIndex{ CHUNK_SIZE, CHUNK_SIZE * CHUNK_SIZE, 1 };
-	return Vector3i::Dot(Position, PositionToIndex);
+	static_assert(sizeof(FChunk::Apron) % sizeof(uint64_t) == 0, "Aprons are hashed 8 bytes at a time.");
+
+	/**
+	* Writes a run of one block type to a shared mesh key.
+	* @return The end of the written runs.
+	*/
+	uint8_t* WriteKeyRun(const FBlockTypes::BlockID ID, uint32_t Length, uint8_t* Key)
+	{
+		while (Length > 0)
+		{
+			const uint16_t RunLength = (uint16_t)std::min(Length, 0xFFFFu);
+			std::memcpy(Key, &ID, sizeof(ID));
+			std::memcpy(Key + sizeof(ID), &RunLength, sizeof(RunLength));
+			Key += KEY_RUN_SIZE;
+			Length -= RunLength;
+		}
+
+		return Key;
+	}
+
+	/**
+	* Writes blocks to a shared mesh key as runs of the same type.
+	* @return The end of the written runs.
+	*/
+	uint8_t* WriteKeyBlocks(const FBlockTypes::BlockID* Blocks, const uint32_t Count, uint8_t* Key)
+	{
+		for (uint32_t i = 0; i < Count;)
+		{
+			uint32_t Run = 1;
+			while (i + Run < Count && Blocks[i + Run] == Blocks[i])
+				Run++;
+
+			Key = WriteKeyRun(Blocks[i], Run, Key);
+			i += Run;
+		}
+
+		return Key;
+	}
+
+	/**
+	* Appends the RLE data of a chunk's blocks.
+	* @param Blocks - BLOCKS_PER_CHUNK block IDs in block index order.
+	*/
+	void EncodeBlocks(const FBlockTypes::BlockID* Blocks, std::vector<uint8_t>& BlockDataOut)
+	{
+		// Encode straight into the output, then trim it to the encoded size
+		const size_t StartSize = BlockDataOut.size();
+		BlockDataOut.resize(StartSize + FRunLengthCodec::MAX_ENCODED_SIZE);
+
+		const uint32_t DataSize = FRunLengthCodec::Encode(Blocks, BlockDataOut.data() + StartSize);
+		BlockDataOut.resize(StartSize + DataSize);
+	}
 }
 
-int32_t FChunk::BlockIndex(int32_t X, int32_t Y, int32_t Z)
+FChunk::SharedMesh::SharedMesh()
+	: Hash(0)
+	, Key()
+	, Render()
+	, Positions()
+	, Indices()
+	, Mesh()
+	, Shape()
+	, NextFree(nullptr)
 {
-	return FChunk::BlockIndex(Vector3i{ X, Y, Z });
+}
+
+void FChunk::MeshRecycler::operator()(SharedMesh* Mesh) const
+{
+	if (Mesh->Hash != 0)
+	{
+		// Another chunk may have replaced the entry after the last reference was released
+		std::lock_guard<std::mutex> Lock(SharedMeshMutex);
+		auto Entry = SharedMeshes.find(Mesh->Hash);
+		if (Entry != SharedMeshes.end() && Entry->second.expired())
+			SharedMeshes.erase(Entry);
+	}
+
+	// Buffers and collision objects are kept for the next mesh
+	Mesh->Hash = 0;
+	Mesh->Key.clear();
+	Mesh->Render.Reset();
+	Mesh->Positions.clear();
+	Mesh->Indices.clear();
+
+	std::lock_guard<std::mutex> Lock(FreeMeshMutex);
+	Mesh->NextFree = FreeMeshes;
+	FreeMeshes = Mesh;
 }
 
 FChunk::FChunk()
-	: mBlocks(nullptr)
+	: mBlocks()
+	, mHibernatedBlocks()
+	, mCells()
+	, mCellLod(0)
+	, mIsModified(false)
+	, mBlockMutex()
 	, mCollisionData(nullptr)
+	, mMeshCache()
+	, mQuadHint(0)
+	, mLod(0)
+	, mDirtySlices()
+	, mDirtyBorders(0)
 	, mIsLoaded()
 	, mIsEmpty()
 {
 	mIsLoaded = false;
 	mIsEmpty = true;
 
-	// Allocate mesh, block, and collision data
+	// Allocate mesh and collision data. Block data is allocated by the block storage when loaded.
 	mMesh = new (MeshAllocator.Allocate()) FChunkMesh{};
-	mBlocks = static_cast<FBlock*>(ChunkAllocator.Allocate());
 
-	// Construct Collision fields with new memory
+	// Construct Collision fields with new memory. The collision shape is set when a mesh is swapped in.
 	mCollisionData = new (CollisionAllocator.Allocate()) CollisionData{};
-
-	// Set collision data
-	CollisionData& CollisionInfo = *mCollisionData;
-
-	// Set collision shape and transform
-	auto& CollisionMesh = CollisionInfo.Mesh[CollisionInfo.ActiveMesh];
-	CollisionInfo.Object.setCollisionShape(&CollisionMesh.Shape);
 }
 
 FChunk::~FChunk()
 {
-	ChunkAllocator.Free(mBlocks);
+	if (IsHibernating())
+		ReleaseHibernatedBlocks();
+
+	ReleaseCells();
+
 	MeshAllocator.Free(mMesh);
 	CollisionAllocator.Free(mCollisionData);
 }
@@ -61,72 +398,110 @@ bool FChunk::Load(const std::vector<uint8_t>& BlockData)
 {
 	ASSERT(!mIsLoaded);
 
-	// Current index to access block type
-	int32_t TypeIndex = 0;
-	int32_t DataSize = BlockData.size();
-	int32_t IsEmpty = 0;
-
-	// Write RLE data for chunk
-	for (int32_t y = 0; y < CHUNK_SIZE && TypeIndex < DataSize; y++)
+	// Uniform chunks are stored as a single block ID. Chunks with no data are all air.
+	if (BlockData.size() <= sizeof(FBlockTypes::BlockID))
 	{
-		for (int32_t x = 0; x < CHUNK_SIZE; x++)
-		{
-			int32_t BaseIndex = BlockIndex(x, y, 0);
-			for (int32_t z = 0; z < CHUNK_SIZE;)
-			{
-				uint8_t Count = 0;
-				FBlockTypes::BlockID BlockType = (FBlockTypes::BlockID)BlockData[TypeIndex];
-				uint8_t RunLength = BlockData[TypeIndex + 1];
+		FBlockTypes::BlockID UniformID = FBlock::AIR_BLOCK_ID;
+		if (BlockData.size() == sizeof(FBlockTypes::BlockID))
+			std::memcpy(&UniformID, BlockData.data(), sizeof(UniformID));
 
-				// If a single block is not None, this number can never be 0 again
-				IsEmpty += (int32_t)BlockType - (int32_t)FBlock::AIR_BLOCK_ID;
+		std::lock_guard<std::recursive_mutex> Lock(mBlockMutex);
+		mBlocks.SetUniform(UniformID);
+		mIsModified = false;
 
-				for (Count = 0; Count < RunLength; Count++)
-				{
-					mBlocks[BaseIndex + z + Count].ID = BlockType;
-				}
-
-				z += RunLength;
-				TypeIndex += 2;
-			}
-		}
+		mIsLoaded = true;
+		return (UniformID == FBlock::AIR_BLOCK_ID);
 	}
 
+	// Decode into a flat array, then pack into the block storage
+	std::unique_ptr<MeshScratch> LocalScratch;
+	FBlockTypes::BlockID* Blocks = GetThreadScratch(LocalScratch).Blocks;
+	FRunLengthCodec::Decode(BlockData.data(), (uint32_t)BlockData.size(), Blocks);
+
+	std::lock_guard<std::recursive_mutex> Lock(mBlockMutex);
+	mBlocks.Pack(Blocks);
+	mIsModified = false;
+
+	mIsLoaded = true;
+
+	return (mBlocks.IsUniform() && mBlocks.GetUniformID() == FBlock::AIR_BLOCK_ID);
+}
+
+bool FChunk::LoadCells(const std::vector<uint8_t>& CellData, const uint32_t Lod)
+{
+	ASSERT(!mIsLoaded && Lod > 0 && Lod < LOD_LEVELS);
 
+	std::lock_guard<std::recursive_mutex> Lock(mBlockMutex);
+	mCellLod = Lod;
+	mIsModified = false;
 	mIsLoaded = true;
-	return (IsEmpty == 0);
+
+	// Uniform cells are stored as a single block ID, like uniform chunks
+	if (CellData.size() == sizeof(FBlockTypes::BlockID))
+	{
+		FBlockTypes::BlockID UniformID;
+		std::memcpy(&UniformID, CellData.data(), sizeof(UniformID));
+		mBlocks.SetUniform(UniformID);
+		return (UniformID == FBlock::AIR_BLOCK_ID);
+	}
+
+	const int32_t Size = CHUNK_SIZE >> Lod;
+	ASSERT(CellData.size() == Size * Size * Size * sizeof(FBlockTypes::BlockID));
+
+	mCells.resize(Size * Size * Size);
+	std::memcpy(mCells.data(), CellData.data(), mCells.size() * sizeof(FBlockTypes::BlockID));
+	CellBytes += (uint32_t)(mCells.capacity() * sizeof(FBlockTypes::BlockID));
+
+	// Cells that aren't uniform hold more than one type, so at least one is solid
+	return false;
 }
 
 void FChunk::Unload(std::vector<uint8_t>& BlockDataOut)
 {
 	ASSERT(mIsLoaded);
 
-	mIsLoaded = false;
+	mMeshCache.reset();
 
-	// Extract RLE data for chunk
-	for (int32_t y = 0; y < CHUNK_SIZE; y++)
+	std::unique_ptr<MeshScratch> LocalScratch;
+	FBlockTypes::BlockID* Blocks = GetThreadScratch(LocalScratch).Blocks;
 	{
-		for (int32_t x = 0; x < CHUNK_SIZE; x++)
+		// Edits made while the lock is held are either in the data written out or refused
+		std::lock_guard<std::recursive_mutex> Lock(mBlockMutex);
+		mIsLoaded = false;
+		std::memset(mDirtySlices, 0, sizeof(mDirtySlices));
+		mDirtyBorders = 0;
+
+		// Chunks keeping cells had their changed blocks written when they were coarsened
+		if (mCellLod != 0)
 		{
-			for (int32_t z = 0; z < CHUNK_SIZE;)
-			{
-				const uint32_t CurrentBlockIndex = BlockIndex(x, y, z);
-				const FBlockTypes::BlockID CurrentBlock = mBlocks[CurrentBlockIndex].ID;
-				uint8_t Length = 1;
+			ReleaseCells();
+			mBlocks.Clear();
+			return;
+		}
 
-				FBlockTypes::BlockID NextBlock = mBlocks[CurrentBlockIndex + (int32_t)Length].ID;
-				while (CurrentBlock == NextBlock && Length + z < CHUNK_SIZE)
-				{
-					Length++;
-					NextBlock = mBlocks[CurrentBlockIndex + (int32_t)Length].ID;
-				}
+		// Hibernating chunks already hold their RLE data
+		if (IsHibernating())
+		{
+			BlockDataOut.insert(BlockDataOut.end(), mHibernatedBlocks.begin() + SLICE_TABLE_SIZE, mHibernatedBlocks.end());
+			ReleaseHibernatedBlocks();
+			return;
+		}
 
-				// Append RLE data
-				BlockDataOut.insert(BlockDataOut.end(), { CurrentBlock, Length });
-				z += (int32_t)Length;
-			}
+		// Uniform chunks only need their block ID
+		if (mBlocks.IsUniform())
+		{
+			const FBlockTypes::BlockID UniformID = mBlocks.GetUniformID();
+			const uint8_t* BlockBytes = reinterpret_cast<const uint8_t*>(&UniformID);
+			BlockDataOut.insert(BlockDataOut.end(), BlockBytes, BlockBytes + sizeof(UniformID));
+			mBlocks.Clear();
+			return;
 		}
+
+		mBlocks.Unpack(Blocks);
+		mBlocks.Clear();
 	}
+
+	EncodeBlocks(Blocks, BlockDataOut);
 }
 
 void FChunk::ShutDown(FPhysicsSystem& PhysicsSystem)
@@ -143,306 +518,883 @@ bool FChunk::IsLoaded() const
 	return mIsLoaded;
 }
 
-void FChunk::Render(const GLenum RenderMode)
+void FChunk::Render(const GLenum RenderMode, const uint32_t Faces)
 {
 	ASSERT(mIsLoaded);
 
-	mMesh->Render(RenderMode);
+	mMesh->Render(RenderMode, Faces);
+}
+
+uint32_t FChunk::FacingFaces(const Vector3i& ChunkPosition, const Vector3f& ViewPosition)
+{
+	// Faces toward the positive end of an axis face the view if it is past the start of
+	// the chunk, and faces toward the negative end if it is before the end.
+	const Vector3i Min = ChunkPosition * CHUNK_SIZE;
+	uint32_t Faces = 0;
+	for (int32_t Axis = 0; Axis < 3; Axis++)
+	{
+		Faces |= (ViewPosition[Axis] > (float)Min[Axis]) << (2 * Axis);
+		Faces |= (ViewPosition[Axis] < (float)(Min[Axis] + CHUNK_SIZE)) << (2 * Axis + 1);
+	}
+
+	return Faces;
 }
 
-void FChunk::SwapMeshBuffer(FPhysicsSystem& PhysicsSystem)
+uint32_t FChunk::SwapMeshBuffer(FPhysicsSystem& PhysicsSystem)
 {
-	bool WasEmpty = (mMesh->GetIndexCount(FChunkMesh::FrontBuffer{}) == 0);
-	mMesh->SwapBuffer();
+	bool WasEmpty = (mMesh->GetQuadCount(FChunkMesh::FrontBuffer{}) == 0);
+	const uint32_t UploadSize = mMesh->SwapBuffer();
 	mMesh->ClearBackBuffer();
-	mIsEmpty = (mMesh->GetIndexCount(FChunkMesh::FrontBuffer{}) == 0);
+	mIsEmpty = (mMesh->GetQuadCount(FChunkMesh::FrontBuffer{}) == 0);
+
+	// Previous mesh was not empty but this one is
+	if (!WasEmpty && mIsEmpty)
+		PhysicsSystem.RemoveCollider(mCollisionData->Object);
 
-	// Set to new collision shape
+	// Set to new collision shape, placed at the chunk as it may be shared
 	mCollisionData->ActiveMesh = !mCollisionData->ActiveMesh;
-	auto& CollisionMesh = mCollisionData->Mesh[mCollisionData->ActiveMesh];
-	mCollisionData->Object.setCollisionShape(&CollisionMesh.Shape);
+	const SharedMesh* CollisionMesh = mCollisionData->Mesh[mCollisionData->ActiveMesh].get();
+	if (CollisionMesh && !mIsEmpty)
+	{
+		const Vector3f& Origin = mCollisionData->Origin[mCollisionData->ActiveMesh];
+		mCollisionData->Object.setCollisionShape(CollisionMesh->Shape.get());
+		mCollisionData->Object.setWorldTransform(btTransform{ btQuaternion::getIdentity(), btVector3{ Origin.x, Origin.y, Origin.z } });
+	}
 
-	// Update collision info
+	// Previous mesh was empty
 	if (!mIsEmpty && WasEmpty)
-	{
-		// Previous mesh was empty
 		PhysicsSystem.AddCollider(mCollisionData->Object);
-	}
-	else if (!WasEmpty && mIsEmpty)
+
+	return UploadSize;
+}
+
+void FChunk::RebuildMesh(const Vector3f& WorldPosition, const Apron& Neighbors, const uint32_t Lod, FMeshCacheFile* MeshFile)
+{
+	ASSERT(Lod < LOD_LEVELS);
+	mLod = Lod;
+
+	const Vector3i ChunkPosition{ (int32_t)WorldPosition.x / CHUNK_SIZE, (int32_t)WorldPosition.y / CHUNK_SIZE, (int32_t)WorldPosition.z / CHUNK_SIZE };
+
+	bool IsShared = false;
+	std::shared_ptr<SharedMesh> Mesh = GreedyMesh(Neighbors, Lod, ChunkPosition, MeshFile, IsShared);
+
+	if (!IsShared)
 	{
-		// Previous mesh was not empty but this one is
-		PhysicsSystem.RemoveCollider(mCollisionData->Object);
+		Mesh->Render.FindFaceRanges();
+		BuildCollisionShape(*Mesh);
+
+		// Let chunks with the same contents find the finished mesh
+		if (Mesh->Hash != 0)
+		{
+			std::lock_guard<std::mutex> Lock(SharedMeshMutex);
+			SharedMeshes[Mesh->Hash] = Mesh;
+		}
 	}
+
+	mCollisionData->Mesh[!mCollisionData->ActiveMesh] = Mesh;
+	mCollisionData->Origin[!mCollisionData->ActiveMesh] = WorldPosition;
+
+	// The render data lives as long as the shared mesh holding it
+	mMesh->AddRenderData(FChunkMesh::RenderDataPtr{ Mesh, &Mesh->Render });
 }
 
-void FChunk::RebuildMesh(const Vector3f& WorldPosition)
+void FChunk::BuildCollisionShape(SharedMesh& Mesh)
 {
-	GreedyMesh(WorldPosition);
+	const FChunkMesh::QuadData& Quads = Mesh.Render.Quads;
+	const int32_t QuadCount = (int32_t)Quads.size();
+
+	if (QuadCount == 0)
+		return;
+
+	// Physics needs float positions and triangles, so expand them from the quads
+	Reserve(Mesh.Positions, QuadCount * 4);
+	Reserve(Mesh.Indices, QuadCount * 6);
+	Mesh.Positions.resize(QuadCount * 4);
+	Mesh.Indices.resize(QuadCount * 6);
+	for (int32_t q = 0; q < QuadCount; q++)
+	{
+		Vector3i Corners[4];
+		FChunkMesh::QuadCorners(Quads[q], Corners);
+
+		for (int32_t i = 0; i < 4; i++)
+			Mesh.Positions[q * 4 + i] = Vector3f{ (float)Corners[i].x, (float)Corners[i].y, (float)Corners[i].z };
 
-	int32_t VertexCount = (int)mMesh->GetVertexCount(FChunkMesh::BackBuffer{});
+		const uint32_t Winding = FChunkMesh::GetNormalID(Quads[q]) & 1;
+		for (int32_t i = 0; i < 6; i++)
+			Mesh.Indices[q * 6 + i] = q * 4 + FChunkMesh::QUAD_INDICES[Winding][i];
+	}
 
-	if (VertexCount != 0)
+	// Build collision data
+	// Set vertex properties for collision mesh
+	const int32_t IndexStride = 3 * sizeof(uint32_t);
+	const int32_t VertexStride = sizeof(Vector3f);
+
+	// Build final collision mesh
+	btIndexedMesh VertexData;
+	VertexData.m_triangleIndexStride = IndexStride;
+	VertexData.m_numTriangles = QuadCount * 2;
+	VertexData.m_numVertices = QuadCount * 4;
+	VertexData.m_triangleIndexBase = (const unsigned char*)Mesh.Indices.data();
+	VertexData.m_vertexBase = (const unsigned char*)Mesh.Positions.data();
+	VertexData.m_vertexStride = VertexStride;
+
+	// Recycled meshes rebuild their collision objects in place
+	if (Mesh.Mesh)
+	{
+		Mesh.Mesh->getIndexedMeshArray()[0] = VertexData;
+	}
+	else
 	{
-		// Build collision data
-		// Set vertex properties for collision mesh
-		const int32_t IndexStride = 3 * sizeof(uint32_t);
-		const int32_t VertexStride = sizeof(FChunkMesh::Vertex);
+		Mesh.Mesh.reset(new btTriangleIndexVertexArray{});
+		Mesh.Mesh->getIndexedMeshArray().push_back(VertexData);
+	}
 
-		// Build final collision mesh
-		btIndexedMesh VertexData;
-		VertexData.m_triangleIndexStride = IndexStride;
-		VertexData.m_numTriangles = (int)mMesh->GetIndexCount(FChunkMesh::BackBuffer{}) / 3;;
-		VertexData.m_numVertices = VertexCount;
-		VertexData.m_triangleIndexBase = (const unsigned char*)mMesh->GetIndexData(FChunkMesh::BackBuffer{});
-		VertexData.m_vertexBase = (const unsigned char*)mMesh->GetVertexData(FChunkMesh::BackBuffer{});
-		VertexData.m_vertexStride = VertexStride;
+	if (Mesh.Shape)
+	{
+		Mesh.Shape->~btBvhTriangleMeshShape();
+		new (Mesh.Shape.get()) btBvhTriangleMeshShape{ Mesh.Mesh.get(), false };
+	}
+	else
+	{
+		Mesh.Shape.reset(new btBvhTriangleMeshShape{ Mesh.Mesh.get(), false });
+	}
+}
 
-		// Reconstruct the collision shape with updated data
-		auto& CollisionMesh = mCollisionData->Mesh[!mCollisionData->ActiveMesh];
-		CollisionMesh.Mesh.getIndexedMeshArray().clear();
-		CollisionMesh.Mesh.getIndexedMeshArray().push_back(VertexData);
-		CollisionMesh.Shape.~btBvhTriangleMeshShape();
-		new (&CollisionMesh.Shape) btBvhTriangleMeshShape{ &CollisionMesh.Mesh, false };
+std::shared_ptr<FChunk::SharedMesh> FChunk::AcquireMesh(const uint32_t QuadHint)
+{
+	SharedMesh* Mesh = nullptr;
+	{
+		std::lock_guard<std::mutex> Lock(FreeMeshMutex);
+		Mesh = FreeMeshes;
+		if (Mesh)
+			FreeMeshes = Mesh->NextFree;
 	}
+
+	if (!Mesh)
+		Mesh = new SharedMesh{};
+
+	Reserve(Mesh->Render.Quads, QuadHint);
+
+	// Control blocks are recycled along with the meshes
+	return std::shared_ptr<SharedMesh>{ Mesh, MeshRecycler{}, TRecyclingAllocator<SharedMesh>{} };
 }
 
-void FChunk::SetBlock(const Vector3i& Position, FBlockTypes::BlockID ID)
+bool FChunk::SetBlock(const Vector3i& Position, FBlockTypes::BlockID ID)
 {
-	mBlocks[BlockIndex(Position)].ID = ID;
+	std::lock_guard<std::recursive_mutex> Lock(mBlockMutex);
+
+	// Placing a block over the same type changes nothing. Cells can't be edited.
+	if (!mIsLoaded || mCellLod != 0 || ReadBlock(Position) == ID)
+		return false;
+
+	Wake();
+	mBlocks.Set(BlockIndex(Position), ID);
+	MarkDirty(Position);
+	mIsModified = true;
+	return true;
 }
 
 FBlockTypes::BlockID FChunk::GetBlock(const Vector3i& Position) const
 {
-	return mBlocks[BlockIndex(Position)].ID;
+	std::lock_guard<std::recursive_mutex> Lock(mBlockMutex);
+	return ReadBlock(Position);
+}
+
+std::unique_lock<std::recursive_mutex> FChunk::LockBlocks() const
+{
+	return std::unique_lock<std::recursive_mutex>{ mBlockMutex };
+}
+
+FBlockTypes::BlockID FChunk::GetBlockLocked(const Vector3i& Position) const
+{
+	return ReadBlock(Position);
 }
 
 FBlockTypes::BlockID FChunk::DestroyBlock(const Vector3i& Position)
 {
-	FBlockTypes::BlockID ID = mBlocks[BlockIndex(Position)].ID;
-	mBlocks[BlockIndex(Position)].ID = FBlock::AIR_BLOCK_ID;
-	return ID;
+	std::lock_guard<std::recursive_mutex> Lock(mBlockMutex);
+
+	// Cells can't be edited
+	if (!mIsLoaded || mCellLod != 0)
+		return FBlock::AIR_BLOCK_ID;
+
+	const FBlockTypes::BlockID OldID = ReadBlock(Position);
+	if (OldID != FBlock::AIR_BLOCK_ID)
+	{
+		Wake();
+		mBlocks.Set(BlockIndex(Position), FBlock::AIR_BLOCK_ID);
+		MarkDirty(Position);
+		mIsModified = true;
+	}
+
+	return OldID;
 }
 
-void FChunk::GreedyMesh(const Vector3f WorldPosition)
+FBlockTypes::BlockID FChunk::ReadBlock(const Vector3i& Position) const
 {
-	// Greedy mesh algorithm by Mikola Lysenko from http://0fps.net/2012/06/30/meshing-in-a-minecraft-game/
-	// Java implementation from https://github.com/roboleary/GreedyMesh/blob/master/src/mygame/Main.java
+	if (IsHibernating())
+	{
+		ASSERT(Position.x >= 0 && Position.x < CHUNK_SIZE &&
+			Position.y >= 0 && Position.y < CHUNK_SIZE &&
+			Position.z >= 0 && Position.z < CHUNK_SIZE);
 
-	// Vertex and index data to be sent to the mesh
-	FChunkMesh::VertexDataPtr Vertices{ new FChunkMesh::VertexData{} };
-	FChunkMesh::IndexDataPtr Indices{ new FChunkMesh::IndexData{} };
+		uint32_t SliceOffset;
+		std::memcpy(&SliceOffset, &mHibernatedBlocks[Position.y * sizeof(uint32_t)], sizeof(SliceOffset));
+		return FRunLengthCodec::ReadBlock(&mHibernatedBlocks[SLICE_TABLE_SIZE + SliceOffset], Position.x, Position.z);
+	}
 
-	// Variables to be used by the algorithm
-	int32_t i, j, k, Length, Width, Height, u, v, n, Side = 0;
-	int32_t x[3], q[3], du[3], dv[3];
+	if (!mCells.empty())
+		return mCells[CellIndex(Position.x, Position.y, Position.z, mCellLod)];
 
-	// This mask will contain matching voxel faces as we
-	// loop through each direction in the chunk
-	FBlock Mask[CHUNK_SIZE * CHUNK_SIZE];
+	return mBlocks.Get(BlockIndex(Position));
+}
 
-	// Start with a for loop the will flip face direction once we iterate through
-	// the chunk in one direction.
-	for (bool BackFace = true, b = false; b != BackFace; BackFace = BackFace && b, b = !b)
+void FChunk::UnpackBlocks(FBlockTypes::BlockID* BlocksOut) const
+{
+	if (IsHibernating())
+	{
+		FRunLengthCodec::Decode(mHibernatedBlocks.data() + SLICE_TABLE_SIZE, (uint32_t)mHibernatedBlocks.size() - SLICE_TABLE_SIZE, BlocksOut);
+	}
+	else if (!mCells.empty())
+	{
+		for (int32_t y = 0; y < CHUNK_SIZE; y++)
+			for (int32_t x = 0; x < CHUNK_SIZE; x++)
+				for (int32_t z = 0; z < CHUNK_SIZE; z++)
+					BlocksOut[BlockIndex(x, y, z)] = mCells[CellIndex(x, y, z, mCellLod)];
+	}
+	else
 	{
+		mBlocks.Unpack(BlocksOut);
+	}
+}
 
-		// Iterate through each dimension of the chunk
-		for (int32_t d = 0; d < 3; d++)
-		{
-			// Get the other 2 axes
-			u = (d + 1) % 3;
-			v = (d + 2) % 3;
+bool FChunk::HasUniformBlocks() const
+{
+	return !IsHibernating() && mCells.empty() && mBlocks.IsUniform();
+}
 
-			x[0] = 0;
-			x[1] = 0;
-			x[2] = 0;
+bool FChunk::ReadFace(const uint32_t Face, FBlockTypes::BlockID* BlocksOut, const uint32_t Lod) const
+{
+	const int32_t d = Face / 2;
+	const int32_t u = (d + 1) % 3;
+	const int32_t v = (d + 2) % 3;
 
-			// Used to check against covering voxels
-			q[0] = 0;
-			q[1] = 0;
-			q[2] = 0;
-			q[d] = 1;
+	// Positive faces are even. Cells along the face are read a whole cell deep.
+	const int32_t CellSize = 1 << Lod;
+	int32_t Min[3] = { 0, 0, 0 };
+	int32_t Max[3] = { CHUNK_SIZE - 1, CHUNK_SIZE - 1, CHUNK_SIZE - 1 };
+	Min[d] = (Face & 1) ? 0 : CHUNK_SIZE - CellSize;
+	Max[d] = (Face & 1) ? CellSize - 1 : CHUNK_SIZE - 1;
 
-			if (d == 0)
-			{ 
-				Side = BackFace ? NormalID::West : NormalID::East;
-			}
-			else if (d == 1) 
-			{ 
-				Side = BackFace ? NormalID::Bottom : NormalID::Top;
-			}
-			else if (d == 2) 
-			{ 
-				Side = BackFace ? NormalID::South : NormalID::North;
+	std::lock_guard<std::recursive_mutex> Lock(mBlockMutex);
+
+	if (HasUniformBlocks())
+	{
+		const FBlockTypes::BlockID UniformID = mBlocks.GetUniformID();
+		std::fill(BlocksOut, BlocksOut + CHUNK_SIZE * CHUNK_SIZE, UniformID);
+		return (UniformID != FBlock::AIR_BLOCK_ID);
+	}
+
+	// Lower levels of detail read each layer of cells before merging them. Hibernating chunks
+	// decode each y slice the face passes through after the layers.
+	static_assert(FACE_SCRATCH_BLOCKS <= (uint32_t)(BLOCKS_PER_CHUNK + FRunLengthCodec::DECODE_PADDING), "Face layers must fit in a thread's block scratch.");
+	std::unique_ptr<MeshScratch> LocalScratch;
+	FBlockTypes::BlockID* Layers = GetThreadScratch(LocalScratch).Blocks;
+	FBlockTypes::BlockID* Slice = Layers + MAX_CELL_SIZE * CHUNK_SIZE * CHUNK_SIZE;
+	FBlockTypes::BlockID* LayersOut = (Lod == 0) ? BlocksOut : Layers;
+
+	const uint8_t* DataEnd = mHibernatedBlocks.data() + mHibernatedBlocks.size();
+	bool HasBlocks = false;
+	int32_t x[3];
+
+	for (x[1] = Min[1]; x[1] <= Max[1]; x[1]++)
+	{
+		if (IsHibernating())
+		{
+			uint32_t SliceOffset;
+			std::memcpy(&SliceOffset, &mHibernatedBlocks[x[1] * sizeof(uint32_t)], sizeof(SliceOffset));
+			FRunLengthCodec::DecodeSlice(&mHibernatedBlocks[SLICE_TABLE_SIZE + SliceOffset], DataEnd, Slice);
+		}
+
+		for (x[0] = Min[0]; x[0] <= Max[0]; x[0]++)
+		{
+			for (x[2] = Min[2]; x[2] <= Max[2]; x[2]++)
+			{
+				const FBlockTypes::BlockID ID = IsHibernating() ? Slice[x[0] * CHUNK_SIZE + x[2]] :
+				                                !mCells.empty() ? mCells[CellIndex(x[0], x[1], x[2], mCellLod)] : mBlocks.Get(BlockIndex(x[0], x[1], x[2]));
+				LayersOut[(x[d] - Min[d]) * CHUNK_SIZE * CHUNK_SIZE + x[u] + x[v] * CHUNK_SIZE] = ID;
+				HasBlocks |= (ID != FBlock::AIR_BLOCK_ID);
 			}
+		}
+	}
+
+	if (Lod == 0)
+		return HasBlocks;
+
+	FBlockTypes::BlockID Cell[MAX_CELL_BLOCKS];
+	HasBlocks = false;
+	for (int32_t Row = 0; Row < CHUNK_SIZE; Row += CellSize)
+	{
+		for (int32_t Column = 0; Column < CHUNK_SIZE; Column += CellSize)
+		{
+			uint32_t Count = 0;
+			for (int32_t Layer = 0; Layer < CellSize; Layer++)
+				for (int32_t j = 0; j < CellSize; j++)
+					for (int32_t i = 0; i < CellSize; i++)
+						Cell[Count++] = Layers[Layer * CHUNK_SIZE * CHUNK_SIZE + Column + i + (Row + j) * CHUNK_SIZE];
+
+			const FBlockTypes::BlockID Type = MergeCell(Cell, CellSize);
+			for (int32_t j = 0; j < CellSize; j++)
+				for (int32_t i = 0; i < CellSize; i++)
+					BlocksOut[Column + i + (Row + j) * CHUNK_SIZE] = Type;
+
+			HasBlocks |= (Type != FBlock::AIR_BLOCK_ID);
+		}
+	}
+
+	return HasBlocks;
+}
+
+bool FChunk::ReadEdge(const uint32_t Edge, FBlockTypes::BlockID* BlocksOut, const uint32_t Lod) const
+{
+	const int32_t a = Edge / 4;
+	const int32_t u = (a + 1) % 3;
+	const int32_t v = (a + 2) % 3;
+
+	// Cells along the edge are read a whole cell deep on both sides
+	const int32_t CellSize = 1 << Lod;
+	int32_t Min[3];
+	Min[u] = (Edge & 1) ? 0 : CHUNK_SIZE - CellSize;
+	Min[v] = (Edge & 2) ? 0 : CHUNK_SIZE - CellSize;
+
+	std::lock_guard<std::recursive_mutex> Lock(mBlockMutex);
+
+	FBlockTypes::BlockID Cell[MAX_CELL_BLOCKS];
+	bool HasBlocks = false;
+	int32_t x[3];
+
+	for (Min[a] = 0; Min[a] < CHUNK_SIZE; Min[a] += CellSize)
+	{
+		uint32_t Count = 0;
+		for (x[a] = Min[a]; x[a] < Min[a] + CellSize; x[a]++)
+			for (x[u] = Min[u]; x[u] < Min[u] + CellSize; x[u]++)
+				for (x[v] = Min[v]; x[v] < Min[v] + CellSize; x[v]++)
+					Cell[Count++] = ReadBlock(Vector3i{ x[0], x[1], x[2] });
+
+		const FBlockTypes::BlockID Type = MergeCell(Cell, CellSize);
+		std::fill(BlocksOut + Min[a], BlocksOut + Min[a] + CellSize, Type);
+		HasBlocks |= (Type != FBlock::AIR_BLOCK_ID);
+	}
+
+	return HasBlocks;
+}
+
+FBlockTypes::BlockID FChunk::ReadCorner(const uint32_t Corner, const uint32_t Lod) const
+{
+	const int32_t CellSize = 1 << Lod;
+	int32_t Min[3];
+	for (int32_t i = 0; i < 3; i++)
+		Min[i] = ((Corner >> i) & 1) ? 0 : CHUNK_SIZE - CellSize;
+
+	std::lock_guard<std::recursive_mutex> Lock(mBlockMutex);
+
+	FBlockTypes::BlockID Cell[MAX_CELL_BLOCKS];
+	uint32_t Count = 0;
+	for (int32_t y = Min[1]; y < Min[1] + CellSize; y++)
+		for (int32_t x = Min[0]; x < Min[0] + CellSize; x++)
+			for (int32_t z = Min[2]; z < Min[2] + CellSize; z++)
+				Cell[Count++] = ReadBlock(Vector3i{ x, y, z });
+
+	return MergeCell(Cell, CellSize);
+}
+
+void FChunk::MarkBorderDirty(const uint32_t Face)
+{
+	std::lock_guard<std::recursive_mutex> Lock(mBlockMutex);
+	mDirtyBorders |= 1u << Face;
+}
+
+void FChunk::MarkDirty(const Vector3i& Position)
+{
+	mDirtySlices[0] |= 1ull << Position.x;
+	mDirtySlices[1] |= 1ull << Position.y;
+	mDirtySlices[2] |= 1ull << Position.z;
+}
+
+#undef min
+#undef max
+bool FChunk::ApplyEdit(const FBlockEdit& Edit, const Vector3i& ChunkOrigin, const uint32_t* Voxels, const uint32_t VoxelCount, std::vector<FBlockChange>& ChangesOut)
+{
+	const Vector3i ChunkEnd = ChunkOrigin + Vector3i{ CHUNK_SIZE - 1, CHUNK_SIZE - 1, CHUNK_SIZE - 1 };
+	const size_t StartChanges = ChangesOut.size();
+
+	std::lock_guard<std::recursive_mutex> Lock(mBlockMutex);
+
+	// Cells can't be edited
+	if (!mIsLoaded || mCellLod != 0)
+		return false;
+
+	// Edit a flat copy of the blocks so the storage is only repacked once. Hibernating
+	// chunks are edited from their RLE data and only woken if a block changes.
+	std::unique_ptr<MeshScratch> LocalScratch;
+	FBlockTypes::BlockID* Blocks = GetThreadScratch(LocalScratch).Blocks;
+	UnpackBlocks(Blocks);
+
+	const std::vector<FBlockEdit::FVoxel>& EditVoxels = Edit.GetVoxels();
+	const uint32_t* NextVoxel = Voxels;
+	const uint32_t* VoxelsEnd = Voxels + VoxelCount;
 
-			// Move through the dimension from front to back
-			for (x[d] = -1; x[d] < CHUNK_SIZE;)
+	for (const auto& Operation : Edit.GetOperations())
+	{
+		if (Operation.Shape == FBlockEdit::EShape::Voxels)
+		{
+			// Voxel indices are in edit order, so this operation's voxels are next
+			const uint32_t OperationEnd = Operation.FirstVoxel + Operation.VoxelCount;
+			for (; NextVoxel != VoxelsEnd && *NextVoxel < OperationEnd; NextVoxel++)
 			{
-				// Compute mask
-				n = 0;
+				const FBlockEdit::FVoxel& Voxel = EditVoxels[*NextVoxel];
+				const Vector3i Local = Voxel.Position - ChunkOrigin;
+				FBlockTypes::BlockID& Block = Blocks[BlockIndex(Local)];
 
-				for (x[v] = 0; x[v] < CHUNK_SIZE; x[v]++)
+				if (Block != Voxel.ID)
 				{
-					for (x[u] = 0; x[u] < CHUNK_SIZE; x[u]++)
-					{
-						// Check covering voxel
-						FBlock Voxel1 = (x[d] >= 0) ? mBlocks[BlockIndex(x[0], x[1], x[2])] : FBlock{ FBlock::AIR_BLOCK_ID };
-						FBlock Voxel2 = (x[d] < CHUNK_SIZE - 1) ? mBlocks[BlockIndex(x[0] + q[0], x[1] + q[1], x[2] + q[2])] : FBlock{ FBlock::AIR_BLOCK_ID };
-
-						// If both voxels are active and the same type, mark the mask with an inactive block, if not
-						// choose the appropriate voxel to mark
-						if (Voxel1 == Voxel2)
-							Mask[n++] = FBlock{ FBlock::AIR_BLOCK_ID };
-						else
-							Mask[n++] = (BackFace) ? Voxel2 : Voxel1;
-					}
+					ChangesOut.push_back(FBlockChange{ Voxel.Position, Block, Voxel.ID });
+					Block = Voxel.ID;
+					MarkDirty(Local);
 				}
+			}
 
-				x[d]++;
+			continue;
+		}
 
-				// Generate the mesh for the mask
-				n = 0;
+		// Clip the shape bounds to the chunk
+		const Vector3i Min{ std::max(Operation.Min.x, ChunkOrigin.x), std::max(Operation.Min.y, ChunkOrigin.y), std::max(Operation.Min.z, ChunkOrigin.z) };
+		const Vector3i Max{ std::min(Operation.Max.x, ChunkEnd.x), std::min(Operation.Max.y, ChunkEnd.y), std::min(Operation.Max.z, ChunkEnd.z) };
 
-				for (j = 0; j < CHUNK_SIZE; j++)
+		for (int32_t y = Min.y; y <= Max.y; y++)
+		{
+			for (int32_t x = Min.x; x <= Max.x; x++)
+			{
+				int32_t ZMin, ZMax;
+				if (!Operation.RowSpan(x, y, ZMin, ZMax))
+					continue;
+
+				ZMin = std::max(ZMin, Min.z);
+				ZMax = std::min(ZMax, Max.z);
+
+				uint32_t Index = BlockIndex(x - ChunkOrigin.x, y - ChunkOrigin.y, ZMin - ChunkOrigin.z);
+				for (int32_t z = ZMin; z <= ZMax; z++, Index = FChunkGeometry::NextZ(Index))
 				{
-					for (i = 0; i < CHUNK_SIZE;)
+					if (Blocks[Index] != Operation.ID)
 					{
-						if (Mask[n].ID != FBlock::AIR_BLOCK_ID)
-						{
-							// Compute the width
-							for (Width = 1; i + Width < CHUNK_SIZE && (Mask[n + Width] == Mask[n]); Width++){}
-
-							// Compute Height
-							bool Done = false;
-
-							for (Height = 1; j + Height < CHUNK_SIZE; Height++)
-							{
-								for (k = 0; k < Width; k++)
-								{
-									if (Mask[n + k + Height*CHUNK_SIZE] != Mask[n])
-									{
-										Done = true;
-										break;
-									}
-								}
-
-								if (Done) 
-									break;
-							}
-
-
-							// Add the quad
-							x[u] = i;
-							x[v] = j;
-
-							du[0] = 0;
-							du[1] = 0;
-							du[2] = 0;
-							du[u] = Width;
-
-							dv[0] = 0;
-							dv[1] = 0;
-							dv[2] = 0;
-							dv[v] = Height;
-
-							const Vector3f Corners[4] = 
-							{
-								{ Vector3f{ x[0], x[1], x[2] } + WorldPosition },
-								{ Vector3f{ x[0] + du[0], x[1] + du[1], x[2] + du[2] } + WorldPosition },
-								{ Vector3f{ x[0] + du[0] + dv[0], x[1] + du[1] + dv[1], x[2] + du[2] + dv[2] } + WorldPosition },
-								{ Vector3f{ x[0] + dv[0], x[1] + dv[1], x[2] + dv[2] } + WorldPosition }
-							};
-
-							AddQuad(Corners[0], Corners[1], Corners[2], Corners[3], BackFace, Side, Mask[n], *Vertices, *Indices);
-
-
-							// Zero the mask
-							for (Length = 0; Length < Height; Length++)
-							{
-								for (k = 0; k < Width; k++)
-								{
-									Mask[n + k + Length * CHUNK_SIZE].ID = FBlock::AIR_BLOCK_ID;
-								}
-							}
-
-							// Increment counters
-							i += Width;
-							n += Width;
-						}
-						else
-						{
-							i++;
-							n++;
-						}
+						ChangesOut.push_back(FBlockChange{ Vector3i{ x, y, z }, Blocks[Index], Operation.ID });
+						Blocks[Index] = Operation.ID;
+						MarkDirty(Vector3i{ x, y, z } - ChunkOrigin);
 					}
 				}
 			}
 		}
 	}
 
-	// Add data to mesh
-	mMesh->AddVertexData(std::move(Vertices));
-	mMesh->AddIndexData(std::move(Indices));
+	if (ChangesOut.size() == StartChanges)
+		return false;
+
+	if (IsHibernating())
+		ReleaseHibernatedBlocks();
+
+	mBlocks.Pack(Blocks);
+	mIsModified = true;
+	return true;
+}
+
+void FChunk::Hibernate()
+{
+	std::lock_guard<std::recursive_mutex> Lock(mBlockMutex);
+
+	if (!mIsLoaded || IsHibernating() || mCellLod != 0 || mBlocks.IsUniform())
+		return;
+
+	std::unique_ptr<MeshScratch> LocalScratch;
+	FBlockTypes::BlockID* Blocks = GetThreadScratch(LocalScratch).Blocks;
+	mBlocks.Unpack(Blocks);
+	mBlocks.Clear();
+
+	// Encode into the largest possible size, then trim to the encoded size
+	mHibernatedBlocks.resize(SLICE_TABLE_SIZE + FRunLengthCodec::MAX_ENCODED_SIZE);
+
+	uint32_t SliceOffsets[CHUNK_SIZE];
+	const uint32_t DataSize = FRunLengthCodec::Encode(Blocks, mHibernatedBlocks.data() + SLICE_TABLE_SIZE, SliceOffsets);
+	std::memcpy(mHibernatedBlocks.data(), SliceOffsets, SLICE_TABLE_SIZE);
+
+	mHibernatedBlocks.resize(SLICE_TABLE_SIZE + DataSize);
+	mHibernatedBlocks.shrink_to_fit();
+	HibernatedBytes += (uint32_t)mHibernatedBlocks.capacity();
 }
 
-void FChunk::AddQuad(	const Vector3f& BottomLeft,
-						const Vector3f& TopLeft,
-						const Vector3f& TopRight,
-						const Vector3f& BottomRight,
-						const bool IsBackface,
-						const uint32_t Side,
-						const FBlock FaceInfo,
-						FChunkMesh::VertexData& VerticesOut,
-						FChunkMesh::IndexData& IndicesOut)
+bool FChunk::IsHibernating() const
 {
-	
-	// Get the index offset by checking the size of the vertex list.
-	uint32_t BaseIndex = VerticesOut.size();
+	return !mHibernatedBlocks.empty();
+}
+
+uint32_t FChunk::GetHibernatedMemoryUsage()
+{
+	return HibernatedBytes;
+}
 
-	// Add normal index and block type for each vertex
-	FChunkMesh::Vertex BottomLeftData;
-	BottomLeftData.Position = BottomLeft;
-	BottomLeftData.BlockType = FaceInfo.ID;
-	BottomLeftData.NormalID= Side;
+void FChunk::Wake()
+{
+	if (!IsHibernating())
+		return;
+
+	std::unique_ptr<MeshScratch> LocalScratch;
+	FBlockTypes::BlockID* Blocks = GetThreadScratch(LocalScratch).Blocks;
+	UnpackBlocks(Blocks);
+	ReleaseHibernatedBlocks();
+	mBlocks.Pack(Blocks);
+}
 
-	FChunkMesh::Vertex BottomRightData;
-	BottomRightData.Position = BottomRight;
-	BottomRightData.BlockType = FaceInfo.ID;
-	BottomRightData.NormalID = Side;
+void FChunk::ReleaseHibernatedBlocks()
+{
+	HibernatedBytes -= (uint32_t)mHibernatedBlocks.capacity();
+	std::vector<uint8_t>().swap(mHibernatedBlocks);
+}
 
-	FChunkMesh::Vertex TopLeftData;
-	TopLeftData.Position = TopLeft;
-	TopLeftData.BlockType = FaceInfo.ID;
-	TopLeftData.NormalID = Side;
+void FChunk::Coarsen(const uint32_t Lod, std::vector<uint8_t>& BlockDataOut, std::vector<uint8_t>& CellDataOut)
+{
+	ASSERT(Lod > 0 && Lod < LOD_LEVELS);
 
-	FChunkMesh::Vertex TopRightData;
-	TopRightData.Position = TopRight;
-	TopRightData.BlockType = FaceInfo.ID;
-	TopRightData.NormalID = Side;
+	std::lock_guard<std::recursive_mutex> Lock(mBlockMutex);
 
-	VerticesOut.insert(VerticesOut.end(), { BottomLeftData, BottomRightData, TopRightData, TopLeftData });
-	
+	// Uniform chunks hold no block pages, and are the same at every level
+	if (!mIsLoaded || mCellLod >= Lod || HasUniformBlocks())
+		return;
 
+	std::unique_ptr<MeshScratch> LocalScratch;
+	FBlockTypes::BlockID* Blocks = GetThreadScratch(LocalScratch).Blocks;
+	UnpackBlocks(Blocks);
 
-	// Add adjusted indices.
-	if (IsBackface)
+	if (mIsModified)
 	{
-		IndicesOut.insert(IndicesOut.end(), {	0 + BaseIndex, 
-												1 + BaseIndex, 
-												2 + BaseIndex, 
-												2 + BaseIndex, 
-												3 + BaseIndex, 
-												0 + BaseIndex });
+		EncodeBlocks(Blocks, BlockDataOut);
+		mIsModified = false;
+	}
 
+	// Cells of cells kept at a finer level are the same as the cells of the blocks
+	const bool IsFromBlocks = (mCellLod == 0);
+	DownsampleBlocks(Blocks, Lod);
+
+	if (IsHibernating())
+		ReleaseHibernatedBlocks();
+	ReleaseCells();
+	mCellLod = Lod;
+
+	const int32_t CellSize = 1 << Lod;
+	const int32_t Size = CHUNK_SIZE >> Lod;
+	const FBlockTypes::BlockID FirstType = Blocks[BlockIndex(0, 0, 0)];
+	bool IsUniform = true;
+	for (int32_t y = 0; y < CHUNK_SIZE && IsUniform; y += CellSize)
+		for (int32_t x = 0; x < CHUNK_SIZE && IsUniform; x += CellSize)
+			for (int32_t z = 0; z < CHUNK_SIZE && IsUniform; z += CellSize)
+				IsUniform = (Blocks[BlockIndex(x, y, z)] == FirstType);
+
+	// Uniform cells are kept as a uniform chunk
+	if (IsUniform)
+	{
+		mBlocks.SetUniform(FirstType);
+		if (IsFromBlocks)
+		{
+			const uint8_t* TypeBytes = reinterpret_cast<const uint8_t*>(&FirstType);
+			CellDataOut.insert(CellDataOut.end(), TypeBytes, TypeBytes + sizeof(FirstType));
+		}
+		return;
 	}
-	else
+
+	mBlocks.Clear();
+	mCells.resize(Size * Size * Size);
+	for (int32_t y = 0; y < CHUNK_SIZE; y += CellSize)
+		for (int32_t x = 0; x < CHUNK_SIZE; x += CellSize)
+			for (int32_t z = 0; z < CHUNK_SIZE; z += CellSize)
+				mCells[CellIndex(x, y, z, Lod)] = Blocks[BlockIndex(x, y, z)];
+
+	CellBytes += (uint32_t)(mCells.capacity() * sizeof(FBlockTypes::BlockID));
+
+	if (IsFromBlocks)
 	{
-		IndicesOut.insert(IndicesOut.end(), {	0 + BaseIndex, 
-												3 + BaseIndex, 
-												2 + BaseIndex, 
-												0 + BaseIndex, 
-												2 + BaseIndex, 
-												1 + BaseIndex });
+		const uint8_t* CellBytesOut = reinterpret_cast<const uint8_t*>(mCells.data());
+		CellDataOut.insert(CellDataOut.end(), CellBytesOut, CellBytesOut + mCells.size() * sizeof(FBlockTypes::BlockID));
 	}
+}
 
+uint32_t FChunk::GetCellMemoryUsage()
+{
+	return CellBytes;
+}
+
+void FChunk::ReleaseCells()
+{
+	CellBytes -= (uint32_t)(mCells.capacity() * sizeof(FBlockTypes::BlockID));
+	std::vector<FBlockTypes::BlockID>().swap(mCells);
+	mCellLod = 0;
+}
+
+std::shared_ptr<FChunk::SharedMesh> FChunk::GreedyMesh(const Apron& Neighbors, const uint32_t Lod, const Vector3i& ChunkPosition, FMeshCacheFile* MeshFile, bool& IsSharedOut)
+{
+	// Greedy mesh algorithm by Mikola Lysenko from http://0fps.net/2012/06/30/meshing-in-a-minecraft-game/
+	// Java implementation from https://github.com/roboleary/GreedyMesh/blob/master/src/mygame/Main.java
+	// Faces and quads are found with bit masks by FGreedyMesher, which builds the same quads.
+
+	// Threads keep their mesher buffers between chunks
+	std::unique_ptr<MeshScratch> LocalScratch;
+	MeshScratch* Scratch = &GetThreadScratch(LocalScratch);
+
+	// Expand the packed block data so the algorithm can read blocks directly. Hibernating
+	// chunks are decoded without restoring their block storage.
+	FBlockTypes::BlockID* Blocks = Scratch->Blocks;
+	bool IsUniform = false;
+	FBlockTypes::BlockID UniformID = FBlock::AIR_BLOCK_ID;
+	uint64_t DirtySlices[3];
+	uint32_t DirtyBorders = 0;
+	{
+		std::lock_guard<std::recursive_mutex> Lock(mBlockMutex);
+		IsUniform = HasUniformBlocks();
+
+		// Take the slices changed since the last rebuild
+		std::memcpy(DirtySlices, mDirtySlices, sizeof(DirtySlices));
+		std::memset(mDirtySlices, 0, sizeof(mDirtySlices));
+		DirtyBorders = mDirtyBorders;
+		mDirtyBorders = 0;
+
+		if (IsUniform)
+			UniformID = mBlocks.GetUniformID();
+		else
+			UnpackBlocks(Blocks);
+	}
+
+	// Cells of blocks at lower levels of detail are meshed as one type. Uniform chunks are the same at every level.
+	if (Lod > 0 && !IsUniform)
+		DownsampleBlocks(Blocks, Lod);
+
+	// Layers are only kept for full detail meshes
+	if (IsUniform || Lod > 0)
+		mMeshCache.reset();
+
+	// Chunks that have been edited before only rebuild the layers next to changed slices
+	const bool WasEdited = (DirtySlices[0] | DirtySlices[1] | DirtySlices[2]) != 0;
+	const MeshCache* Cache = mMeshCache.get();
+
+	// Look for the mesh of a chunk with the same blocks and neighbor blocks. Edited chunks
+	// keep their own mesh so their layers can be rebuilt.
+	const bool IsShareable = ShareMeshes && (IsUniform || Lod > 0 || (!WasEdited && !Cache));
+
+	// Meshes of chunks that haven't been edited since they were loaded are kept in the mesh
+	// cache file. Uniform chunks are quick to mesh and edited chunks change too often.
+	const bool IsStored = MeshFile && !IsUniform && (Lod > 0 || (!WasEdited && !Cache));
+
+	uint64_t Hash = 0;
+	if (IsShareable || IsStored)
+	{
+		// Uniform chunks hash their block ID in place of their blocks
+		Hash = HashWords(&Neighbors, sizeof(Neighbors), IsUniform ? 0x2545F4914F6CDD1Dull ^ UniformID : 0xCBF29CE484222325ull);
+		if (!IsUniform)
+			Hash = HashWords(Blocks, sizeof(FBlockTypes::BlockID) * BLOCKS_PER_CHUNK, Hash);
+
+		// 0 marks meshes that aren't shared
+		Hash += (Hash == 0);
+	}
+
+	// Hashes can collide, so meshes are only shared between chunks with the same key
+	uint32_t KeySize = 0;
+	if (IsShareable)
+	{
+		if (Scratch->Key.size() < MAX_KEY_SIZE)
+			Scratch->Key.resize(MAX_KEY_SIZE);
+
+		uint8_t* KeyEnd = Scratch->Key.data();
+		for (uint32_t Face = 0; Face < 6; Face++)
+			KeyEnd = WriteKeyBlocks(Neighbors.Blocks[Face], CHUNK_SIZE * CHUNK_SIZE, KeyEnd);
+
+		for (uint32_t Edge = 0; Edge < 12; Edge++)
+			KeyEnd = WriteKeyBlocks(Neighbors.Edges[Edge], CHUNK_SIZE, KeyEnd);
+
+		KeyEnd = WriteKeyBlocks(Neighbors.Corners, 8, KeyEnd);
+
+		KeyEnd = IsUniform ? WriteKeyRun(UniformID, BLOCKS_PER_CHUNK, KeyEnd) : WriteKeyBlocks(Blocks, BLOCKS_PER_CHUNK, KeyEnd);
+		KeySize = (uint32_t)(KeyEnd - Scratch->Key.data());
+	}
+
+	IsSharedOut = false;
+	if (IsShareable)
+	{
+		std::lock_guard<std::mutex> Lock(SharedMeshMutex);
+		auto Entry = SharedMeshes.find(Hash);
+		if (Entry != SharedMeshes.end())
+		{
+			std::shared_ptr<SharedMesh> Found = Entry->second.lock();
+			if (Found && Found->Key.size() == KeySize && std::memcmp(Found->Key.data(), Scratch->Key.data(), KeySize) == 0)
+			{
+				IsSharedOut = true;
+				return Found;
+			}
+		}
+	}
+
+	// Quad data to be sent to the mesh, with room for as many quads as the last mesh
+	std::shared_ptr<SharedMesh> Mesh = AcquireMesh(mQuadHint);
+	Mesh->Hash = IsShareable ? Hash : 0;
+	if (IsShareable)
+	{
+		Reserve(Mesh->Key, KeySize);
+		Mesh->Key.assign(Scratch->Key.begin(), Scratch->Key.begin() + KeySize);
+	}
+
+	FChunkMesh::QuadData& MeshQuads = Mesh->Render.Quads;
+
+	// Chunks meshed in an earlier session read the quads they built then
+	if (IsStored && MeshFile->ReadMesh(ChunkPosition, Lod, Hash, MeshQuads))
+	{
+		mQuadHint = (uint32_t)MeshQuads.size();
+		return Mesh;
+	}
+
+	// Uniform chunks are either empty or only have outer faces that aren't covered by a neighbor
+	if (IsUniform)
+	{
+		uint32_t OpenFaces = 0;
+		bool IsPartlyCovered = false;
+		for (uint32_t Face = 0; Face < 6 && UniformID != FBlock::AIR_BLOCK_ID; Face++)
+		{
+			const uint32_t Coverage = FaceCoverage(Neighbors.Blocks[Face], UniformID);
+			OpenFaces |= (Coverage == 0) << Face;
+			IsPartlyCovered |= (Coverage == 1);
+
+			// Open faces in front of other solid blocks are occluded
+			IsPartlyCovered |= (Coverage == 0 && FaceCoverage(Neighbors.Blocks[Face], (FBlockTypes::BlockID)FBlock::AIR_BLOCK_ID) != 2);
+			IsPartlyCovered |= (Coverage == 0 && !IsRimOpen(Neighbors, Face));
+		}
+
+		// Partly covered and occluded faces are left to the full mesher
+		if (!IsPartlyCovered)
+		{
+			if (OpenFaces)
+				AddUniformFaces(FBlock{ UniformID }, OpenFaces, MeshQuads);
+
+			mQuadHint = (uint32_t)MeshQuads.size();
+			return Mesh;
+		}
+
+		std::fill(Blocks, Blocks + BLOCKS_PER_CHUNK, UniformID);
+	}
+
+	uint32_t LayerStarts[MESH_LAYER_COUNT + 1];
+
+	FGreedyMesher& Mesher = Scratch->Mesher;
+	std::vector<FGreedyMesher::FQuad>& Quads = Scratch->Quads;
+
+	// Find faces and grow quads with bit masks of each block type
+	Mesher.SetBlocks(Blocks, Neighbors.Blocks, Neighbors.Edges, Neighbors.Corners);
+
+	// Start with a for loop the will flip face direction once we iterate through
+	// the chunk in one direction.
+	for (bool BackFace = true, b = false; b != BackFace; BackFace = BackFace && b, b = !b)
+	{
+
+		// Iterate through each dimension of the chunk
+		for (int32_t d = 0; d < 3; d++)
+		{
+			// Get the other 2 axes
+			const int32_t u = (d + 1) % 3;
+			const int32_t v = (d + 2) % 3;
+
+			// Back faces point toward the start of the axis
+			const uint32_t Side = 2 * d + (BackFace ? 1 : 0);
+
+			// Move through the dimension from front to back. Layer n lies between slices n - 1 and n.
+			for (int32_t Layer = 0; Layer <= CHUNK_SIZE; Layer++)
+			{
+				const uint32_t Slot = ((BackFace ? 0 : 3) + d) * LAYERS_PER_FACE + Layer;
+				LayerStarts[Slot] = (uint32_t)MeshQuads.size();
+
+				// Back faces belong to the slice after the layer and front faces to the slice before it.
+				// The outer layer on the far side of each pass only holds faces of neighbor blocks.
+				const int32_t Depth = BackFace ? Layer : Layer - 1;
+				if (Depth < 0 || Depth >= CHUNK_SIZE)
+					continue;
+
+				// Faces in a layer only depend on the slices on either side of it. Border
+				// layers also depend on the neighbor's blocks, and the occlusion at the edges
+				// of every layer depends on the neighbors beside it.
+				const bool IsBorderDirty = (Layer == 0 && (DirtyBorders >> (2 * d + 1)) & 1) ||
+				                           (Layer == CHUNK_SIZE && (DirtyBorders >> (2 * d)) & 1) ||
+				                           (DirtyBorders & ~(3u << (2 * d))) != 0;
+
+				if (Cache && !IsBorderDirty && !IsLayerDirty(DirtySlices[d], Layer))
+				{
+					AddCachedQuads(*Cache, Slot, MeshQuads);
+					continue;
+				}
+
+				Quads.clear();
+				Mesher.BuildLayer(Side, Depth, Quads);
+
+				for (const auto& Quad : Quads)
+				{
+					int32_t x[3];
+					x[d] = Layer;
+					x[u] = Quad.U;
+					x[v] = Quad.V;
+
+					MeshQuads.push_back(FChunkMesh::PackQuad(Vector3i{ x[0], x[1], x[2] }, Quad.Width, Quad.Height, Side, Quad.Type, Quad.Occlusion));
+				}
+			}
+		}
+	}
+
+	LayerStarts[MESH_LAYER_COUNT] = (uint32_t)MeshQuads.size();
+	mQuadHint = (uint32_t)MeshQuads.size();
+
+	if (IsStored)
+		MeshFile->WriteMesh(ChunkPosition, Lod, Hash, MeshQuads);
+
+	// Keep the quads of edited chunks for their next rebuild
+	if (Lod == 0 && (WasEdited || Cache))
+	{
+		if (!mMeshCache)
+			mMeshCache.reset(new MeshCache{});
+
+		mMeshCache->Quads = MeshQuads;
+		std::memcpy(mMeshCache->LayerStarts, LayerStarts, sizeof(LayerStarts));
+	}
+
+	return Mesh;
+}
+
+void FChunk::AddCachedQuads(const MeshCache& Cache, const uint32_t Layer, FChunkMesh::QuadData& QuadsOut)
+{
+	QuadsOut.insert(QuadsOut.end(), Cache.Quads.begin() + Cache.LayerStarts[Layer], Cache.Quads.begin() + Cache.LayerStarts[Layer + 1]);
+}
+
+void FChunk::AddUniformFaces(const FBlock BlockType, const uint32_t Faces, FChunkMesh::QuadData& QuadsOut)
+{
+	// Emit the same quads GreedyMesh() would build for a chunk full of one block type
+	for (bool BackFace = true, b = false; b != BackFace; BackFace = BackFace && b, b = !b)
+	{
+		for (int32_t d = 0; d < 3; d++)
+		{
+			int32_t x[3] = { 0, 0, 0 };
+			x[d] = BackFace ? 0 : CHUNK_SIZE;
+
+			uint32_t Side = 0;
+			if (d == 0)
+				Side = BackFace ? NormalID::West : NormalID::East;
+			else if (d == 1)
+				Side = BackFace ? NormalID::Bottom : NormalID::Top;
+			else
+				Side = BackFace ? NormalID::South : NormalID::North;
+
+			if (!((Faces >> Side) & 1))
+				continue;
+
+			QuadsOut.push_back(FChunkMesh::PackQuad(Vector3i{ x[0], x[1], x[2] }, CHUNK_SIZE, CHUNK_SIZE, Side, BlockType.ID));
+		}
+	}
 }
\ No newline at end of file
@@ -8,40 +8,161 @@
 #include "Rendering\RenderSystem.h"
 #include "SFML\Window\Context.hpp"
 #include "STime.h"
+#include "Clock.h"
+#include "Memory\AllocationCounter.h"
 #include "GL\glew.h"
 #include <algorithm>
+#include <cstdlib>
 
-static const uint32_t DEFAULT_VIEW_DISTANCE = 14;
-static const uint32_t MESH_SWAPS_PER_FRAME = 25;
-static const int32_t CHUNKS_TO_LOAD_PER_ITERATION = 8;
+static const uint32_t DEFAULT_VIEW_DISTANCE = 15;
+static const int32_t CHUNKS_TO_LOAD_PER_ITERATION = 8; // For each streaming thread, when loading isn't throttled
 
-// Height is half width
-static const uint32_t DEFAULT_CHUNK_SIZE = (2 * DEFAULT_VIEW_DISTANCE + 1) * (DEFAULT_VIEW_DISTANCE + 1) * (2 * DEFAULT_VIEW_DISTANCE + 1);
+// Loading waits while this many load batches of meshes are waiting to be swapped in
+static const uint32_t SWAP_BACKLOG_BATCHES = 2;
+static const uint32_t PIPELINED_LOAD_BATCHES = 4; // Load batches overlapped before the loader checks for other work
+static const uint32_t DEFAULT_LOD_DISTANCES[FChunk::LOD_LEVELS - 1] = { 4, 8, 12 };
+
+// Chunks meshed at this level of detail or past it only keep their cells. Nearer chunks keep their blocks, so they can be edited.
+static const uint32_t CELL_STORAGE_LOD = 2;
+
+// Loads are reprioritized when the camera turns further than this from the last view, about 25 degrees
+static const float VIEW_TURN_COSINE = 0.9f;
+
+/**
+* Gets the log2 of the smallest power of two that is at least a size.
+*/
+static int32_t CeilLog2(const uint32_t Size)
+{
+	int32_t Shift = 0;
+	while ((1u << Shift) < Size)
+		Shift++;
+	return Shift;
+}
+
+/**
+* Gets the position of the chunk beside an edge of a chunk from the chunk, with edges indexed like FChunk::Apron.
+*/
+static Vector3i EdgeOffset(const uint32_t Edge)
+{
+	const int32_t a = Edge / 4;
+	Vector3i Offset{ 0, 0, 0 };
+	Offset[(a + 1) % 3] = (Edge & 1) ? -1 : 1;
+	Offset[(a + 2) % 3] = (Edge & 2) ? -1 : 1;
+	return Offset;
+}
+
+/**
+* Gets the position of the chunk beside a corner of a chunk from the chunk, with corners indexed like FChunk::Apron.
+*/
+static Vector3i CornerOffset(const uint32_t Corner)
+{
+	return Vector3i{ (Corner & 1) ? -1 : 1, (Corner & 2) ? -1 : 1, (Corner & 4) ? -1 : 1 };
+}
+
+/**
+* Checks if two chunks both have blocks on the face, edge or corner they share. The blocks
+* of one can only cover or occlude the faces of the other where they do.
+* @param Offset - Position of the neighbor from the chunk. Each axis is -1, 0 or 1.
+*/
+static bool HaveBorderBlocks(const FChunk& Chunk, const FChunk& Neighbor, const Vector3i& Offset, const uint32_t Lod)
+{
+	FBlockTypes::BlockID Blocks[FChunk::CHUNK_SIZE * FChunk::CHUNK_SIZE];
+
+	// Bit set of the axes the neighbor is past the low side of the chunk along
+	uint32_t Low = 0;
+	uint32_t Axes = 0;
+	int32_t Along = 0;
+	for (int32_t d = 0; d < 3; d++)
+	{
+		Low |= (uint32_t)(Offset[d] < 0) << d;
+		Axes += (Offset[d] != 0);
+		Along = (Offset[d] == 0) ? d : Along;
+	}
+
+	if (Axes == 1)
+	{
+		const uint32_t Face = 2 * (Offset.x ? 0 : Offset.y ? 1 : 2) + (Low != 0);
+		return Chunk.ReadFace(Face, Blocks, Lod) && Neighbor.ReadFace(Face ^ 1, Blocks, Lod);
+	}
+
+	if (Axes == 2)
+	{
+		const uint32_t Edge = Along * 4 + ((Low >> ((Along + 1) % 3)) & 1) + 2 * ((Low >> ((Along + 2) % 3)) & 1);
+		return Chunk.ReadEdge(Edge, Blocks, Lod) && Neighbor.ReadEdge(Edge ^ 3, Blocks, Lod);
+	}
+
+	return Chunk.ReadCorner(Low, Lod) != FBlock::AIR_BLOCK_ID && Neighbor.ReadCorner(Low ^ 7, Lod) != FBlock::AIR_BLOCK_ID;
+}
 
 FChunkManager::FChunkManager()
 	: mFileSystem()
 	, mChunks(nullptr)
 	, mChunkPositions()
+	, mLoadedChunkPositions()
+	, mChunkStates(nullptr)
 	, mRenderList()
-	, mLoadList()
+	, mLoadQueue()
 	, mRebuildList()
-	, mBufferSwapQueue()
+	, mBufferSwapRing()
+	, mQueuedSwaps()
 	, mLoaderThread()
 	, mRebuildListMutex()
-	, mBufferSwapMutex()
+	, mLoaderMutex()
+	, mLoaderWake()
 	, mNeedsToRefreshVisibleList()
 	, mMustShutdown()
+	, mHibernateChunks()
+	, mCacheMeshes()
+	, mWorkerPool()
+	, mStreamJobs()
+	, mNextStreamJobs()
+	, mStreamStart(0)
+	, mStreamedChunks(0)
+	, mVisibleMin(0, 0, 0)
+	, mVisibleMax(-1, -1, -1)
+	, mQueueView(0)
+	, mQueueCenter()
+	, mQueueFrustum()
+	, mApronWaitList()
+	, mStreamRate()
+	, mStreamGovernor()
 	, mLastCameraChunk()
+	, mLastViewDirection()
+	, mViewCenter()
+	, mLoadDistance(DEFAULT_VIEW_DISTANCE)
+	, mViewFrustum()
+	, mLodCenter()
+	, mLodDistancesChanged()
 	, mWorldSize(0)
 	, mViewDistance(DEFAULT_VIEW_DISTANCE)
+	, mHorizontalShift(0)
+	, mVerticalShift(0)
 	, mPhysicsSystem(nullptr)
 	, mOnBlockDestroy()
 	, mOnBlockSet()
+	, mOnBlocksChanged()
 {
-	mChunks = new FChunk[DEFAULT_CHUNK_SIZE];
-	mChunkPositions = new Vector4i[DEFAULT_CHUNK_SIZE];
+	UpdateRingSize();
+	mChunks = new FChunk[ChunkCount()];
+	mChunkPositions = new Vector4i[ChunkCount()];
+	mLoadedChunkPositions = new Vector4i[ChunkCount()];
+	mChunkStates = new std::atomic<uint8_t>[ChunkCount()];
+	mBufferSwapRing.Init(ChunkCount());
+	mQueuedSwaps = 0;
 	mNeedsToRefreshVisibleList = false;
 	mMustShutdown = false;
+	mHibernateChunks = false;
+	mCacheMeshes = false;
+	mStreamRate = 0.0f;
+	mLodDistancesChanged = false;
+
+	mWorkerPool.Start(FChunkWorkerPool::DefaultWorkerCount());
+	mStreamJobs.resize(CHUNKS_TO_LOAD_PER_ITERATION * mWorkerPool.GetThreadCount());
+	mNextStreamJobs.resize(mStreamJobs.size());
+	mStreamGovernor.SetMaxViewDistanceCut(mViewDistance / 2);
+
+	for (uint32_t i = 0; i < FChunk::LOD_LEVELS - 1; i++)
+		mLodDistances[i] = DEFAULT_LOD_DISTANCES[i];
 }
 
 FChunkManager::~FChunkManager()
@@ -49,11 +170,14 @@ FChunkManager::~FChunkManager()
 	Shutdown();
 	delete[] mChunks;
 	delete[] mChunkPositions;
+	delete[] mLoadedChunkPositions;
+	delete[] mChunkStates;
 }
 
 void FChunkManager::Shutdown()
 {	
 	mMustShutdown = true;
+	WakeLoader();
 	if(mLoaderThread.joinable())
 		mLoaderThread.join();
 
@@ -62,9 +186,13 @@ void FChunkManager::Shutdown()
 	SwapChunkBuffers();
 	UnloadAllChunks();
 
-	mLoadList = std::queue<Vector3i>();
+	mLoadQueue.clear();
+	mVisibleMin = Vector3i{ 0, 0, 0 };
+	mVisibleMax = Vector3i{ -1, -1, -1 };
+	mApronWaitList.clear();
 	mRebuildList.clear();
 	mRenderList.clear();
+	mStreamStart = 0;
 
 	mMustShutdown = false;
 }
@@ -93,16 +221,34 @@ void FChunkManager::SetViewDistance(const uint32_t Distance)
 	InitializeWorld();
 }
 
+void FChunkManager::SetLodDistance(const uint32_t Lod, const uint32_t Distance)
+{
+	ASSERT(Lod > 0 && Lod < FChunk::LOD_LEVELS);
+	mLodDistances[Lod - 1] = Distance;
+	mLodDistancesChanged = true;
+
+	// Chunks are moved to their new levels by the loader thread once the view is refreshed.
+	// Zero directions never match the camera's, so the next update refreshes it.
+	mLastViewDirection = Vector3f{ 0.0f, 0.0f, 0.0f };
+}
+
 void FChunkManager::InitializeWorld()
 {
 	// Set chunk positions to invalid value
 	for (uint32_t i = 0; i < ChunkCount(); i++)
 	{
 		mChunkPositions[i] = Vector4i{ -1, -1, -1 };
+		mLoadedChunkPositions[i] = Vector4i{ -1, -1, -1 };
+		mChunkStates[i] = ChunkState::Empty;
 	}
 
-	// Activate loader thread
-	mNeedsToRefreshVisibleList = true;
+	// Swaps left over from the last world are dropped
+	mBufferSwapRing.Init(ChunkCount());
+	mQueuedSwaps = 0;
+
+	// Activate loader thread. It waits for the next update to give it a view to load.
+	mNeedsToRefreshVisibleList = false;
+	mLastViewDirection = Vector3f{ 0.0f, 0.0f, 0.0f };
 	mLoaderThread = std::thread(&FChunkManager::ChunkLoaderThreadLoop, this);
 }
 
@@ -115,13 +261,28 @@ void FChunkManager::ReallocateChunkData(const int32_t NewViewDistance)
 	}
 
 	mViewDistance = NewViewDistance;
+	mStreamGovernor.SetMaxViewDistanceCut(mViewDistance / 2);
+	UpdateRingSize();
 	const uint32_t NewSize = ChunkCount();
 
 	// Resize data
 	delete[] mChunks;
 	delete[] mChunkPositions;
+	delete[] mLoadedChunkPositions;
+	delete[] mChunkStates;
 	mChunks = new FChunk[NewSize];
 	mChunkPositions = new Vector4i[NewSize];
+	mLoadedChunkPositions = new Vector4i[NewSize];
+	mChunkStates = new std::atomic<uint8_t>[NewSize];
+}
+
+void FChunkManager::UpdateRingSize()
+{
+	// Height is half width. Dimensions are rounded up to powers of two so chunk
+	// positions can be wrapped into the ring with masks. Slots past the view distance
+	// are never loaded, but still hold a chunk and its buffers.
+	mHorizontalShift = CeilLog2(2 * mViewDistance + 1);
+	mVerticalShift = CeilLog2(mViewDistance + 1);
 }
 
 void FChunkManager::UnloadAllChunks()
@@ -131,9 +292,10 @@ void FChunkManager::UnloadAllChunks()
 	{
 		if (mChunks[i].IsLoaded())
 		{
-			const Vector3i UnloadChunkPosition = mChunkPositions[i];
+			// Chunks may still have their meshes waiting to be swapped in
+			const Vector3i UnloadChunkPosition = mLoadedChunkPositions[i];
 
-			if (UnloadChunkPosition.y != -1)
+			if ((mChunkStates[i] & ChunkState::StateMask) != ChunkState::Empty)
 			{
 				// Buffer for all chunk data
 				std::vector<uint8_t> ChunkData;
@@ -141,8 +303,9 @@ void FChunkManager::UnloadAllChunks()
 				// Unload the chunk currently in this index
 				mChunks[i].Unload(ChunkData);
 
-				// Write the data to file
-				mFileSystem.WriteChunkData(UnloadChunkPosition, ChunkData);
+				// Write the data to file. Chunks keeping cells were written when they were coarsened.
+				if (!ChunkData.empty())
+					mFileSystem.WriteChunkData(UnloadChunkPosition, ChunkData);
 			}
 		}
 	}
@@ -154,12 +317,19 @@ void FChunkManager::Render(FRenderSystem& Renderer, const GLenum RenderMode)
 {
 	UpdateRenderList();
 
+	const Vector3f CameraPosition = FCamera::Main->Transform.GetWorldPosition();
+
 	// Render everything in the renderlist
 	for (const auto& Index : mRenderList)
 	{
 		if (mChunks[Index].IsLoaded())
 		{
-			mChunks[Index].Render(RenderMode);
+			// Chunk meshes are built relative to the chunk
+			const Vector3i ChunkPosition = mChunkPositions[Index];
+			Renderer.SetChunkOrigin(ChunkPosition * FChunk::CHUNK_SIZE);
+
+			// Faces pointing away from the camera would be culled anyway
+			mChunks[Index].Render(RenderMode, FChunk::FacingFaces(ChunkPosition, CameraPosition));
 		}
 	}
 }
@@ -168,108 +338,557 @@ void FChunkManager::Update()
 {
 	// Get the chunk that the camera is currently in.
 	const Vector3i CameraChunk = FCamera::Main->Transform.GetWorldPosition() / FChunk::CHUNK_SIZE;
+	const Vector3f ViewDirection = FCamera::Main->Transform.GetRotation() * -Vector3f::Forward;
+
+	// The view distance may be stepped down while frames are over budget
+	mStreamGovernor.Update(STime::GetFrameTime());
+	const int32_t LoadDistance = mViewDistance - (int32_t)mStreamGovernor.GetViewDistanceCut();
 
-	// Only update visibility list when that camera crosses a chunk boundary
-	if (mLastCameraChunk != CameraChunk)
+	// Only update visibility list when that camera crosses a chunk boundary, turns
+	// far enough that chunks in view should be loaded first, or the view distance steps
+	if (mLastCameraChunk != CameraChunk || Vector3f::Dot(mLastViewDirection, ViewDirection) < VIEW_TURN_COSINE || mLoadDistance != LoadDistance)
 	{
 		mLastCameraChunk = CameraChunk;
-		mNeedsToRefreshVisibleList = true;
+		mLastViewDirection = ViewDirection;
+		RefreshView(CameraChunk, LoadDistance);
 	}
 
 	SwapChunkBuffers();
 }
 
+void FChunkManager::RefreshView(const Vector3i& CameraChunk, const int32_t LoadDistance)
+{
+	const FFrustum ViewFrustum = ChunkViewFrustum();
+
+	{
+		std::lock_guard<std::mutex> Lock(mLoaderMutex);
+		mViewCenter = CameraChunk;
+		mLoadDistance = LoadDistance;
+		mViewFrustum = ViewFrustum;
+		mNeedsToRefreshVisibleList = true;
+	}
+	mLoaderWake.notify_one();
+}
+
+FFrustum FChunkManager::ChunkViewFrustum() const
+{
+	// The the current view frustum in chunk coord
+	FMatrix4 ToChunkCoord;
+	ToChunkCoord.Scale(1.0f / (float)FChunk::CHUNK_SIZE);
+	ToChunkCoord.SetOrigin(-Vector3f{ 0.5f, 0.5f, 0.5f }); // align with center of chunks
+
+	FFrustum ViewFrustum = FCamera::Main->GetWorldViewFrustum();
+	ViewFrustum.TransformBy(ToChunkCoord);
+	return ViewFrustum;
+}
+
 void FChunkManager::SwapChunkBuffers()
 {
-	std::unique_lock<std::mutex> Lock(mBufferSwapMutex, std::try_to_lock);
+	FAllocationCounter::FScope CountAllocations;
 
-	if (Lock.owns_lock())
+	uint32_t SwapCount = 0;
+	uint32_t Index;
+
+	mStreamGovernor.BeginUploads();
+	while (!mStreamGovernor.IsUploadBudgetSpent() && mBufferSwapRing.Pop(Index))
 	{
-		int32_t SwapCount = MESH_SWAPS_PER_FRAME;
-		while (SwapCount > 0 && !mBufferSwapQueue.empty())
+		// Taking the slot clears its queued flag, so the loader thread queues it again from here on
+		uint8_t State = mChunkStates[Index];
+		uint8_t NewState;
+		do
+		{
+			NewState = (uint8_t)(State & ~ChunkState::Queued);
+			if ((State & ChunkState::StateMask) == ChunkState::Meshed)
+				NewState = (uint8_t)((NewState & ~ChunkState::StateMask) | ChunkState::Uploading);
+		} while (!mChunkStates[Index].compare_exchange_weak(State, NewState));
+
+		// Chunks taken back by the loader thread since they were queued are queued again once they are meshed
+		if ((State & ChunkState::StateMask) == ChunkState::Meshed)
 		{
-			const Vector3i ChunkPosition = mBufferSwapQueue.front();
-			mBufferSwapQueue.pop_front();
+			mStreamGovernor.AddUpload(mChunks[Index].SwapMeshBuffer(*mPhysicsSystem));
+			mChunkPositions[Index] = mLoadedChunkPositions[Index];
+			SetChunkState(Index, ChunkState::Uploaded);
+			SwapCount++;
+		}
+
+		mQueuedSwaps--;
+	}
+
+	// The loader thread may be waiting for the backlog to clear, or the last meshes of a stream to be swapped in
+	if (SwapCount > 0 && !IsSwapBacklogFull())
+		WakeLoader();
+}
 
-			const uint32_t Index = ChunkIndex(ChunkPosition);
+bool FChunkManager::IsSwapBacklogFull() const
+{
+	return mQueuedSwaps >= SWAP_BACKLOG_BATCHES * mStreamGovernor.GetLoadBatchSize((uint32_t)mStreamJobs.size());
+}
 
-			mChunks[Index].SwapMeshBuffer(*mPhysicsSystem);
+void FChunkManager::QueueBufferSwaps(const uint32_t JobCount)
+{
+	for (uint32_t i = 0; i < JobCount; i++)
+	{
+		const int32_t Index = mStreamJobs[i].Index;
+
+		// Slots still in the ring from before they were claimed are swapped by that entry
+		const uint8_t LastState = SetChunkState(Index, (uint8_t)(ChunkState::Meshed | ChunkState::Queued));
+		if (LastState & ChunkState::Queued)
+			continue;
 
-			mChunkPositions[Index] = Vector4i{ ChunkPosition, 1 };
-			SwapCount--;
+		// Each slot is in the ring at most once, so it can't fill up
+		mQueuedSwaps++;
+		const bool IsQueued = mBufferSwapRing.Push(Index);
+		ASSERT(IsQueued);
+	}
+}
+
+void FChunkManager::ClaimChunk(const int32_t Index, const bool IsReplacing)
+{
+	uint8_t State = mChunkStates[Index];
+	for (;;)
+	{
+		// The main thread is only ever uploading for a moment
+		if ((State & ChunkState::StateMask) == ChunkState::Uploading)
+		{
+			std::this_thread::yield();
+			State = mChunkStates[Index];
+			continue;
 		}
+
+		const uint8_t NewState = (uint8_t)((State & ChunkState::Queued) | ChunkState::Loading | (IsReplacing ? ChunkState::Replacing : 0));
+		if (mChunkStates[Index].compare_exchange_weak(State, NewState))
+			return;
 	}
 }
 
+bool FChunkManager::MarkChunkDirty(const int32_t Index)
+{
+	uint8_t State = mChunkStates[Index];
+	do
+	{
+		if ((State & ChunkState::StateMask) == ChunkState::Empty || (State & ChunkState::Dirty))
+			return false;
+	} while (!mChunkStates[Index].compare_exchange_weak(State, (uint8_t)(State | ChunkState::Dirty)));
+
+	return true;
+}
+
+int32_t FChunkManager::LockLoadedChunk(const Vector3i& Position, std::unique_lock<std::recursive_mutex>& LockOut) const
+{
+	const int32_t Index = LoadedChunkIndex(Position);
+	if (Index < 0)
+		return -1;
+
+	// The slot may have been claimed since it was checked. Once the lock is held, its blocks are
+	// only replaced after it is released.
+	LockOut = mChunks[Index].LockBlocks();
+	if (LoadedChunkIndex(Position) != Index)
+	{
+		LockOut.unlock();
+		return -1;
+	}
+
+	return Index;
+}
+
+uint8_t FChunkManager::SetChunkState(const int32_t Index, const uint8_t State)
+{
+	// Flags may be set by other threads at any time
+	uint8_t LastState = mChunkStates[Index];
+	while (!mChunkStates[Index].compare_exchange_weak(LastState, (uint8_t)((LastState & ~ChunkState::StateMask) | State)))
+	{
+	}
+
+	return LastState;
+}
+
 #undef min
 #undef max
 void FChunkManager::SetBlock(const Vector3i& Position, FBlockTypes::BlockID ID)
 {
-	int32_t BlockWorldSize = mWorldSize * FChunk::CHUNK_SIZE;
-
-	if (std::min({ Position.x, Position.y, Position.z }) >= 0 && std::max({ Position.x, Position.y, Position.z }) < BlockWorldSize)
+	// Only set if the right chunk is loaded and the block changes
+	bool IsSet;
+	bool IsRejected;
+	int32_t Index;
 	{
-		const Vector4i ChunkPosition = Vector4i(Position / FChunk::CHUNK_SIZE, 1);
-		const Vector3i LocalPosition = Vector3i{ Position.x % FChunk::CHUNK_SIZE, Position.y % FChunk::CHUNK_SIZE, Position.z % FChunk::CHUNK_SIZE };
+		std::unique_lock<std::recursive_mutex> ChunkLock;
+		Index = LockLoadedChunk(Position, ChunkLock);
+		IsRejected = (Index >= 0 && !mChunks[Index].IsEditable());
+		IsSet = (Index >= 0 && mChunks[Index].SetBlock(FChunk::LocalPosition(Position), ID));
+	}
 
-		int32_t Index = ChunkIndex(ChunkPosition);
+	if (IsRejected)
+		mOnEditRejected.Invoke(Position / FChunk::CHUNK_SIZE);
 
-		// Only set if the right chunk is loaded
-		if (ChunkPosition == mChunkPositions[Index])
-		{
-			mChunks[Index].SetBlock(LocalPosition, ID);
-			mOnBlockSet.Invoke(Position, ID);
+	if (IsSet)
+	{
+		mOnBlockSet.Invoke(Position, ID);
 
+		{
 			std::lock_guard<std::mutex> Lock(mRebuildListMutex);
-			if (std::find(mRebuildList.begin(), mRebuildList.end(), Index) == mRebuildList.end())
-				mRebuildList.push_back(Index);
+			AddToRebuildList(Index);
+			AddBorderNeighborsToRebuildList(Position);
 		}
+		WakeLoader();
 	}
 }
 
 FBlockTypes::BlockID FChunkManager::GetBlock(Vector3i Position) const
 {
-	int32_t BlockWorldSize = mWorldSize * FChunk::CHUNK_SIZE;
+	std::unique_lock<std::recursive_mutex> ChunkLock;
+	const int32_t Index = LockLoadedChunk(Position, ChunkLock);
 
-	if (std::min({ Position.x, Position.y, Position.z }) >= 0 && std::max({ Position.x, Position.y, Position.z }) < BlockWorldSize)
+	// Only get if the right chunk is loaded
+	if (Index >= 0)
+		return mChunks[Index].GetBlockLocked(FChunk::LocalPosition(Position));
+
+	return FBlock::AIR_BLOCK_ID;
+}
+
+void FChunkManager::DestroyBlock(const Vector3i& Position)
+{
+	// Only destroy if the right chunk is loaded
+	FBlockTypes::BlockID ID = FBlock::AIR_BLOCK_ID;
+	bool IsRejected = false;
+	int32_t Index;
 	{
-		const Vector4i ChunkPosition = Vector4i(Position / FChunk::CHUNK_SIZE, 1);
-		Position = Vector3i{ Position.x % FChunk::CHUNK_SIZE, Position.y % FChunk::CHUNK_SIZE, Position.z % FChunk::CHUNK_SIZE };
+		std::unique_lock<std::recursive_mutex> ChunkLock;
+		Index = LockLoadedChunk(Position, ChunkLock);
+		if (Index >= 0)
+		{
+			IsRejected = !mChunks[Index].IsEditable();
+			ID = mChunks[Index].DestroyBlock(FChunk::LocalPosition(Position));
+		}
+	}
+
+	if (IsRejected)
+		mOnEditRejected.Invoke(Position / FChunk::CHUNK_SIZE);
+
+	if (ID == FBlock::AIR_BLOCK_ID)
+		return;
 
-		int32_t Index = ChunkIndex(ChunkPosition);
+	mOnBlockDestroy.Invoke(Position, ID);
 
-		// Only get if the right chunk is loaded
-		if (ChunkPosition == mChunkPositions[Index])
+	{
+		std::lock_guard<std::mutex> Lock(mRebuildListMutex);
+		AddToRebuildList(Index);
+		AddBorderNeighborsToRebuildList(Position);
+	}
+	WakeLoader();
+}
+
+void FChunkManager::ApplyEdit(const FBlockEdit& Edit)
+{
+	const int32_t BlockWorldSize = mWorldSize * FChunk::CHUNK_SIZE;
+	const Vector3i WorldMax{ BlockWorldSize - 1, BlockWorldSize - 1, BlockWorldSize - 1 };
+
+	// Chunks are keyed by their position so they can be sorted and grouped
+	auto ChunkKey = [this](const Vector3i& ChunkPosition)
+	{
+		return (uint32_t)((ChunkPosition.y * mWorldSize + ChunkPosition.z) * mWorldSize + ChunkPosition.x);
+	};
+
+	// Find every chunk touched by the edit, and which chunk each voxel falls in
+	std::vector<uint32_t> ChunkKeys;
+	std::vector<std::pair<uint32_t, uint32_t>> VoxelKeys; // Chunk key and voxel index
+	const std::vector<FBlockEdit::FVoxel>& Voxels = Edit.GetVoxels();
+
+	for (const auto& Operation : Edit.GetOperations())
+	{
+		if (Operation.Shape == FBlockEdit::EShape::Voxels)
 		{
-			return mChunks[Index].GetBlock(Position);
+			for (uint32_t i = Operation.FirstVoxel; i < Operation.FirstVoxel + Operation.VoxelCount; i++)
+			{
+				const Vector3i& Position = Voxels[i].Position;
+				if (std::min({ Position.x, Position.y, Position.z }) >= 0 && std::max({ Position.x, Position.y, Position.z }) < BlockWorldSize)
+					VoxelKeys.push_back(std::make_pair(ChunkKey(Position / FChunk::CHUNK_SIZE), i));
+			}
+
+			continue;
 		}
+
+		const Vector3i Min{ std::max(Operation.Min.x, 0), std::max(Operation.Min.y, 0), std::max(Operation.Min.z, 0) };
+		const Vector3i Max{ std::min(Operation.Max.x, WorldMax.x), std::min(Operation.Max.y, WorldMax.y), std::min(Operation.Max.z, WorldMax.z) };
+		if (Min.x > Max.x || Min.y > Max.y || Min.z > Max.z)
+			continue;
+
+		const Vector3i MinChunk = Min / FChunk::CHUNK_SIZE;
+		const Vector3i MaxChunk = Max / FChunk::CHUNK_SIZE;
+		for (int32_t y = MinChunk.y; y <= MaxChunk.y; y++)
+			for (int32_t z = MinChunk.z; z <= MaxChunk.z; z++)
+				for (int32_t x = MinChunk.x; x <= MaxChunk.x; x++)
+					ChunkKeys.push_back(ChunkKey(Vector3i{ x, y, z }));
 	}
 
-	return FBlock::AIR_BLOCK_ID;
+	for (const auto& VoxelKey : VoxelKeys)
+		ChunkKeys.push_back(VoxelKey.first);
+
+	std::sort(ChunkKeys.begin(), ChunkKeys.end());
+	ChunkKeys.erase(std::unique(ChunkKeys.begin(), ChunkKeys.end()), ChunkKeys.end());
+	std::sort(VoxelKeys.begin(), VoxelKeys.end());
+
+	// Write each chunk once
+	std::vector<FBlockChange> Changes;
+	std::vector<uint32_t> ChunkVoxels;
+	std::vector<int32_t> ChangedChunks;
+	std::vector<Vector3i> RejectedChunks;
+	auto NextVoxel = VoxelKeys.begin();
+
+	for (const uint32_t Key : ChunkKeys)
+	{
+		ChunkVoxels.clear();
+		for (; NextVoxel != VoxelKeys.end() && NextVoxel->first == Key; NextVoxel++)
+			ChunkVoxels.push_back(NextVoxel->second);
+
+		const Vector3i ChunkPosition{ (int32_t)(Key % mWorldSize), (int32_t)(Key / (mWorldSize * mWorldSize)), (int32_t)(Key / mWorldSize % mWorldSize) };
+
+		// Only edit if the right chunk is loaded
+		std::unique_lock<std::recursive_mutex> ChunkLock;
+		const int32_t Index = LockLoadedChunk(ChunkPosition * FChunk::CHUNK_SIZE, ChunkLock);
+		if (Index < 0)
+			continue;
+
+		if (!mChunks[Index].IsEditable())
+		{
+			RejectedChunks.push_back(ChunkPosition);
+			continue;
+		}
+
+		if (mChunks[Index].ApplyEdit(Edit, ChunkPosition * FChunk::CHUNK_SIZE, ChunkVoxels.data(), (uint32_t)ChunkVoxels.size(), Changes))
+			ChangedChunks.push_back(Index);
+	}
+
+	for (const Vector3i& ChunkPosition : RejectedChunks)
+		mOnEditRejected.Invoke(ChunkPosition);
+
+	if (ChangedChunks.empty())
+		return;
+
+	{
+		std::lock_guard<std::mutex> Lock(mRebuildListMutex);
+		for (const int32_t Index : ChangedChunks)
+			AddToRebuildList(Index);
+
+		for (const auto& Change : Changes)
+			AddBorderNeighborsToRebuildList(Change.Position);
+	}
+	WakeLoader();
+
+	mOnBlocksChanged.Invoke(Changes);
 }
 
-void FChunkManager::DestroyBlock(const Vector3i& Position)
+void FChunkManager::AddToRebuildList(const int32_t Index)
+{
+	if (mChunkStates[Index] & ChunkState::Waiting)
+		return;
+
+	// The dirty flag is cleared when the chunk is claimed to be rebuilt, so a chunk is only listed once
+	if (MarkChunkDirty(Index))
+		mRebuildList.push_back(Index);
+}
+
+void FChunkManager::AddBorderNeighborsToRebuildList(const Vector3i& Position)
+{
+	const Vector3i LocalPosition = FChunk::LocalPosition(Position);
+
+	// Blocks on the low side of a chunk border the chunk before it, and blocks on the high side
+	// border the chunk after it
+	Vector3i Step{ 0, 0, 0 };
+	for (int32_t d = 0; d < 3; d++)
+		Step[d] = (LocalPosition[d] == 0) ? -1 : (LocalPosition[d] == FChunk::CHUNK_SIZE - 1) ? 1 : 0;
+
+	// Blocks on an edge or corner also occlude faces in the chunks diagonal to it
+	for (uint32_t Axes = 1; Axes < 8; Axes++)
+	{
+		Vector3i Offset{ 0, 0, 0 };
+		bool IsOnBorder = true;
+		for (int32_t d = 0; d < 3; d++)
+		{
+			if ((Axes >> d) & 1)
+			{
+				Offset[d] = Step[d];
+				IsOnBorder &= (Step[d] != 0);
+			}
+		}
+
+		if (!IsOnBorder)
+			continue;
+
+		const int32_t Neighbor = LoadedChunkIndex(Position + Offset);
+		if (Neighbor >= 0)
+			RebuildBorder(Neighbor, Offset);
+	}
+}
+
+void FChunkManager::RebuildBorder(const int32_t Neighbor, const Vector3i& Offset)
+{
+	// The neighbor's faces toward the chunk are on the opposite side of each axis
+	for (int32_t d = 0; d < 3; d++)
+	{
+		if (Offset[d] != 0)
+			mChunks[Neighbor].MarkBorderDirty(2 * d + (Offset[d] > 0));
+	}
+
+	AddToRebuildList(Neighbor);
+}
+
+int32_t FChunkManager::LoadedNeighborIndex(const Vector3i& ChunkPosition, const uint32_t Face) const
+{
+	// Positive faces are even
+	Vector3i Offset{ 0, 0, 0 };
+	Offset[Face / 2] = (Face & 1) ? -1 : 1;
+	return LoadedNeighborIndex(ChunkPosition, Offset);
+}
+
+int32_t FChunkManager::LoadedNeighborIndex(const Vector3i& ChunkPosition, const Vector3i& Offset) const
 {
-	int32_t BlockWorldSize = mWorldSize * FChunk::CHUNK_SIZE;
+	const Vector3i NeighborPosition = ChunkPosition + Offset;
+	if (!IsInWorld(NeighborPosition))
+		return -1;
 
-	if (std::min({ Position.x, Position.y, Position.z }) >= 0 && std::max({ Position.x, Position.y, Position.z }) < BlockWorldSize)
+	const int32_t Index = ChunkIndex(NeighborPosition);
+	return (mLoadedChunkPositions[Index] == Vector4i(NeighborPosition, 1)) ? Index : -1;
+}
+
+bool FChunkManager::IsInWorld(const Vector3i& ChunkPosition) const
+{
+	// Negative positions wrap to large unsigned values
+	return (uint32_t)ChunkPosition.x < (uint32_t)mWorldSize && (uint32_t)ChunkPosition.y < (uint32_t)mWorldSize && (uint32_t)ChunkPosition.z < (uint32_t)mWorldSize;
+}
+
+bool FChunkManager::GatherApron(const Vector3i& ChunkPosition, const uint32_t Lod, FChunk::Apron& ApronOut) const
+{
+	bool IsComplete = true;
+	for (uint32_t Face = 0; Face < 6; Face++)
 	{
-		const Vector4i ChunkPosition = Vector4i(Position / FChunk::CHUNK_SIZE, 1);
-		const Vector3i LocalPosition = Vector3i{ Position.x % FChunk::CHUNK_SIZE, Position.y % FChunk::CHUNK_SIZE, Position.z % FChunk::CHUNK_SIZE };
+		const int32_t Neighbor = LoadedNeighborIndex(ChunkPosition, Face);
 
-		int32_t Index = ChunkIndex(ChunkPosition);
+		// Faces next to chunks that aren't loaded, the edge of the world and chunks at another
+		// level of detail are kept. Borders between levels are closed on both sides, so no
+		// cracks open where the cells of each side don't line up.
+		if (Neighbor >= 0 && LodLevel(mLoadedChunkPositions[Neighbor]) == Lod && !IsAwaitingReload(Neighbor))
+		{
+			mChunks[Neighbor].ReadFace(Face ^ 1, ApronOut.Blocks[Face], Lod);
+		}
+		else
+		{
+			std::fill(ApronOut.Blocks[Face], ApronOut.Blocks[Face] + FChunk::CHUNK_SIZE * FChunk::CHUNK_SIZE, (FBlockTypes::BlockID)FBlock::AIR_BLOCK_ID);
 
-		// Only destroy if the right chunk is loaded
-		if (ChunkPosition == mChunkPositions[Index])
+			// Only faces next to chunks that are still to be loaded will change
+			Vector3i NeighborPosition = ChunkPosition;
+			NeighborPosition[Face / 2] += (Face & 1) ? -1 : 1;
+			IsComplete &= (Neighbor >= 0) ? !IsAwaitingReload(Neighbor) : !IsInWorld(NeighborPosition);
+		}
+	}
+
+	// Edges and corners only occlude faces, and are gathered the same way
+	for (uint32_t Edge = 0; Edge < 12; Edge++)
+	{
+		const int32_t Neighbor = LoadedNeighborIndex(ChunkPosition, EdgeOffset(Edge));
+		if (Neighbor >= 0 && LodLevel(mLoadedChunkPositions[Neighbor]) == Lod && !IsAwaitingReload(Neighbor))
 		{
-			const FBlockTypes::BlockID ID = mChunks[Index].DestroyBlock(LocalPosition);
-			mOnBlockDestroy.Invoke(Position, ID);
+			mChunks[Neighbor].ReadEdge(Edge ^ 3, ApronOut.Edges[Edge], Lod);
+		}
+		else
+		{
+			std::fill(ApronOut.Edges[Edge], ApronOut.Edges[Edge] + FChunk::CHUNK_SIZE, (FBlockTypes::BlockID)FBlock::AIR_BLOCK_ID);
+			IsComplete &= (Neighbor >= 0) ? !IsAwaitingReload(Neighbor) : !IsInWorld(ChunkPosition + EdgeOffset(Edge));
+		}
+	}
 
-			std::lock_guard<std::mutex> Lock(mRebuildListMutex);
-			if (std::find(mRebuildList.begin(), mRebuildList.end(), Index) == mRebuildList.end())
-				mRebuildList.push_back(Index);
+	for (uint32_t Corner = 0; Corner < 8; Corner++)
+	{
+		const int32_t Neighbor = LoadedNeighborIndex(ChunkPosition, CornerOffset(Corner));
+		if (Neighbor >= 0 && LodLevel(mLoadedChunkPositions[Neighbor]) == Lod && !IsAwaitingReload(Neighbor))
+		{
+			ApronOut.Corners[Corner] = mChunks[Neighbor].ReadCorner(Corner ^ 7, Lod);
 		}
+		else
+		{
+			ApronOut.Corners[Corner] = FBlock::AIR_BLOCK_ID;
+			IsComplete &= (Neighbor >= 0) ? !IsAwaitingReload(Neighbor) : !IsInWorld(ChunkPosition + CornerOffset(Corner));
+		}
+	}
+
+	return IsComplete;
+}
+
+FMeshCacheFile* FChunkManager::GetMeshCacheFile(const Vector3i& ChunkPosition, const bool IsApronComplete)
+{
+	if (!mCacheMeshes || !IsApronComplete)
+		return nullptr;
+
+	return mFileSystem.GetMeshCacheFile(ChunkPosition);
+}
+
+void FChunkManager::RebuildNeighbors(const int32_t Index, const Vector3i& ChunkPosition)
+{
+	const uint32_t Lod = LodLevel(ChunkPosition);
+
+	// The chunks beside each face, edge and corner
+	for (int32_t i = 0; i < 27; i++)
+	{
+		const Vector3i Offset{ i % 3 - 1, i / 3 % 3 - 1, i / 9 - 1 };
+		if (Offset == Vector3i{ 0, 0, 0 })
+			continue;
+
+		const int32_t Neighbor = LoadedNeighborIndex(ChunkPosition, Offset);
+
+		// Faces can only be covered or occluded where both chunks have blocks on their shared
+		// border, and never by chunks at another level of detail
+		if (Neighbor < 0 || LodLevel(mLoadedChunkPositions[Neighbor]) != Lod)
+			continue;
+
+		// Chunks in the batch are the only ones the loader thread owns. Chunks waiting to be
+		// loaded again gather this chunk's blocks when they are.
+		if ((mChunkStates[Neighbor] & ChunkState::StateMask) == ChunkState::Loading || IsAwaitingReload(Neighbor))
+			continue;
+
+		if (!HaveBorderBlocks(mChunks[Index], mChunks[Neighbor], Offset, Lod))
+			continue;
+
+		std::lock_guard<std::mutex> Lock(mRebuildListMutex);
+		RebuildBorder(Neighbor, Offset);
+	}
+}
+
+bool FChunkManager::MustWaitForApron(const Vector3i& ChunkPosition) const
+{
+	if (!mCacheMeshes)
+		return false;
+
+	// The chunks around the camera are meshed right away, as the camera collides with them
+	const Vector3i Offset = ChunkPosition - mLodCenter;
+	if (std::max({ std::abs(Offset.x), std::abs(Offset.y), std::abs(Offset.z) }) <= 1)
+		return false;
+
+	return IsApronPending(ChunkPosition);
+}
+
+bool FChunkManager::IsApronPending(const Vector3i& ChunkPosition) const
+{
+	for (int32_t i = 0; i < 27; i++)
+	{
+		const Vector3i Offset{ i % 3 - 1, i / 3 % 3 - 1, i / 9 - 1 };
+		const Vector3i Position = ChunkPosition + Offset;
+
+		// Every chunk in the load range that isn't loaded is still to be loaded
+		if (IsInLoadRange(Position) && LoadedNeighborIndex(ChunkPosition, Offset) < 0)
+			return true;
 	}
+
+	return false;
+}
+
+void FChunkManager::RebuildIfApronLoaded(const int32_t Index)
+{
+	if (!(mChunkStates[Index] & ChunkState::Waiting) || IsApronPending(mLoadedChunkPositions[Index]))
+		return;
+
+	mChunkStates[Index] &= (uint8_t)~ChunkState::Waiting;
+
+	std::lock_guard<std::mutex> Lock(mRebuildListMutex);
+	AddToRebuildList(Index);
 }
 
 void FChunkManager::SetPhysicsSystem(FPhysicsSystem& Physics)
@@ -277,188 +896,593 @@ void FChunkManager::SetPhysicsSystem(FPhysicsSystem& Physics)
 	mPhysicsSystem = &Physics;
 }
 
+void FChunkManager::SetChunkHibernation(const bool Enabled)
+{
+	mHibernateChunks = Enabled;
+}
+
+void FChunkManager::SetMeshCaching(const bool Enabled)
+{
+	mCacheMeshes = Enabled;
+}
+
+void FChunkManager::SetFrameBudget(const float Milliseconds)
+{
+	mStreamGovernor.SetTargetFrameTime(Milliseconds / 1000.0f);
+}
+
+void FChunkManager::SetViewDistanceScaling(const bool Enabled)
+{
+	mStreamGovernor.SetViewScaling(Enabled);
+}
+
+const FStreamGovernor& FChunkManager::GetStreamGovernor() const
+{
+	return mStreamGovernor;
+}
+
+float FChunkManager::GetStreamRate() const
+{
+	return mStreamRate;
+}
+
+uint32_t FChunkManager::GetStreamThreadCount() const
+{
+	return mWorkerPool.GetThreadCount();
+}
+
 void FChunkManager::ChunkLoaderThreadLoop()
 {
+	FAllocationCounter::FScope CountAllocations;
+
 	while (!mMustShutdown)
 	{
-		while (!mMustShutdown && !mNeedsToRefreshVisibleList)
-		{
-			UpdateRebuildList();
-			UpdateLoadList();
-		}
+		if (mNeedsToRefreshVisibleList.exchange(false))
+			UpdateVisibleList();
+
+		UpdateRebuildList();
+		UpdateLoadList();
+		UpdateStreamRate();
 
-		mNeedsToRefreshVisibleList = false;
-		UpdateVisibleList();
+		// Sleep until there is more to do
+		std::unique_lock<std::mutex> Lock(mLoaderMutex);
+		mLoaderWake.wait(Lock, [this]{ return HasLoaderWork(); });
 	}
+
+	// Hand cached block pages back before the thread slot is given up
+	FBlockStorage::FlushThreadCache();
+	FThreadSlot::Release();
+}
+
+bool FChunkManager::HasLoaderWork()
+{
+	if (mMustShutdown || mNeedsToRefreshVisibleList || (!mLoadQueue.empty() && !IsSwapBacklogFull()))
+		return true;
+
+	{
+		std::lock_guard<std::mutex> RebuildLock(mRebuildListMutex);
+		if (!mRebuildList.empty())
+			return true;
+	}
+
+	return mStreamStart != 0 && IsStreamFinished();
+}
+
+void FChunkManager::WakeLoader()
+{
+	// Taking the lock makes sure the loader thread is either asleep or has yet to check for work
+	{
+		std::lock_guard<std::mutex> Lock(mLoaderMutex);
+	}
+	mLoaderWake.notify_one();
 }
 
 void FChunkManager::UpdateLoadList()
 {
-	uint32_t LoadsLeft = CHUNKS_TO_LOAD_PER_ITERATION;
+	// Chunks are only loaded as fast as the main thread can swap them in
+	if (mLoadQueue.empty() || IsSwapBacklogFull())
+		return;
 
-	std::unique_lock<std::mutex> BufferSwapLock(mBufferSwapMutex, std::defer_lock);
+	uint32_t JobCount = ClaimLoadJobs(mStreamJobs);
+	if (JobCount == 0)
+		return;
 
-	// Buffer for all chunk data
-	std::vector<uint8_t> ChunkData;
-	while (!mLoadList.empty() && LoadsLeft > 0)
+	// Time how long the view takes to fill from the first chunk loaded
+	if (mStreamStart == 0)
 	{
-		Vector3i ChunkPosition = mLoadList.front();
-		mLoadList.pop();
+		mStreamStart = FClock::ReadSystemTimer();
+		mStreamedChunks = 0;
+	}
 
-		const uint32_t Index = ChunkIndex(ChunkPosition);
+	ReadChunkData(mStreamJobs, JobCount);
 
-		// Get region position info for unloaded chunk
-		Vector3i UnloadChunkPosition = mChunkPositions[Index];
+	// Consecutive batches overlap. The blocks of the next batch are read while the workers
+	// mesh this one, so the workers don't sit idle while region files are read.
+	for (uint32_t Batch = 1; JobCount > 0; Batch++)
+	{
+		LoadStreamJobs(JobCount);
+
+		// Blocks of newly loaded chunks are rarely needed again after meshing
+		MeshStreamJobs(JobCount, mHibernateChunks);
 
-		// If this chunk is already in the swap list, remove it. This prevents redundant buffer swaps and
-		// tells us which chunk position is really currently loaded within the chunk data.
-		BufferSwapLock.lock();
-		auto InSwapList = std::find(mBufferSwapQueue.begin(), mBufferSwapQueue.end(), ChunkPosition);
-		if (InSwapList != mBufferSwapQueue.end())
+		// The pipeline is drained every few batches, so rebuilds and view changes aren't held up
+		uint32_t NextJobCount = 0;
+		if (Batch < PIPELINED_LOAD_BATCHES && !mNeedsToRefreshVisibleList && !mMustShutdown && !IsSwapBacklogFull())
 		{
-			UnloadChunkPosition = *InSwapList;
-			mBufferSwapQueue.erase(InSwapList);
+			NextJobCount = ClaimLoadJobs(mNextStreamJobs);
+			ReadChunkData(mNextStreamJobs, NextJobCount);
 		}
-		BufferSwapLock.unlock();
 
-		///// Unload Chunk ////////////////////////////////////////////////////////////////
-		///////////////////////////////////////////////////////////////////////////////////
-		if (mChunks[Index].IsLoaded())
+		mWorkerPool.Wait();
+		SaveCoarsenedChunks(JobCount);
+		QueueBufferSwaps(JobCount);
+		mStreamedChunks += JobCount;
+
+		for (uint32_t i = 0; i < JobCount; i++)
 		{
-			// Unload the chunk currently in this index
-			mChunks[Index].Unload(ChunkData);
+			if (mStreamJobs[i].IsWaiting)
+			{
+				mChunkStates[mStreamJobs[i].Index] |= ChunkState::Waiting;
+				mApronWaitList.push_back(mStreamJobs[i].Index);
+			}
+		}
+
+		mStreamJobs.swap(mNextStreamJobs);
+		JobCount = NextJobCount;
+	}
+}
+
+uint32_t FChunkManager::ClaimLoadJobs(std::vector<StreamJob>& Jobs)
+{
+	const uint32_t BatchSize = mStreamGovernor.GetLoadBatchSize((uint32_t)Jobs.size());
+	uint32_t JobCount = 0;
+
+	while (!mLoadQueue.empty() && JobCount < BatchSize)
+	{
+		// Requests are rescored for the current view when they reach the front, and requests of
+		// chunks that left the range are dropped. Rescored requests go back in the queue, as
+		// others may now come before them.
+		if (mLoadQueue.front().View != mQueueView)
+		{
+			std::pop_heap(mLoadQueue.begin(), mLoadQueue.end());
+			LoadRequest& Request = mLoadQueue.back();
+			if (!IsInLoadRange(Request.Position))
+			{
+				mLoadQueue.pop_back();
+				continue;
+			}
 
-			ASSERT(UnloadChunkPosition.y != -1);
-			// Write the data to file
-			mFileSystem.WriteChunkData(UnloadChunkPosition, ChunkData);
-			mFileSystem.RemoveRegionFileReference(UnloadChunkPosition);
+			Request.Priority = LoadPriority(Request.Position, mQueueCenter, mQueueFrustum);
+			Request.View = mQueueView;
+			std::push_heap(mLoadQueue.begin(), mLoadQueue.end());
+			continue;
 		}
 
-		///// Load Chunk /////////////////////////////////////////////////////////////////////
-		//////////////////////////////////////////////////////////////////////////////////////
-		
+		const LoadRequest Request = mLoadQueue.front();
+		const Vector3i ChunkPosition = Request.Position;
+		const int32_t Index = ChunkIndex(ChunkPosition);
+
+		// Positions that wrap to a chunk already in a batch wait for the next one
+		if ((mChunkStates[Index] & ChunkState::StateMask) == ChunkState::Loading)
+			break;
+
+		std::pop_heap(mLoadQueue.begin(), mLoadQueue.end());
+		mLoadQueue.pop_back();
+
+		// Chunks that are loaded but haven't had their mesh swapped in yet are already done,
+		// unless they keep cells too coarse for their level
+		if (mLoadedChunkPositions[Index] == Vector4i(ChunkPosition, 1) && !IsAwaitingReload(Index))
+			continue;
+
+		StreamJob& Job = Jobs[JobCount++];
+		Job.Position = ChunkPosition;
+		Job.UnloadPosition = mLoadedChunkPositions[Index];
+		Job.Index = Index;
+		Job.NeedsRebuild = false;
+		Job.IsWaiting = false;
+		Job.MeshFile = nullptr;
+
+		// Swaps queued for the blocks the chunk held before are skipped, as the back buffer is rebuilt
+		ClaimChunk(Index, true);
+	}
+
+	return JobCount;
+}
+
+void FChunkManager::ReadChunkData(std::vector<StreamJob>& Jobs, const uint32_t JobCount)
+{
+	// A chunk's new position never holds blocks unloaded in the same batch, so reads don't wait
+	// for the writes of the chunks unloaded to make room
+	for (uint32_t i = 0; i < JobCount; i++)
+	{
+		StreamJob& Job = Jobs[i];
+
 		// Get info for chunk data within its region
-		ChunkData.clear();
-		mFileSystem.AddRegionFileReference(ChunkPosition);
-		mFileSystem.GetChunkData(ChunkPosition, ChunkData);
-	
-		// Load and build the chunk
-		Vector3i WorldPosition = ChunkPosition * FChunk::CHUNK_SIZE;
-		bool DoesntNeedRebuild = mChunks[Index].Load(ChunkData);
+		Job.BlockData.clear();
+		Job.CellLod = 0;
+		mFileSystem.AddRegionFileReference(Job.Position);
+
+		// Chunks far enough to be coarsened read the cells they were last coarsened to, if they
+		// are fine enough for their level, in place of reading and merging their blocks
+		const uint32_t Lod = LodLevel(Job.Position);
+		FMeshCacheFile* MeshFile = (mCacheMeshes && Lod >= CELL_STORAGE_LOD) ? mFileSystem.GetMeshCacheFile(Job.Position) : nullptr;
+		if (!MeshFile || !MeshFile->ReadCells(Job.Position, Lod, Job.BlockData, Job.CellLod))
+			mFileSystem.GetChunkData(Job.Position, Job.BlockData);
+	}
+}
 
-		if (!DoesntNeedRebuild)
-			mChunks[Index].RebuildMesh(WorldPosition);
+void FChunkManager::LoadStreamJobs(const uint32_t JobCount)
+{
+	///// Unload Chunks //////////////////////////////////////////////////////////////////
+	//////////////////////////////////////////////////////////////////////////////////////
+	mWorkerPool.Run(JobCount, [this](uint32_t i)
+	{
+		StreamJob& Job = mStreamJobs[i];
+		Job.UnloadData.clear();
+		Job.IsUnloading = mChunks[Job.Index].IsLoaded();
+		if (Job.IsUnloading)
+			mChunks[Job.Index].Unload(Job.UnloadData);
+	});
+
+	///// Region I/O /////////////////////////////////////////////////////////////////////
+	//////////////////////////////////////////////////////////////////////////////////////
+	for (uint32_t i = 0; i < JobCount; i++)
+	{
+		StreamJob& Job = mStreamJobs[i];
+		if (Job.IsUnloading)
+		{
+			ASSERT(Job.UnloadPosition.y != -1);
+			// Write the data to file. Chunks keeping cells were written when they were coarsened.
+			if (!Job.UnloadData.empty())
+				mFileSystem.WriteChunkData(Job.UnloadPosition, Job.UnloadData);
+			mFileSystem.RemoveRegionFileReference(Job.UnloadPosition);
+		}
+	}
+
+	///// Decode Chunks //////////////////////////////////////////////////////////////////
+	//////////////////////////////////////////////////////////////////////////////////////
+	mWorkerPool.Run(JobCount, [this](uint32_t i)
+	{
+		StreamJob& Job = mStreamJobs[i];
+		Job.NeedsRebuild = (Job.CellLod != 0) ? !mChunks[Job.Index].LoadCells(Job.BlockData, Job.CellLod) : !mChunks[Job.Index].Load(Job.BlockData);
+	});
+
+	// The main thread can use the blocks once the slots hold their new positions
+	for (uint32_t i = 0; i < JobCount; i++)
+	{
+		mLoadedChunkPositions[mStreamJobs[i].Index] = Vector4i{ mStreamJobs[i].Position, 1 };
+		mChunkStates[mStreamJobs[i].Index] &= (uint8_t)~ChunkState::Replacing;
+	}
+
+	// Loaded neighbors may have border faces that these chunks now cover. Chunks in the
+	// same batch see each other's blocks when their neighbors are gathered.
+	for (uint32_t i = 0; i < JobCount; i++)
+	{
+		if (mStreamJobs[i].NeedsRebuild)
+			RebuildNeighbors(mStreamJobs[i].Index, mStreamJobs[i].Position);
+	}
 
-		BufferSwapLock.lock();
-			mBufferSwapQueue.push_back(ChunkPosition);
-		BufferSwapLock.unlock();
+	// Chunks still waiting on the rest of their neighbors are swapped in empty, and chunks that
+	// were waiting on these are meshed now that their neighbors are all loaded
+	for (uint32_t i = 0; i < JobCount; i++)
+	{
+		StreamJob& Job = mStreamJobs[i];
+		for (int32_t n = 0; n < 27; n++)
+		{
+			const Vector3i Offset{ n % 3 - 1, n / 3 % 3 - 1, n / 9 - 1 };
+			const int32_t Neighbor = (Offset == Vector3i{ 0, 0, 0 }) ? -1 : LoadedNeighborIndex(Job.Position, Offset);
+			if (Neighbor >= 0)
+				RebuildIfApronLoaded(Neighbor);
+		}
 
-		ChunkData.clear();
-		LoadsLeft--;
+		if (Job.NeedsRebuild && MustWaitForApron(Job.Position))
+		{
+			Job.NeedsRebuild = false;
+			Job.IsWaiting = true;
+		}
 	}
 }
 
 void FChunkManager::UpdateRebuildList()
 {
-	std::unique_lock<std::mutex> RebuildLock(mRebuildListMutex);
-	std::unique_lock<std::mutex> BufferSwapLock(mBufferSwapMutex, std::defer_lock);
+	const uint32_t BatchSize = (uint32_t)mStreamJobs.size();
 
-	while (!mRebuildList.empty())
+	for (;;)
 	{
-		int32_t ChunkIndex = mRebuildList.front();
-		mRebuildList.pop_front();
-		RebuildLock.unlock();
-
-		const Vector3i ChunkPosition = mChunkPositions[ChunkIndex];
-		if (ChunkPosition.y != -1)
+		uint32_t JobCount = 0;
 		{
-			// Check if its already in the swap list and remove if it is.
-			BufferSwapLock.lock();
-			auto InSwapList = std::find(mBufferSwapQueue.begin(), mBufferSwapQueue.end(), ChunkPosition);
-			if (InSwapList != mBufferSwapQueue.end())
-				mBufferSwapQueue.erase(InSwapList);
-			BufferSwapLock.unlock();
-
-			mChunks[ChunkIndex].RebuildMesh(ChunkPosition * FChunk::CHUNK_SIZE);
-
-			BufferSwapLock.lock();
-				mBufferSwapQueue.push_back(mChunkPositions[ChunkIndex]);
-			BufferSwapLock.unlock();
+			std::lock_guard<std::mutex> RebuildLock(mRebuildListMutex);
+			while (!mRebuildList.empty() && JobCount < BatchSize)
+			{
+				const int32_t ChunkIndex = mRebuildList.front();
+				mRebuildList.pop_front();
+
+				// Chunks reloaded since they were listed have already been rebuilt
+				if (!(mChunkStates[ChunkIndex] & ChunkState::Dirty))
+					continue;
+
+				// Chunks keeping cells too coarse for their level are rebuilt once they are loaded again
+				if (IsAwaitingReload(ChunkIndex))
+					continue;
+
+				// Meshes waiting to be swapped in are skipped, as the back buffer is rebuilt
+				ClaimChunk(ChunkIndex, false);
+
+				StreamJob& Job = mStreamJobs[JobCount++];
+				Job.Position = mLoadedChunkPositions[ChunkIndex];
+				Job.Index = ChunkIndex;
+				Job.NeedsRebuild = true;
+				Job.MeshFile = nullptr;
+			}
 		}
-		RebuildLock.lock();
+
+		if (JobCount == 0)
+			return;
+
+		MeshStreamJobs(JobCount, false);
+		mWorkerPool.Wait();
+		SaveCoarsenedChunks(JobCount);
+		QueueBufferSwaps(JobCount);
+	}
+}
+
+void FChunkManager::MeshStreamJobs(const uint32_t JobCount, const bool Hibernate)
+{
+	// Neighbor blocks are read before any chunk is meshed, so each worker only touches its own chunk
+	for (uint32_t i = 0; i < JobCount; i++)
+	{
+		StreamJob& Job = mStreamJobs[i];
+		Job.SavedData.clear();
+		Job.CellData.clear();
+		if (!Job.NeedsRebuild)
+			continue;
+
+		Job.Lod = LodLevel(Job.Position);
+		const bool IsApronComplete = GatherApron(Job.Position, Job.Lod, Job.Neighbors);
+		Job.MeshFile = GetMeshCacheFile(Job.Position, IsApronComplete);
 	}
+
+	// Collision shapes are built by the same job, as they are made from the mesh
+	mWorkerPool.Dispatch(JobCount, [this, Hibernate](uint32_t i)
+	{
+		StreamJob& Job = mStreamJobs[i];
+		if (Job.NeedsRebuild)
+			mChunks[Job.Index].RebuildMesh(Job.Position * FChunk::CHUNK_SIZE, Job.Neighbors, Job.Lod, Job.MeshFile);
+
+		// Far chunks give up their blocks once they are meshed
+		if (Job.NeedsRebuild && Job.Lod >= CELL_STORAGE_LOD)
+			mChunks[Job.Index].Coarsen(Job.Lod, Job.SavedData, Job.CellData);
+		else if (Hibernate)
+			mChunks[Job.Index].Hibernate();
+	});
+}
+
+void FChunkManager::SaveCoarsenedChunks(const uint32_t JobCount)
+{
+	for (uint32_t i = 0; i < JobCount; i++)
+	{
+		const StreamJob& Job = mStreamJobs[i];
+
+		// Blocks are written first, as writing them removes the chunk's cells from the mesh cache
+		if (!Job.SavedData.empty())
+			mFileSystem.WriteChunkData(Job.Position, Job.SavedData);
+
+		FMeshCacheFile* MeshFile = (mCacheMeshes && !Job.CellData.empty()) ? mFileSystem.GetMeshCacheFile(Job.Position) : nullptr;
+		if (MeshFile)
+			MeshFile->WriteCells(Job.Position, Job.Lod, Job.CellData);
+	}
+}
+
+void FChunkManager::UpdateStreamRate()
+{
+	if (mStreamStart == 0 || !IsStreamFinished())
+		return;
+
+	const float Seconds = FClock::CyclesToSeconds(FClock::ReadSystemTimer() - mStreamStart);
+	if (Seconds > 0.0f)
+		mStreamRate = (float)mStreamedChunks / Seconds;
+
+	mStreamStart = 0;
+}
+
+bool FChunkManager::IsStreamFinished()
+{
+	if (!mLoadQueue.empty())
+		return false;
+
+	// The stream isn't finished until every chunk is meshed and swapped in
+	{
+		std::lock_guard<std::mutex> RebuildLock(mRebuildListMutex);
+		if (!mRebuildList.empty())
+			return false;
+	}
+
+	return mQueuedSwaps == 0;
 }
 
 void FChunkManager::UpdateVisibleList()
 {
-	// Offset the camera chunk position so the loop centers the camera
-	Vector3i CameraChunkOffset = mLastCameraChunk - Vector3i{ mViewDistance, 0, mViewDistance };
+	Vector3i ViewCenter;
+	FFrustum ViewFrustum;
+	int32_t LoadDistance;
+	{
+		std::lock_guard<std::mutex> Lock(mLoaderMutex);
+		ViewCenter = mViewCenter;
+		ViewFrustum = mViewFrustum;
+		LoadDistance = mLoadDistance;
+	}
 
-	// Get the total range of visible area.
-	const int32_t HorizontalBounds = 2 * mViewDistance + 1;
+	UpdateLodLevels(ViewCenter);
 
-	// Clear previous load and visibile list when moving across chunks.
-	mLoadList = std::queue<Vector3i>();
+	// Get the total range of visible area. The world is loaded half as far above and below the camera.
+	const int32_t VerticalDistance = LoadDistance / 2;
+	const Vector3i Min{ std::max(ViewCenter.x - LoadDistance, 0), std::max(ViewCenter.y - VerticalDistance, 0), std::max(ViewCenter.z - LoadDistance, 0) };
+	const Vector3i Max{ std::min(ViewCenter.x + LoadDistance, mWorldSize - 1), std::min(ViewCenter.y + VerticalDistance, mWorldSize - 1), std::min(ViewCenter.z + LoadDistance, mWorldSize - 1) };
 
-	// Add all chunks in the visible range to the visible list.
-	// First add the xz plane that the camera is currently on.
-	if (CameraChunkOffset.y < mWorldSize && CameraChunkOffset.y >= 0)
+	// Queued requests are rescored for the new view as they reach the front of the queue
+	mQueueView++;
+	mQueueCenter = ViewCenter;
+	mQueueFrustum = ViewFrustum;
+
+	// Chunks that were already in range are either loaded or requested, so only the slabs
+	// coming into range are scanned. Each axis splits off the slabs below and above the last
+	// range, and narrows the rest to it. Ranges that don't overlap are scanned whole by the first slab.
+	if (mVisibleMin.x > mVisibleMax.x)
+	{
+		RequestLoads(Min, Max, ViewCenter, ViewFrustum);
+	}
+	else
 	{
-		for (int32_t x = 0; x < HorizontalBounds; x++)
+		Vector3i SlabMin = Min;
+		Vector3i SlabMax = Max;
+		for (uint32_t Axis = 0; Axis < 3; Axis++)
 		{
-			const int32_t xPosition = CameraChunkOffset.x + x;
-			if (xPosition >= mWorldSize || xPosition < 0)
-				continue;
+			if (SlabMin[Axis] < mVisibleMin[Axis])
+			{
+				Vector3i BelowMax = SlabMax;
+				BelowMax[Axis] = std::min(mVisibleMin[Axis] - 1, SlabMax[Axis]);
+				RequestLoads(SlabMin, BelowMax, ViewCenter, ViewFrustum);
+				SlabMin[Axis] = mVisibleMin[Axis];
+			}
 
-			for (int32_t z = 0; z < HorizontalBounds; z++)
+			if (SlabMax[Axis] > mVisibleMax[Axis])
 			{
-				const int32_t zPosition = CameraChunkOffset.z + z;
-				if (zPosition >= mWorldSize || zPosition < 0)
-					continue;
+				Vector3i AboveMin = SlabMin;
+				AboveMin[Axis] = std::max(mVisibleMax[Axis] + 1, SlabMin[Axis]);
+				RequestLoads(AboveMin, SlabMax, ViewCenter, ViewFrustum);
+				SlabMax[Axis] = mVisibleMax[Axis];
+			}
+		}
+	}
+
+	const bool HasRangeChanged = (Min != mVisibleMin || Max != mVisibleMax);
+	mVisibleMin = Min;
+	mVisibleMax = Max;
 
-				const Vector4i ChunkPosition{ xPosition, CameraChunkOffset.y, zPosition, 1 };
+	// Chunks that were waiting on neighbors which left the range have nothing more to wait for
+	if (HasRangeChanged)
+	{
+		uint32_t Kept = 0;
+		for (const int32_t Index : mApronWaitList)
+		{
+			RebuildIfApronLoaded(Index);
+			if (mChunkStates[Index] & ChunkState::Waiting)
+				mApronWaitList[Kept++] = Index;
+		}
+		mApronWaitList.resize(Kept);
+	}
+}
+
+void FChunkManager::RequestLoads(const Vector3i& Min, const Vector3i& Max, const Vector3i& ViewCenter, const FFrustum& ViewFrustum)
+{
+	for (int32_t y = Min.y; y <= Max.y; y++)
+	{
+		for (int32_t x = Min.x; x <= Max.x; x++)
+		{
+			for (int32_t z = Min.z; z <= Max.z; z++)
+			{
+				const Vector4i ChunkPosition{ x, y, z, 1 };
 				const int32_t VisibleChunkIndex = ChunkIndex(ChunkPosition);
 
 				// If this visible chunk is not loaded, load it.
-				if (mChunkPositions[VisibleChunkIndex] != ChunkPosition)
+				if (mLoadedChunkPositions[VisibleChunkIndex] != ChunkPosition)
 				{
-					mLoadList.push(ChunkPosition);
+					mLoadQueue.push_back(LoadRequest{ LoadPriority(ChunkPosition, ViewCenter, ViewFrustum), mQueueView, ChunkPosition });
+					std::push_heap(mLoadQueue.begin(), mLoadQueue.end());
 				}
 			}
 		}
 	}
+}
+
+uint32_t FChunkManager::LoadPriority(const Vector3i& ChunkPosition, const Vector3i& ViewCenter, const FFrustum& ViewFrustum)
+{
+	const Vector3i Offset = ChunkPosition - ViewCenter;
+	const uint32_t DistanceSquared = (uint32_t)(Offset.x * Offset.x + Offset.y * Offset.y + Offset.z * Offset.z);
+
+	// Chunks touching the camera's chunk are always needed, for collisions if nothing else
+	if (DistanceSquared <= 3 || ViewFrustum.IsUniformAABBVisible(Vector4f{ Vector4i{ ChunkPosition, 1 } }, 1.0f))
+		return DistanceSquared;
+
+	return DistanceSquared * 4;
+}
+
+void FChunkManager::UpdateLodLevels(const Vector3i& ViewCenter)
+{
+	// Views refreshed by the camera turning leave every level as it is
+	const bool HaveDistancesChanged = mLodDistancesChanged.exchange(false);
+	if (ViewCenter == mLodCenter && !HaveDistancesChanged)
+		return;
+
+	const Vector3i Move = ViewCenter - mLodCenter;
+	const int32_t Step = std::max({ std::abs(Move.x), std::abs(Move.y), std::abs(Move.z) });
+	mLodCenter = ViewCenter;
+
+	// Levels change where a chunk's distance from the camera crosses a level's distance. A step of
+	// the camera changes distances by at most the step, so only the shells of chunks within that far
+	// of each level's distance can change. Shells hold the chunks at one distance from the camera.
+	int32_t ShellMin[FChunk::LOD_LEVELS - 1];
+	int32_t ShellMax[FChunk::LOD_LEVELS - 1];
+	for (uint32_t i = 0; i < FChunk::LOD_LEVELS - 1; i++)
+	{
+		// Distances past the world's size don't fall in it
+		const int32_t Distance = (int32_t)std::min(mLodDistances[i].load(), (uint32_t)mWorldSize);
+		ShellMin[i] = std::max(Distance - Step + 1, 0);
+		ShellMax[i] = Distance + Step;
+	}
 
-	// Now add the world by alternating the xz planes from below to above the camera's chunk
-	for (int32_t v = 1; v <= mViewDistance / 2; v++)
+	// Shells near the distances of two levels are only visited for the first
+	auto IsFirstShell = [&ShellMin, &ShellMax](const uint32_t Level, const int32_t Radius)
 	{
-		for (int32_t y = -v; y < v + 1; y += 2 * v)
+		for (uint32_t i = 0; i < Level; i++)
 		{
-			const int32_t yPosition = CameraChunkOffset.y + y;
+			if (Radius >= ShellMin[i] && Radius <= ShellMax[i])
+				return false;
+		}
+		return true;
+	};
 
-			if (yPosition >= mWorldSize || yPosition < 0)
-				continue;
+	// New distances and long jumps check every chunk, as the shells would hold more chunks than there are slots
+	bool MustCheckAll = HaveDistancesChanged;
+	uint32_t ShellChunks = 0;
+	for (uint32_t i = 0; i < FChunk::LOD_LEVELS - 1 && !MustCheckAll; i++)
+	{
+		for (int32_t Radius = ShellMin[i]; Radius <= ShellMax[i] && !MustCheckAll; Radius++)
+		{
+			if (IsFirstShell(i, Radius))
+				ShellChunks += (Radius == 0) ? 1 : 24 * (uint32_t)Radius * (uint32_t)Radius + 2;
+			MustCheckAll = (ShellChunks >= ChunkCount());
+		}
+	}
 
-			for (int32_t x = 0; x < HorizontalBounds; x++)
-			{
-				const int32_t xPosition = CameraChunkOffset.x + x;
+	if (MustCheckAll)
+	{
+		const uint32_t Size = ChunkCount();
+		for (uint32_t i = 0; i < Size; i++)
+			UpdateLodLevel(i);
+		return;
+	}
 
-				if (xPosition >= mWorldSize || xPosition < 0)
-					continue;
+	for (uint32_t i = 0; i < FChunk::LOD_LEVELS - 1; i++)
+	{
+		for (int32_t Radius = ShellMin[i]; Radius <= ShellMax[i]; Radius++)
+		{
+			if (!IsFirstShell(i, Radius))
+				continue;
 
-				for (int32_t z = 0; z < HorizontalBounds; z++)
+			for (int32_t y = -Radius; y <= Radius; y++)
+			{
+				for (int32_t x = -Radius; x <= Radius; x++)
 				{
-					const int32_t zPosition = CameraChunkOffset.z + z;
-
-					if (zPosition >= mWorldSize || zPosition < 0)
-						continue;
+					// Rows through the inside of the shell only cross its near and far sides
+					const bool IsOnSide = (std::abs(x) == Radius || std::abs(y) == Radius);
+					const int32_t ZStep = IsOnSide ? 1 : 2 * Radius;
 
-					const Vector4i ChunkPosition{ xPosition, yPosition, zPosition, 1 };
-					const int32_t VisibleChunkIndex = ChunkIndex(ChunkPosition);
-
-					// If this visible chunk is not loaded, load it.
-					if (mChunkPositions[VisibleChunkIndex] != ChunkPosition)
+					for (int32_t z = -Radius; z <= Radius; z += ZStep)
 					{
-						mLoadList.push(ChunkPosition);
+						const int32_t Index = LoadedNeighborIndex(ViewCenter, Vector3i{ x, y, z });
+						if (Index >= 0)
+							UpdateLodLevel(Index);
 					}
 				}
 			}
@@ -466,24 +1490,75 @@ void FChunkManager::UpdateVisibleList()
 	}
 }
 
+void FChunkManager::UpdateLodLevel(const int32_t Index)
+{
+	const Vector3i ChunkPosition = mLoadedChunkPositions[Index];
+	if ((mChunkStates[Index] & ChunkState::StateMask) == ChunkState::Empty || mChunks[Index].GetLod() == LodLevel(ChunkPosition))
+		return;
+
+	// Chunks keeping cells too coarse for their new level are meshed once they are loaded again.
+	// The request is scored with the rest of the queue as it reaches the front.
+	const bool MustReload = IsAwaitingReload(Index);
+	if (MustReload)
+	{
+		mLoadQueue.push_back(LoadRequest{ 0, mQueueView, ChunkPosition });
+		std::push_heap(mLoadQueue.begin(), mLoadQueue.end());
+	}
+
+	std::lock_guard<std::mutex> Lock(mRebuildListMutex);
+	if (!MustReload)
+		AddToRebuildList(Index);
+
+	// The borders of the neighbors open or close with the change
+	for (int32_t n = 0; n < 27; n++)
+	{
+		const Vector3i Offset{ n % 3 - 1, n / 3 % 3 - 1, n / 9 - 1 };
+		const int32_t Neighbor = (Offset == Vector3i{ 0, 0, 0 }) ? -1 : LoadedNeighborIndex(ChunkPosition, Offset);
+		if (Neighbor >= 0)
+			RebuildBorder(Neighbor, Offset);
+	}
+}
+
+bool FChunkManager::IsAwaitingReload(const int32_t Index) const
+{
+	return mChunks[Index].GetCellLod() > LodLevel(mLoadedChunkPositions[Index]);
+}
+
+bool FChunkManager::IsInLoadRange(const Vector3i& ChunkPosition) const
+{
+	return ChunkPosition.x >= mVisibleMin.x && ChunkPosition.y >= mVisibleMin.y && ChunkPosition.z >= mVisibleMin.z &&
+	       ChunkPosition.x <= mVisibleMax.x && ChunkPosition.y <= mVisibleMax.y && ChunkPosition.z <= mVisibleMax.z;
+}
+
+uint32_t FChunkManager::LodLevel(const Vector3i& ChunkPosition) const
+{
+	const Vector3i Offset = ChunkPosition - mLodCenter;
+	const uint32_t Distance = (uint32_t)std::max({ std::abs(Offset.x), std::abs(Offset.y), std::abs(Offset.z) });
+
+	uint32_t Lod = 0;
+	while (Lod < FChunk::LOD_LEVELS - 1 && Distance > mLodDistances[Lod])
+		Lod++;
+
+	return Lod;
+}
+
 void FChunkManager::UpdateRenderList()
 {
 	// Start with a fresh list
 	mRenderList.clear();
 
-	// The the current view frustum in chunk coord
-	FMatrix4 ToChunkCoord;
-	ToChunkCoord.Scale(1.0f / (float)FChunk::CHUNK_SIZE);
-	ToChunkCoord.SetOrigin(-Vector3f{ 0.5f, 0.5f, 0.5f }); // align with center of chunks
-
-	FFrustum ViewFrustum = FCamera::Main->GetWorldViewFrustum();
-	ViewFrustum.TransformBy(ToChunkCoord);
+	const FFrustum ViewFrustum = ChunkViewFrustum();
 
 	// Check each visible chunk against the frustum
 	const uint32_t ListSize = ChunkCount();
 
 	for (uint32_t i = 0; i < ListSize; i++)
 	{
+		// Chunks past a stepped down view distance stay loaded, but aren't drawn
+		const Vector3i Offset = Vector3i(mChunkPositions[i]) - mViewCenter;
+		if (std::abs(Offset.x) > mLoadDistance || std::abs(Offset.z) > mLoadDistance || std::abs(Offset.y) > mLoadDistance / 2)
+			continue;
+
 		Vector4f CenterFloats{mChunkPositions[i]};
 
 		if (!mChunks[i].IsEmpty() && ViewFrustum.IsUniformAABBVisible(CenterFloats, 1.0f))
@@ -1,8 +1,87 @@
 #include "ChunkSystems\ChunkMesh.h"
 #include "Rendering\GLBindings.h"
 #include "Rendering\GLUtils.h"
+#include "Misc\Assertions.h"
+
+#include <mutex>
+#include <cstring>
 
 GLuint FChunkMesh::BufferUsageMode = GL_STATIC_DRAW;
+bool FChunkMesh::UseQuadPulling = true;
+
+namespace
+{
+	// Buffers of render data released by any thread, to be deleted by the GL thread
+	std::mutex ReleasedBufferMutex;
+	std::vector<GLuint> ReleasedBuffers;
+
+	void DeleteReleasedBuffers()
+	{
+		std::lock_guard<std::mutex> Lock(ReleasedBufferMutex);
+		if (!ReleasedBuffers.empty())
+		{
+			glDeleteBuffers((GLsizei)ReleasedBuffers.size(), ReleasedBuffers.data());
+			ReleasedBuffers.clear();
+		}
+	}
+}
+
+const int32_t FChunkMesh::QUAD_CORNERS[4][2] = { { 0, 0 }, { 0, 1 }, { 1, 1 }, { 1, 0 } };
+
+const uint32_t FChunkMesh::QUAD_INDICES[2][6] = 
+{
+	{ 0, 3, 2, 0, 2, 1 }, // Front faces have even NormalIDs
+	{ 0, 1, 2, 2, 3, 0 }
+};
+
+FChunkMesh::RenderData::RenderData()
+	: Quads()
+	, IndexType(GL_UNSIGNED_INT)
+	, IsUploaded(false)
+{
+	Buffers[0] = Buffers[1] = 0;
+	std::memset(FaceStarts, 0, sizeof(FaceStarts));
+	std::memset(FaceCounts, 0, sizeof(FaceCounts));
+}
+
+FChunkMesh::RenderData::~RenderData()
+{
+	Reset();
+}
+
+void FChunkMesh::RenderData::Reset()
+{
+	Quads.clear();
+	std::memset(FaceStarts, 0, sizeof(FaceStarts));
+	std::memset(FaceCounts, 0, sizeof(FaceCounts));
+
+	// The last mesh using the data may be released off the GL thread
+	if (IsUploaded)
+	{
+		std::lock_guard<std::mutex> Lock(ReleasedBufferMutex);
+		ReleasedBuffers.insert(ReleasedBuffers.end(), Buffers, Buffers + 2);
+		Buffers[0] = Buffers[1] = 0;
+		IsUploaded = false;
+	}
+}
+
+void FChunkMesh::RenderData::FindFaceRanges()
+{
+	std::memset(FaceStarts, 0, sizeof(FaceStarts));
+	std::memset(FaceCounts, 0, sizeof(FaceCounts));
+
+	for (uint32_t q = 0; q < (uint32_t)Quads.size(); q++)
+	{
+		const uint32_t NormalID = GetNormalID(Quads[q]);
+		if (FaceCounts[NormalID] == 0)
+			FaceStarts[NormalID] = q;
+
+		ASSERT(FaceStarts[NormalID] + FaceCounts[NormalID] == q && "Quads must be grouped by direction.");
+		FaceCounts[NormalID]++;
+	}
+}
+
+const FChunkMesh::RenderDataPtr FChunkMesh::EmptyData{ new RenderData{} };
 
 FChunkMesh::FChunkMesh()
 	: mVertexArray(0)
@@ -10,64 +89,170 @@ FChunkMesh::FChunkMesh()
 {
 	mActiveBuffer = false;
 
-	// Setup vertex and index data with dummy object
+	// Setup render data with dummy object
 	// to prevent nullptr references
-	mVertices[0] = VertexDataPtr{ new VertexData{} };
-	mVertices[1] = VertexDataPtr{ new VertexData{} };
-
-	mIndices[0] = IndexDataPtr{ new IndexData{} };
-	mIndices[1] = IndexDataPtr{ new IndexData{} };
+	mData[0] = EmptyData;
+	mData[1] = EmptyData;
 
 	glGenVertexArrays(1, &mVertexArray);
-	glGenBuffers(2, mBuffers);
-
-	glBindVertexArray(mVertexArray);
-		glBindBuffer(GL_ARRAY_BUFFER, mBuffers[Buffer::Vertex]);
-			glVertexAttribPointer(GLAttributePosition::Position, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), BUFFER_OFFSET(0));
-			glEnableVertexAttribArray(GLAttributePosition::Position);
-			glVertexAttribIPointer(GLAttributePosition::ChunkData, 1, GL_UNSIGNED_INT, sizeof(Vertex), BUFFER_OFFSET(offsetof(struct Vertex, BlockType)));
-			glEnableVertexAttribArray(GLAttributePosition::ChunkData);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mBuffers[Buffer::Index]);
-	glBindVertexArray(0);
-
 }
 
 
 FChunkMesh::~FChunkMesh()
 {
-	glDeleteBuffers(2, mBuffers);
 	glDeleteVertexArrays(1, &mVertexArray);
 }
 
-void FChunkMesh::AddVertexData(VertexDataPtr VertexData)
+void FChunkMesh::QuadCorners(const Quad& PackedQuad, Vector3i CornersOut[4])
 {
-	mVertices[!mActiveBuffer] = std::move(VertexData);
+	const uint32_t Packed = PackedQuad.PositionNormal;
+	const int32_t Position[3] = { (int32_t)(Packed & POSITION_MASK), (int32_t)((Packed >> POSITION_BITS) & POSITION_MASK), (int32_t)((Packed >> (2 * POSITION_BITS)) & POSITION_MASK) };
+	const int32_t Width = (int32_t)((PackedQuad.SizeBlock >> SIZE_SHIFT) & POSITION_MASK);
+	const int32_t Height = (int32_t)((PackedQuad.SizeBlock >> (SIZE_SHIFT + POSITION_BITS)) & POSITION_MASK);
+
+	const int32_t d = (int32_t)GetNormalID(PackedQuad) / 2;
+	const int32_t u = (d + 1) % 3;
+	const int32_t v = (d + 2) % 3;
+
+	for (int32_t i = 0; i < 4; i++)
+	{
+		int32_t Corner[3] = { Position[0], Position[1], Position[2] };
+		Corner[u] += QUAD_CORNERS[i][0] * Width;
+		Corner[v] += QUAD_CORNERS[i][1] * Height;
+		CornersOut[i] = Vector3i{ Corner[0], Corner[1], Corner[2] };
+	}
 }
 
-void FChunkMesh::AddIndexData(IndexDataPtr Indices)
+void FChunkMesh::AddRenderData(RenderDataPtr Data)
 {
-	mIndices[!mActiveBuffer] = std::move(Indices);
+	mData[!mActiveBuffer] = std::move(Data);
 }
 
-void FChunkMesh::Render(GLenum RenderMode)
+void FChunkMesh::Render(GLenum RenderMode, const uint32_t Faces)
 {
+	const RenderData& Data = *mData[mActiveBuffer];
+	const GLsizei IndexSize = (Data.IndexType == GL_UNSIGNED_SHORT) ? sizeof(uint16_t) : sizeof(uint32_t);
+
+	// Each quad is drawn as 2 triangles. Every direction to be drawn is sent in one call.
+	GLint Firsts[6];
+	const GLvoid* Offsets[6];
+	GLsizei Counts[6];
+	GLsizei DrawCount = 0;
+	for (uint32_t Face = 0; Face < 6; Face++)
+	{
+		if (!((Faces >> Face) & 1) || Data.FaceCounts[Face] == 0)
+			continue;
+
+		Firsts[DrawCount] = (GLint)Data.FaceStarts[Face] * 6;
+		Offsets[DrawCount] = BUFFER_OFFSET((size_t)Firsts[DrawCount] * IndexSize);
+		Counts[DrawCount] = (GLsizei)Data.FaceCounts[Face] * 6;
+		DrawCount++;
+	}
+
+	if (DrawCount == 0)
+		return;
+
 	glBindVertexArray(mVertexArray);
-	glDrawElements(RenderMode, mIndices[mActiveBuffer]->size(), GL_UNSIGNED_INT, BUFFER_OFFSET(0));
+	if (UseQuadPulling)
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, GLStorageBindings::ChunkQuads, Data.Buffers[Buffer::Vertex]);
+		glMultiDrawArrays(RenderMode, Firsts, Counts, DrawCount);
+	}
+	else
+	{
+		glMultiDrawElements(RenderMode, Counts, Data.IndexType, Offsets, DrawCount);
+	}
 }
 
-void FChunkMesh::SwapBuffer()
+uint32_t FChunkMesh::SwapBuffer()
 {
-	glBindBuffer(GL_ARRAY_BUFFER, mBuffers[Buffer::Vertex]);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * mVertices[!mActiveBuffer]->size(), mVertices[!mActiveBuffer]->data(), BufferUsageMode);
+	DeleteReleasedBuffers();
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mBuffers[Buffer::Index]);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint32_t) * mIndices[!mActiveBuffer]->size(), mIndices[!mActiveBuffer]->data(), BufferUsageMode);
+	RenderData& Data = *mData[!mActiveBuffer];
+	uint32_t UploadSize = 0;
+	if (!Data.IsUploaded)
+	{
+		glGenBuffers(2, Data.Buffers);
+		UploadSize = Upload(Data);
+		Data.IsUploaded = true;
+	}
+
+	// Point the vertex array at the new buffers. Pulled quads are bound when drawn.
+	if (!UseQuadPulling)
+	{
+		glBindVertexArray(mVertexArray);
+			glBindBuffer(GL_ARRAY_BUFFER, Data.Buffers[Buffer::Vertex]);
+				glVertexAttribIPointer(GLAttributePosition::Position, 1, GL_UNSIGNED_INT, sizeof(Vertex), BUFFER_OFFSET(offsetof(struct Vertex, PositionNormal)));
+				glEnableVertexAttribArray(GLAttributePosition::Position);
+				glVertexAttribIPointer(GLAttributePosition::ChunkData, 1, GL_UNSIGNED_INT, sizeof(Vertex), BUFFER_OFFSET(offsetof(struct Vertex, BlockData)));
+				glEnableVertexAttribArray(GLAttributePosition::ChunkData);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, Data.Buffers[Buffer::Index]);
+		glBindVertexArray(0);
+	}
 
 	mActiveBuffer = !mActiveBuffer;
+	return UploadSize;
+}
+
+uint32_t FChunkMesh::Upload(RenderData& Data)
+{
+	const QuadData& Quads = Data.Quads;
+
+	if (UseQuadPulling)
+	{
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, Data.Buffers[Buffer::Vertex]);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(Quad) * Quads.size(), Quads.data(), BufferUsageMode);
+		return (uint32_t)(sizeof(Quad) * Quads.size());
+	}
+
+	// Only used by the thread owning the GL context
+	static VertexData Vertices;
+	static IndexData Indices;
+	static std::vector<uint16_t> ShortIndices;
+
+	Vertices.resize(Quads.size() * 4);
+	Indices.resize(Quads.size() * 6);
+
+	for (size_t q = 0; q < Quads.size(); q++)
+	{
+		const Quad& PackedQuad = Quads[q];
+		const uint32_t NormalID = GetNormalID(PackedQuad);
+		const FBlockTypes::BlockID BlockType = (FBlockTypes::BlockID)(PackedQuad.SizeBlock & ((1 << SIZE_SHIFT) - 1));
+
+		Vector3i Corners[4];
+		QuadCorners(PackedQuad, Corners);
+
+		for (uint32_t i = 0; i < 4; i++)
+			Vertices[q * 4 + i] = PackVertex(Corners[i].x, Corners[i].y, Corners[i].z, NormalID, BlockType, GetOcclusion(PackedQuad, i));
+
+		// Flipped quads start each triangle one corner later to split along the other diagonal
+		const uint32_t FirstCorner = IsSplitFlipped(PackedQuad) ? 1 : 0;
+		for (uint32_t i = 0; i < 6; i++)
+			Indices[q * 6 + i] = (uint32_t)q * 4 + (QUAD_INDICES[NormalID & 1][i] + FirstCorner) % 4;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, Data.Buffers[Buffer::Vertex]);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * Vertices.size(), Vertices.data(), BufferUsageMode);
+
+	// Small meshes are uploaded with 16 bit indices to halve the index buffer
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, Data.Buffers[Buffer::Index]);
+	if (Vertices.size() <= MAX_SHORT_INDEX_VERTICES)
+	{
+		ShortIndices.resize(Indices.size());
+		for (size_t i = 0; i < Indices.size(); i++)
+			ShortIndices[i] = (uint16_t)Indices[i];
+
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint16_t) * ShortIndices.size(), ShortIndices.data(), BufferUsageMode);
+		Data.IndexType = GL_UNSIGNED_SHORT;
+		return (uint32_t)(sizeof(Vertex) * Vertices.size() + sizeof(uint16_t) * ShortIndices.size());
+	}
+
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint32_t) * Indices.size(), Indices.data(), BufferUsageMode);
+	Data.IndexType = GL_UNSIGNED_INT;
+	return (uint32_t)(sizeof(Vertex) * Vertices.size() + sizeof(uint32_t) * Indices.size());
 }
 
 void FChunkMesh::ClearBackBuffer()
 {
-	mVertices[!mActiveBuffer]   = VertexDataPtr{ new VertexData{} };
-	mIndices[!mActiveBuffer]    = IndexDataPtr{ new IndexData{} };
+	mData[!mActiveBuffer] = EmptyData;
 }
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include "ChunkSystems\ChunkWorkerPool.h"
+#include "ChunkSystems\BlockStorage.h"
+#include "Memory\ConcurrentPoolAllocator.h"
+#include "Memory\AllocationCounter.h"
+#include "Misc\Assertions.h"
+
+#include <algorithm>
+
+FChunkWorkerPool::FChunkWorkerPool()
+	: mWorkers()
+	, mMutex()
+	, mStageReady()
+	, mStageDone()
+	, mJob()
+	, mJobCount(0)
+	, mNextJob()
+	, mStage(0)
+	, mBusyWorkers(0)
+	, mIsWorkerStage(false)
+	, mMustStop(false)
+{
+	mNextJob = 0;
+}
+
+FChunkWorkerPool::~FChunkWorkerPool()
+{
+	Stop();
+}
+
+void FChunkWorkerPool::Start(const uint32_t WorkerCount)
+{
+	ASSERT(mWorkers.empty());
+
+	// Workers start waiting for the stage after the last one run
+	mMustStop = false;
+	for (uint32_t i = 0; i < WorkerCount; i++)
+		mWorkers.push_back(std::thread(&FChunkWorkerPool::WorkerLoop, this, mStage));
+}
+
+void FChunkWorkerPool::Stop()
+{
+	{
+		std::lock_guard<std::mutex> Lock(mMutex);
+		mMustStop = true;
+	}
+	mStageReady.notify_all();
+
+	for (auto& Worker : mWorkers)
+		Worker.join();
+
+	mWorkers.clear();
+}
+
+void FChunkWorkerPool::Run(const uint32_t JobCount, const std::function<void(uint32_t)>& Job)
+{
+	Dispatch(JobCount, Job);
+	Wait();
+}
+
+void FChunkWorkerPool::Dispatch(const uint32_t JobCount, const std::function<void(uint32_t)>& Job)
+{
+	ASSERT(!mJob && "The last stage must be waited for first.");
+
+	// Workers read the job after seeing the stage change, so it is set before they are woken
+	mJob = Job;
+	mJobCount = JobCount;
+	mNextJob = 0;
+
+	// Small stages aren't worth waking the workers for
+	mIsWorkerStage = (JobCount > 1 && !mWorkers.empty());
+	if (!mIsWorkerStage)
+		return;
+
+	{
+		std::lock_guard<std::mutex> Lock(mMutex);
+		mBusyWorkers = (uint32_t)mWorkers.size();
+		mStage++;
+	}
+	mStageReady.notify_all();
+}
+
+void FChunkWorkerPool::Wait()
+{
+	RunJobs();
+
+	// Every worker checks in, so none is left holding the job once this returns
+	if (mIsWorkerStage)
+	{
+		std::unique_lock<std::mutex> Lock(mMutex);
+		mStageDone.wait(Lock, [this]{ return mBusyWorkers == 0; });
+	}
+
+	mJob = nullptr;
+	mJobCount = 0;
+	mIsWorkerStage = false;
+}
+
+uint32_t FChunkWorkerPool::DefaultWorkerCount()
+{
+	// Slots are left for the main and loader threads, and any others that use the block pools
+	const uint32_t Cores = std::thread::hardware_concurrency();
+	return std::min(std::max(Cores, 2u) - 2, (uint32_t)FThreadSlot::MAX_THREADS / 2);
+}
+
+void FChunkWorkerPool::WorkerLoop(uint32_t LastStage)
+{
+	FAllocationCounter::FScope CountAllocations;
+
+	std::unique_lock<std::mutex> Lock(mMutex);
+	for (;;)
+	{
+		mStageReady.wait(Lock, [this, LastStage]{ return mMustStop || mStage != LastStage; });
+		if (mMustStop)
+			break;
+
+		LastStage = mStage;
+		Lock.unlock();
+
+		RunJobs();
+
+		Lock.lock();
+		if (--mBusyWorkers == 0)
+			mStageDone.notify_one();
+	}
+	Lock.unlock();
+
+	// Hand cached block pages back before the thread slot is given up
+	FBlockStorage::FlushThreadCache();
+	FThreadSlot::Release();
+}
+
+void FChunkWorkerPool::RunJobs()
+{
+	for (uint32_t i = mNextJob++; i < mJobCount; i = mNextJob++)
+		mJob(i);
+}
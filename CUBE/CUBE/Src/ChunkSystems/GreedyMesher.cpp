@@ -0,0 +1,377 @@
+#include "ChunkSystems\GreedyMesher.h"
+#include "Block.h"
+#include "Misc\BitUtil.h"
+
+#include <emmintrin.h>
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	typedef FBlockTypes::BlockID BlockID;
+
+	static const int32_t CHUNK_SIZE = FChunkGeometry::CHUNK_SIZE;
+	static const uint32_t EDGE_SHIFT = FChunkGeometry::EDGE_SHIFT;
+
+	static_assert(CHUNK_SIZE % 16 == 0, "Rows must be a multiple of 16 blocks.");
+
+	// Bits of a full row
+	static const uint64_t ROW_BITS = (CHUNK_SIZE == 64) ? ~0ull : ((1ull << (CHUNK_SIZE & 63)) - 1);
+
+	// Steps along u and v from a face to the blocks around each of its corners, in FChunkMesh::QUAD_CORNERS order
+	static const int32_t CORNER_STEPS[4][2] = { { -1, -1 }, { -1, 1 }, { 1, 1 }, { 1, -1 } };
+
+	/**
+	* Finds the blocks of a type in a row of 8 bit block IDs.
+	* @return Bit set with a bit for each block of the type.
+	*/
+	uint64_t RowMask(const uint8_t* Row, const uint8_t ID)
+	{
+		const __m128i Value = _mm_set1_epi8((char)ID);
+		uint64_t Mask = 0;
+
+		for (int32_t i = 0; i < CHUNK_SIZE; i += 16)
+		{
+			const __m128i Blocks = _mm_loadu_si128((const __m128i*)(Row + i));
+			Mask |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(Blocks, Value)) << i;
+		}
+
+		return Mask;
+	}
+
+	/**
+	* Finds the blocks of a type in a row of 16 bit block IDs.
+	* @return Bit set with a bit for each block of the type.
+	*/
+	uint64_t RowMask(const uint16_t* Row, const uint16_t ID)
+	{
+		const __m128i Value = _mm_set1_epi16((short)ID);
+		uint64_t Mask = 0;
+
+		for (int32_t i = 0; i < CHUNK_SIZE; i += 16)
+		{
+			const __m128i Low = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i*)(Row + i)), Value);
+			const __m128i High = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i*)(Row + i + 8)), Value);
+
+			// Narrow the 16 bit compare results so each block has one bit in the mask
+			Mask |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_packs_epi16(Low, High)) << i;
+		}
+
+		return Mask;
+	}
+}
+
+FGreedyMesher::FGreedyMesher()
+	: mTypes()
+	, mRows()
+	, mFaceRows()
+	, mLayerTypes()
+	, mLinearBlocks()
+	, mGroups()
+	, mGroupRows()
+	, mOccluderCorners(0)
+	, mCorners(0)
+	, mIsOcclusionEnabled(true)
+{
+	std::memset(mOccluderRows, 0, sizeof(mOccluderRows));
+	std::memset(mOccluderEdges, 0, sizeof(mOccluderEdges));
+	std::memset(mEdgeRows, 0, sizeof(mEdgeRows));
+}
+
+void FGreedyMesher::SetBlocks(const BlockID* Blocks, const BlockID (*Neighbors)[CHUNK_SIZE * CHUNK_SIZE], const BlockID (*Edges)[CHUNK_SIZE], const BlockID* Corners)
+{
+	// Rows along z are read straight from the blocks, so other layouts are copied to linear order first
+	const BlockID* LinearBlocks = Blocks;
+	if (!FChunkGeometry::Layout::CONTIGUOUS_Z)
+	{
+		mLinearBlocks.resize(FChunkGeometry::BLOCKS_PER_CHUNK);
+		for (int32_t y = 0; y < CHUNK_SIZE; y++)
+			for (int32_t x = 0; x < CHUNK_SIZE; x++)
+				for (int32_t z = 0; z < CHUNK_SIZE; z++)
+					mLinearBlocks[(((y << EDGE_SHIFT) | x) << EDGE_SHIFT) | z] = Blocks[FChunkGeometry::BlockIndex(x, y, z)];
+
+		LinearBlocks = mLinearBlocks.data();
+	}
+
+	// Find the block types in the chunk
+	uint64_t Present[((1 << (8 * sizeof(BlockID))) + 63) / 64];
+	std::memset(Present, 0, sizeof(Present));
+	for (int32_t i = 0; i < FChunkGeometry::BLOCKS_PER_CHUNK; i++)
+		Present[LinearBlocks[i] >> 6] |= 1ull << (LinearBlocks[i] & 63);
+
+	Present[FBlock::AIR_BLOCK_ID >> 6] &= ~(1ull << (FBlock::AIR_BLOCK_ID & 63));
+
+	mTypes.clear();
+	for (uint32_t Word = 0; Word < sizeof(Present) / sizeof(Present[0]); Word++)
+	{
+		for (uint64_t Bits = Present[Word]; Bits; Bits &= Bits - 1)
+			mTypes.push_back((BlockID)(Word * 64 + FBit::CountTrailingZeros64(Bits)));
+	}
+
+	// Solid rows are kept after the rows of each type
+	const uint32_t Solid = (uint32_t)mTypes.size();
+	mRows.resize((mTypes.size() + 1) * ROWS_PER_TYPE);
+	std::fill(mRows.begin() + Solid * ROWS_PER_TYPE, mRows.begin() + Solid * ROWS_PER_TYPE + 3 * AXIS_ROWS, 0);
+
+	uint64_t Matrix[CHUNK_SIZE];
+	for (uint32_t Type = 0; Type < (uint32_t)mTypes.size(); Type++)
+	{
+		const BlockID ID = mTypes[Type];
+
+		// Slices along y hold rows along z, one for each x
+		for (int32_t y = 0; y < CHUNK_SIZE; y++)
+			for (int32_t x = 0; x < CHUNK_SIZE; x++)
+				SliceRow(Type, 1, y, x) = RowMask(LinearBlocks + ((((y << EDGE_SHIFT) | x)) << EDGE_SHIFT), ID);
+
+		// Slices along x hold rows along y, one for each z. Transposing the y, z bits of each x gives them.
+		for (int32_t x = 0; x < CHUNK_SIZE; x++)
+		{
+			for (int32_t y = 0; y < CHUNK_SIZE; y++)
+				Matrix[y] = SliceRow(Type, 1, y, x);
+
+			FBit::Transpose<CHUNK_SIZE>(Matrix);
+
+			for (int32_t z = 0; z < CHUNK_SIZE; z++)
+				SliceRow(Type, 0, x, z) = Matrix[z];
+		}
+
+		// Slices along z hold rows along x, one for each y. Transposing the x, z bits of each y gives them.
+		for (int32_t y = 0; y < CHUNK_SIZE; y++)
+		{
+			std::memcpy(Matrix, &SliceRow(Type, 1, y, 0), sizeof(Matrix));
+			FBit::Transpose<CHUNK_SIZE>(Matrix);
+
+			for (int32_t z = 0; z < CHUNK_SIZE; z++)
+				SliceRow(Type, 2, z, y) = Matrix[z];
+		}
+
+		// Neighbor faces are already stored as rows along u
+		for (uint32_t Face = 0; Face < 6; Face++)
+			for (int32_t Row = 0; Row < CHUNK_SIZE; Row++)
+				NeighborRow(Type, Face, Row) = RowMask(Neighbors[Face] + Row * CHUNK_SIZE, ID);
+
+		for (uint32_t i = 0; i < 3 * AXIS_ROWS; i++)
+			mRows[Solid * ROWS_PER_TYPE + i] |= mRows[Type * ROWS_PER_TYPE + i];
+	}
+
+	// Neighbor blocks may be of types the chunk doesn't have
+	for (uint32_t Face = 0; Face < 6; Face++)
+		for (int32_t Row = 0; Row < CHUNK_SIZE; Row++)
+			NeighborRow(Solid, Face, Row) = ~RowMask(Neighbors[Face] + Row * CHUNK_SIZE, (BlockID)FBlock::AIR_BLOCK_ID) & ROW_BITS;
+
+	// Edges and corners only occlude, so only their solid blocks are kept
+	for (uint32_t Edge = 0; Edge < 12; Edge++)
+		mEdgeRows[Edge] = ~RowMask(Edges[Edge], (BlockID)FBlock::AIR_BLOCK_ID) & ROW_BITS;
+
+	mCorners = 0;
+	for (uint32_t Corner = 0; Corner < 8; Corner++)
+		mCorners |= (uint32_t)(Corners[Corner] != FBlock::AIR_BLOCK_ID) << Corner;
+}
+
+void FGreedyMesher::SetOcclusion(const bool IsEnabled)
+{
+	mIsOcclusionEnabled = IsEnabled;
+}
+
+void FGreedyMesher::BuildLayer(const uint32_t Face, const int32_t Depth, std::vector<FQuad>& QuadsOut)
+{
+	const int32_t Axis = Face / 2;
+	const int32_t Next = (Face & 1) ? Depth - 1 : Depth + 1;
+	const bool IsNextOutside = (Next < 0 || Next >= CHUNK_SIZE);
+
+	// Faces of a type are open where the next block along the axis is a different type
+	mFaceRows.resize(mTypes.size() * CHUNK_SIZE);
+	mLayerTypes.clear();
+
+	for (uint32_t Type = 0; Type < (uint32_t)mTypes.size(); Type++)
+	{
+		uint64_t* FaceRows = &mFaceRows[Type * CHUNK_SIZE];
+		uint64_t AnyFaces = 0;
+
+		for (int32_t Row = 0; Row < CHUNK_SIZE; Row++)
+		{
+			const uint64_t Covering = IsNextOutside ? NeighborRow(Type, Face, Row) : SliceRow(Type, Axis, Next, Row);
+			FaceRows[Row] = SliceRow(Type, Axis, Depth, Row) & ~Covering;
+			AnyFaces |= FaceRows[Row];
+		}
+
+		if (AnyFaces)
+			mLayerTypes.push_back(Type);
+	}
+
+	// Faces of a type only join faces with the same occlusion, so each type is split into groups by occlusion
+	mGroups.clear();
+	mGroupRows.clear();
+
+	if (mIsOcclusionEnabled && !mLayerTypes.empty())
+		FindOccluders(Face, Next);
+
+	for (const uint32_t Type : mLayerTypes)
+	{
+		const uint64_t* FaceRows = &mFaceRows[Type * CHUNK_SIZE];
+		if (!mIsOcclusionEnabled)
+		{
+			mGroups.push_back(FFaceGroup{ Type, UNOCCLUDED });
+			mGroupRows.insert(mGroupRows.end(), FaceRows, FaceRows + CHUNK_SIZE);
+			continue;
+		}
+
+		int32_t GroupOf[256];
+		std::fill(GroupOf, GroupOf + 256, -1);
+
+		for (int32_t Row = 0; Row < CHUNK_SIZE; Row++)
+		{
+			for (uint64_t Bits = FaceRows[Row]; Bits; Bits &= Bits - 1)
+			{
+				const int32_t Cell = (int32_t)FBit::CountTrailingZeros64(Bits);
+				const uint8_t Occlusion = FaceOcclusion(Cell, Row);
+				if (GroupOf[Occlusion] < 0)
+				{
+					GroupOf[Occlusion] = (int32_t)mGroups.size();
+					mGroups.push_back(FFaceGroup{ Type, Occlusion });
+					mGroupRows.resize(mGroups.size() * CHUNK_SIZE, 0);
+				}
+
+				mGroupRows[GroupOf[Occlusion] * CHUNK_SIZE + Row] |= 1ull << Cell;
+			}
+		}
+	}
+
+	for (int32_t Row = 0; Row < CHUNK_SIZE; Row++)
+	{
+		const size_t RowStart = QuadsOut.size();
+
+		for (uint32_t Group = 0; Group < (uint32_t)mGroups.size(); Group++)
+		{
+			uint64_t* FaceRows = &mGroupRows[Group * CHUNK_SIZE];
+
+			while (FaceRows[Row])
+			{
+				// Widen along the run of open faces from the first one
+				const uint32_t Start = FBit::CountTrailingZeros64(FaceRows[Row]);
+				const uint64_t Closed = ~(FaceRows[Row] >> Start);
+				const uint32_t Width = Closed ? FBit::CountTrailingZeros64(Closed) : 64 - Start;
+				const uint64_t Mask = ((Width == 64) ? ~0ull : ((1ull << Width) - 1)) << Start;
+				FaceRows[Row] &= ~Mask;
+
+				// Grow over the following rows while they are open across the whole width
+				int32_t Height = 1;
+				while (Row + Height < CHUNK_SIZE && (FaceRows[Row + Height] & Mask) == Mask)
+				{
+					FaceRows[Row + Height] &= ~Mask;
+					Height++;
+				}
+
+				FQuad Quad;
+				Quad.U = (uint8_t)Start;
+				Quad.V = (uint8_t)Row;
+				Quad.Width = (uint8_t)Width;
+				Quad.Height = (uint8_t)Height;
+				Quad.Occlusion = mGroups[Group].Occlusion;
+				Quad.Type = mTypes[mGroups[Group].Type];
+				QuadsOut.push_back(Quad);
+			}
+		}
+
+		// Quads of different groups starting on the same row are ordered by their first cell
+		if (mGroups.size() > 1)
+		{
+			std::sort(QuadsOut.begin() + RowStart, QuadsOut.end(), [](const FQuad& A, const FQuad& B)
+			{
+				return A.U < B.U;
+			});
+		}
+	}
+}
+
+void FGreedyMesher::FindOccluders(const uint32_t Face, const int32_t Next)
+{
+	const int32_t Axis = Face / 2;
+	const int32_t u = (Axis + 1) % 3;
+	const int32_t v = (Axis + 2) % 3;
+	const uint32_t Solid = (uint32_t)mTypes.size();
+
+	std::memset(mOccluderRows, 0, sizeof(mOccluderRows));
+	std::memset(mOccluderEdges, 0, sizeof(mOccluderEdges));
+	mOccluderCorners = 0;
+	uint64_t* Rows = mOccluderRows + 1;
+
+	// Slices outside the chunk are the neighbor face, surrounded by the edges and corners beside it
+	if (Next < 0 || Next >= CHUNK_SIZE)
+	{
+		const uint32_t Low = Face & 1;
+		for (int32_t Row = 0; Row < CHUNK_SIZE; Row++)
+			Rows[Row] = NeighborRow(Solid, Face, Row);
+
+		// Edges along u are beside v and the face's axis, and edges along v are beside the face's axis and u
+		Rows[-1] = mEdgeRows[u * 4 + 1 + 2 * Low];
+		Rows[CHUNK_SIZE] = mEdgeRows[u * 4 + 2 * Low];
+		mOccluderEdges[0] = mEdgeRows[v * 4 + Low + 2];
+		mOccluderEdges[1] = mEdgeRows[v * 4 + Low];
+
+		for (uint32_t Corner = 0; Corner < 4; Corner++)
+		{
+			const uint32_t Index = (Low << Axis) | ((Corner & 1) ? 0 : 1u << u) | ((Corner & 2) ? 0 : 1u << v);
+			mOccluderCorners |= ((mCorners >> Index) & 1) << Corner;
+		}
+
+		return;
+	}
+
+	for (int32_t Row = 0; Row < CHUNK_SIZE; Row++)
+		Rows[Row] = SliceRow(Solid, Axis, Next, Row);
+
+	// Rows of the neighbor faces along v run along the face's axis, one for each cell along u
+	for (int32_t Cell = 0; Cell < CHUNK_SIZE; Cell++)
+	{
+		Rows[-1] |= ((NeighborRow(Solid, 2 * v + 1, Cell) >> Next) & 1) << Cell;
+		Rows[CHUNK_SIZE] |= ((NeighborRow(Solid, 2 * v, Cell) >> Next) & 1) << Cell;
+	}
+
+	// Rows of the neighbor faces along u run along v, one for each slice
+	mOccluderEdges[0] = NeighborRow(Solid, 2 * u + 1, Next);
+	mOccluderEdges[1] = NeighborRow(Solid, 2 * u, Next);
+
+	// Blocks past the slice along both u and v are in the edges along the face's axis
+	for (uint32_t Corner = 0; Corner < 4; Corner++)
+	{
+		const uint32_t Edge = Axis * 4 + ((Corner & 1) ? 0 : 1) + ((Corner & 2) ? 0 : 2);
+		mOccluderCorners |= (uint32_t)((mEdgeRows[Edge] >> Next) & 1) << Corner;
+	}
+}
+
+uint8_t FGreedyMesher::FaceOcclusion(const int32_t U, const int32_t V) const
+{
+	uint32_t Occlusion = 0;
+	for (uint32_t Corner = 0; Corner < 4; Corner++)
+	{
+		// A corner is fully occluded between two blocks, and darkened by each block around it otherwise
+		const int32_t StepU = CORNER_STEPS[Corner][0];
+		const int32_t StepV = CORNER_STEPS[Corner][1];
+		const uint32_t SideU = IsOccluder(U + StepU, V);
+		const uint32_t SideV = IsOccluder(U, V + StepV);
+		const uint32_t Level = (SideU & SideV) ? 0 : 3 - (SideU + SideV + IsOccluder(U + StepU, V + StepV));
+
+		Occlusion |= Level << (2 * Corner);
+	}
+
+	return (uint8_t)Occlusion;
+}
+
+uint32_t FGreedyMesher::IsOccluder(const int32_t U, const int32_t V) const
+{
+	if (U >= 0 && U < CHUNK_SIZE)
+		return (uint32_t)(mOccluderRows[V + 1] >> U) & 1;
+
+	if (V < 0 || V >= CHUNK_SIZE)
+		return (mOccluderCorners >> ((U < 0 ? 0 : 1) + (V < 0 ? 0 : 2))) & 1;
+
+	return (uint32_t)(mOccluderEdges[U < 0 ? 0 : 1] >> V) & 1;
+}
+
+size_t FGreedyMesher::GetCapacity() const
+{
+	return mTypes.capacity() * sizeof(BlockID) + mRows.capacity() * sizeof(uint64_t) + mFaceRows.capacity() * sizeof(uint64_t) +
+	       mLayerTypes.capacity() * sizeof(uint32_t) + mLinearBlocks.capacity() * sizeof(BlockID) +
+	       mGroups.capacity() * sizeof(FFaceGroup) + mGroupRows.capacity() * sizeof(uint64_t);
+}
@@ -0,0 +1,256 @@
+#include "ChunkSystems\RunLengthCodec.h"
+#include "Block.h"
+#include "Misc\BitUtil.h"
+#include "Misc\Assertions.h"
+
+#include <emmintrin.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+namespace
+{
+	typedef FBlockTypes::BlockID BlockID;
+
+	static const int32_t CHUNK_SIZE = FChunkGeometry::CHUNK_SIZE;
+	static const bool CONTIGUOUS_ROWS = FChunkGeometry::Layout::CONTIGUOUS_Z;
+
+	static_assert(CHUNK_SIZE % 16 == 0 && CHUNK_SIZE <= 64, "Rows must be a multiple of 16 blocks and fit in a 64 bit mask.");
+
+	/**
+	* Finds the first block of every run in a row of 8 bit block IDs.
+	* @return Bit set with a bit for each block that differs from the block before it. Bit 0 is not set.
+	*/
+	uint64_t RunStarts(const uint8_t* Row)
+	{
+		uint64_t Starts = 0;
+		int32_t i = 0;
+
+#ifdef __AVX2__
+		for (; i + 32 <= CHUNK_SIZE; i += 32)
+		{
+			const __m256i Blocks = _mm256_loadu_si256((const __m256i*)(Row + i));
+
+			// Shift the first vector by a byte across lanes instead of reading before the row
+			const __m256i Previous = (i == 0) ? _mm256_alignr_epi8(Blocks, _mm256_permute2x128_si256(Blocks, Blocks, 0x08), 15)
+			                                  : _mm256_loadu_si256((const __m256i*)(Row + i - 1));
+
+			const uint32_t Equal = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(Blocks, Previous));
+			Starts |= (uint64_t)(~Equal) << i;
+		}
+#endif
+
+		for (; i < CHUNK_SIZE; i += 16)
+		{
+			const __m128i Blocks = _mm_loadu_si128((const __m128i*)(Row + i));
+			const __m128i Previous = (i == 0) ? _mm_slli_si128(Blocks, 1) : _mm_loadu_si128((const __m128i*)(Row + i - 1));
+
+			const uint32_t Equal = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(Blocks, Previous));
+			Starts |= (uint64_t)(~Equal & 0xFFFF) << i;
+		}
+
+		return Starts & ~1ull;
+	}
+
+	/**
+	* Finds the first block of every run in a row of 16 bit block IDs.
+	* @return Bit set with a bit for each block that differs from the block before it. Bit 0 is not set.
+	*/
+	uint64_t RunStarts(const uint16_t* Row)
+	{
+		uint64_t Starts = 0;
+
+		for (int32_t i = 0; i < CHUNK_SIZE; i += 16)
+		{
+			const __m128i BlocksLow = _mm_loadu_si128((const __m128i*)(Row + i));
+			const __m128i BlocksHigh = _mm_loadu_si128((const __m128i*)(Row + i + 8));
+			const __m128i PreviousLow = (i == 0) ? _mm_slli_si128(BlocksLow, 2) : _mm_loadu_si128((const __m128i*)(Row + i - 1));
+			const __m128i PreviousHigh = _mm_loadu_si128((const __m128i*)(Row + i + 7));
+
+			// Narrow the 16 bit compare results so each block has one bit in the mask
+			const __m128i Equal = _mm_packs_epi16(_mm_cmpeq_epi16(BlocksLow, PreviousLow), _mm_cmpeq_epi16(BlocksHigh, PreviousHigh));
+			Starts |= (uint64_t)(~(uint32_t)_mm_movemask_epi8(Equal) & 0xFFFF) << i;
+		}
+
+		return Starts & ~1ull;
+	}
+
+	__m128i Splat(const uint8_t ID)
+	{
+		return _mm_set1_epi8((char)ID);
+	}
+
+	__m128i Splat(const uint16_t ID)
+	{
+		return _mm_set1_epi16((short)ID);
+	}
+
+	/**
+	* Fills a run of blocks with 16 byte stores. May write up to 15 bytes past the end of the run.
+	*/
+	void FillRun(BlockID* Blocks, const BlockID ID, const uint32_t Length)
+	{
+		const __m128i Value = Splat(ID);
+		const uint32_t BlocksPerStore = sizeof(__m128i) / sizeof(BlockID);
+
+		for (uint32_t i = 0; i < Length; i += BlocksPerStore)
+			_mm_storeu_si128((__m128i*)(Blocks + i), Value);
+	}
+
+	/**
+	* Encodes a row of blocks along z.
+	* @return The end of the written data.
+	*/
+	uint8_t* EncodeRow(const BlockID* Row, uint8_t* DataOut)
+	{
+		uint64_t Starts = RunStarts(Row);
+		uint32_t Start = 0;
+
+		for (;;)
+		{
+			const uint32_t End = Starts ? FBit::CountTrailingZeros64(Starts) : CHUNK_SIZE;
+
+			std::memcpy(DataOut, Row + Start, sizeof(BlockID));
+			DataOut[sizeof(BlockID)] = (uint8_t)(End - Start);
+			DataOut += FRunLengthCodec::RUN_SIZE;
+
+			if (!Starts)
+				return DataOut;
+
+			Starts &= Starts - 1;
+			Start = End;
+		}
+	}
+
+	/**
+	* Decodes a row of blocks along z. Missing runs at the end of the data are set to air.
+	* @param Row - Memory for CHUNK_SIZE + DECODE_PADDING blocks.
+	* @return The end of the read data.
+	*/
+	const uint8_t* DecodeRow(const uint8_t* Data, const uint8_t* DataEnd, BlockID* Row)
+	{
+		int32_t z = 0;
+		while (z < CHUNK_SIZE && DataEnd - Data >= (ptrdiff_t)FRunLengthCodec::RUN_SIZE)
+		{
+			BlockID ID;
+			std::memcpy(&ID, Data, sizeof(ID));
+			const int32_t Length = std::min((int32_t)Data[sizeof(ID)], CHUNK_SIZE - z);
+			ASSERT(Length > 0 && "Invalid run length in chunk data.");
+
+			FillRun(Row + z, ID, Length);
+			z += Length;
+			Data += FRunLengthCodec::RUN_SIZE;
+
+			if (Length == 0)
+				break;
+		}
+
+		if (z < CHUNK_SIZE)
+			FillRun(Row + z, FBlock::AIR_BLOCK_ID, CHUNK_SIZE - z);
+
+		return Data;
+	}
+}
+
+namespace FRunLengthCodec
+{
+	static_assert(DECODE_PADDING * sizeof(BlockID) >= sizeof(__m128i), "Decode padding must cover a wide store.");
+
+	uint32_t Encode(const BlockID* Blocks, uint8_t* DataOut, uint32_t* SliceOffsetsOut)
+	{
+		BlockID RowBuffer[CHUNK_SIZE];
+		uint8_t* Data = DataOut;
+
+		for (int32_t y = 0; y < CHUNK_SIZE; y++)
+		{
+			if (SliceOffsetsOut)
+				SliceOffsetsOut[y] = (uint32_t)(Data - DataOut);
+
+			for (int32_t x = 0; x < CHUNK_SIZE; x++)
+			{
+				uint32_t Index = FChunkGeometry::BlockIndex(x, y, 0);
+				const BlockID* Row = Blocks + Index;
+
+				// Gather the row if it is not contiguous in the layout
+				if (!CONTIGUOUS_ROWS)
+				{
+					for (int32_t z = 0; z < CHUNK_SIZE; z++)
+					{
+						RowBuffer[z] = Blocks[Index];
+						Index = FChunkGeometry::NextZ(Index);
+					}
+					Row = RowBuffer;
+				}
+
+				Data = EncodeRow(Row, Data);
+			}
+		}
+
+		return (uint32_t)(Data - DataOut);
+	}
+
+	void Decode(const uint8_t* Data, const uint32_t DataSize, BlockID* BlocksOut)
+	{
+		BlockID RowBuffer[CHUNK_SIZE + DECODE_PADDING];
+		const uint8_t* DataEnd = Data + DataSize;
+
+		for (int32_t y = 0; y < CHUNK_SIZE; y++)
+		{
+			for (int32_t x = 0; x < CHUNK_SIZE; x++)
+			{
+				uint32_t Index = FChunkGeometry::BlockIndex(x, y, 0);
+
+				// Contiguous rows are decoded in place. Stores past the end of a row are
+				// overwritten by the next row, or land in the padding after the last row.
+				if (CONTIGUOUS_ROWS)
+				{
+					Data = DecodeRow(Data, DataEnd, BlocksOut + Index);
+					continue;
+				}
+
+				Data = DecodeRow(Data, DataEnd, RowBuffer);
+				for (int32_t z = 0; z < CHUNK_SIZE; z++)
+				{
+					BlocksOut[Index] = RowBuffer[z];
+					Index = FChunkGeometry::NextZ(Index);
+				}
+			}
+		}
+	}
+
+	void DecodeSlice(const uint8_t* SliceData, const uint8_t* DataEnd, BlockID* BlocksOut)
+	{
+		// Stores past the end of a row are overwritten by the next row
+		for (int32_t x = 0; x < CHUNK_SIZE; x++)
+			SliceData = DecodeRow(SliceData, DataEnd, BlocksOut + x * CHUNK_SIZE);
+	}
+
+	BlockID ReadBlock(const uint8_t* SliceData, const int32_t X, const int32_t Z)
+	{
+		// Skip the rows before the block
+		for (int32_t x = 0; x < X; x++)
+		{
+			int32_t z = 0;
+			while (z < CHUNK_SIZE)
+			{
+				z += SliceData[sizeof(BlockID)];
+				SliceData += RUN_SIZE;
+			}
+		}
+
+		// Find the run holding the block
+		int32_t RunEnd = SliceData[sizeof(BlockID)];
+		while (RunEnd <= Z)
+		{
+			SliceData += RUN_SIZE;
+			RunEnd += SliceData[sizeof(BlockID)];
+		}
+
+		BlockID ID;
+		std::memcpy(&ID, SliceData, sizeof(ID));
+		return ID;
+	}
+}
@@ -0,0 +1,134 @@
+#include "ChunkSystems\StreamGovernor.h"
+#include "Clock.h"
+#include "Misc\Assertions.h"
+
+#include <algorithm>
+
+#undef min
+#undef max
+
+static const float DEFAULT_TARGET_FRAME_TIME = 1.0f / 60.0f;
+
+// Share of the target frame time that can be spent uploading meshes
+static const float UPLOAD_TIME_SHARE = 0.25f;
+
+static const uint32_t MIN_UPLOAD_BYTES = 256 * 1024;
+static const uint32_t MAX_UPLOAD_BYTES = 32 * 1024 * 1024;
+static const uint32_t DEFAULT_UPLOAD_BYTES = 4 * 1024 * 1024;
+
+// Frame times are smoothed so single slow frames, like those that load a shader, aren't acted on
+static const float FRAME_TIME_SMOOTHING = 0.1f;
+
+// Frames are over budget past the target by this much, and have headroom under it by this much
+static const float OVER_BUDGET_SCALE = 1.1f;
+static const float HEADROOM_SCALE = 0.8f;
+
+// Frames in a row over budget or with headroom before loading is throttled or released by a step
+static const int32_t LOAD_THROTTLE_FRAMES = 15;
+static const uint32_t MAX_LOAD_THROTTLE = 4;
+
+// Frames in a row over budget before the view distance is stepped down. It is stepped
+// back up twice as slowly so it doesn't bounce between two distances.
+static const int32_t VIEW_STEP_FRAMES = 90;
+
+FStreamGovernor::FStreamGovernor()
+	: mTargetFrameTime(DEFAULT_TARGET_FRAME_TIME)
+	, mAverageFrameTime(DEFAULT_TARGET_FRAME_TIME)
+	, mPressureFrames(0)
+	, mUploadByteBudget(DEFAULT_UPLOAD_BYTES)
+	, mUploadCycleBudget(FClock::SecondsToCycles(DEFAULT_TARGET_FRAME_TIME * UPLOAD_TIME_SHARE))
+	, mUploadStart(0)
+	, mUploadedBytes(0)
+	, mLoadThrottle()
+	, mViewDistanceCut(0)
+	, mMaxViewDistanceCut(0)
+	, mScaleViewDistance(false)
+{
+	mLoadThrottle = 0;
+}
+
+void FStreamGovernor::SetTargetFrameTime(const float Seconds)
+{
+	ASSERT(Seconds > 0.0f);
+	mTargetFrameTime = Seconds;
+	mUploadCycleBudget = FClock::SecondsToCycles(Seconds * UPLOAD_TIME_SHARE);
+	mPressureFrames = 0;
+}
+
+void FStreamGovernor::SetViewScaling(const bool Enabled)
+{
+	mScaleViewDistance = Enabled;
+	if (!Enabled)
+		mViewDistanceCut = 0;
+}
+
+void FStreamGovernor::SetMaxViewDistanceCut(const uint32_t Steps)
+{
+	mMaxViewDistanceCut = Steps;
+	mViewDistanceCut = std::min(mViewDistanceCut, Steps);
+}
+
+void FStreamGovernor::Update(const float FrameSeconds)
+{
+	mAverageFrameTime += (FrameSeconds - mAverageFrameTime) * FRAME_TIME_SMOOTHING;
+
+	if (mAverageFrameTime > mTargetFrameTime * OVER_BUDGET_SCALE)
+		mPressureFrames = std::max(mPressureFrames, 0) + 1;
+	else if (mAverageFrameTime < mTargetFrameTime * HEADROOM_SCALE)
+		mPressureFrames = std::min(mPressureFrames, 0) - 1;
+	else
+		mPressureFrames = 0;
+
+	if (mPressureFrames > 0)
+	{
+		mUploadByteBudget = std::max(mUploadByteBudget / 4 * 3, MIN_UPLOAD_BYTES);
+
+		if (mPressureFrames % LOAD_THROTTLE_FRAMES == 0 && mLoadThrottle < MAX_LOAD_THROTTLE)
+			mLoadThrottle++;
+
+		// Uploads and loads are cut back first, as they only slow down streaming
+		if (mScaleViewDistance && mPressureFrames >= VIEW_STEP_FRAMES)
+		{
+			if (mViewDistanceCut < mMaxViewDistanceCut)
+				mViewDistanceCut++;
+
+			mPressureFrames = 0;
+		}
+	}
+	else if (mPressureFrames < 0)
+	{
+		mUploadByteBudget = std::min(mUploadByteBudget / 4 * 5, MAX_UPLOAD_BYTES);
+
+		if (-mPressureFrames % LOAD_THROTTLE_FRAMES == 0 && mLoadThrottle > 0)
+			mLoadThrottle--;
+
+		if (-mPressureFrames >= 2 * VIEW_STEP_FRAMES)
+		{
+			if (mViewDistanceCut > 0)
+				mViewDistanceCut--;
+
+			mPressureFrames = 0;
+		}
+	}
+}
+
+void FStreamGovernor::BeginUploads()
+{
+	mUploadStart = FClock::ReadSystemTimer();
+	mUploadedBytes = 0;
+}
+
+void FStreamGovernor::AddUpload(const uint32_t Bytes)
+{
+	mUploadedBytes += Bytes;
+}
+
+bool FStreamGovernor::IsUploadBudgetSpent() const
+{
+	return mUploadedBytes >= mUploadByteBudget || FClock::ReadSystemTimer() - mUploadStart >= mUploadCycleBudget;
+}
+
+uint32_t FStreamGovernor::GetLoadBatchSize(const uint32_t MaxBatchSize) const
+{
+	return std::max(MaxBatchSize >> mLoadThrottle, 1u);
+}
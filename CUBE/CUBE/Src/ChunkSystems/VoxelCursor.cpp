@@ -0,0 +1,41 @@
+#include "ChunkSystems\VoxelCursor.h"
+#include "ChunkSystems\ChunkManager.h"
+
+FVoxelCursor::FVoxelCursor(const FChunkManager& ChunkManager, const Vector3i& Position)
+	: mChunkManager(&ChunkManager)
+	, mChunk(nullptr)
+	, mChunkLock()
+	, mPosition(Position)
+	, mLocalPosition()
+{
+	FindChunk();
+}
+
+FVoxelCursor::FVoxelCursor(FVoxelCursor&& Other)
+	: mChunkManager(Other.mChunkManager)
+	, mChunk(Other.mChunk)
+	, mChunkLock(std::move(Other.mChunkLock))
+	, mPosition(Other.mPosition)
+	, mLocalPosition(Other.mLocalPosition)
+{
+	Other.mChunk = nullptr;
+}
+
+void FVoxelCursor::MoveTo(const Vector3i& Position)
+{
+	mPosition = Position;
+	FindChunk();
+}
+
+void FVoxelCursor::FindChunk()
+{
+	mLocalPosition = FChunk::LocalPosition(mPosition);
+
+	// The chunk is looked up again even if the slot is the same, as it may have been given
+	// another chunk's blocks. Only one block lock is held at a time.
+	if (mChunkLock.owns_lock())
+		mChunkLock.unlock();
+
+	const int32_t Index = mChunkManager->LockLoadedChunk(mPosition, mChunkLock);
+	mChunk = (Index >= 0) ? &mChunkManager->mChunks[Index] : nullptr;
+}
@@ -120,6 +120,10 @@ uint32_t FWorldGenerator::BuildChunk(const Vector3i& WorldPosition, const utils:
 	const float MinHeight = (float)mMinHeight;
 	const float MaxHeight = (float)mMaxHeight;
 
+	// Track if every run covers a full row of the same block type
+	bool IsUniform = true;
+	FBlockTypes::BlockID UniformType = FBlock::AIR_BLOCK_ID;
+
 	for (int32_t y = 0; y < FChunk::CHUNK_SIZE; y++)
 	{
 		const int32_t WorldY = y + WorldPosition.y;
@@ -150,14 +154,29 @@ uint32_t FWorldGenerator::BuildChunk(const Vector3i& WorldPosition, const utils:
 					xzHeight = FMath::MapValue(SlabValues[WorldZ + Length] + 1, -1.0f, 1.0f, MinHeight, MaxHeight);
 				}
 
-				DataOut.push_back(IsAir ? FBlock::AIR_BLOCK_ID : BlockType);
+				const FBlockTypes::BlockID RunType = IsAir ? FBlock::AIR_BLOCK_ID : BlockType;
+				const uint8_t* RunTypeBytes = reinterpret_cast<const uint8_t*>(&RunType);
+				DataOut.insert(DataOut.end(), RunTypeBytes, RunTypeBytes + sizeof(RunType));
 				DataOut.push_back(Length);
-				DataSize += 2;
+				DataSize += FChunk::RLE_RUN_SIZE;
 				z += Length;
+
+				if (DataSize == FChunk::RLE_RUN_SIZE)
+					UniformType = RunType;
+				IsUniform = IsUniform && (Length == FChunk::CHUNK_SIZE) && (RunType == UniformType);
 			}
 		}
 	}
 
+	// Uniform chunks are stored as a single block ID
+	if (IsUniform)
+	{
+		DataOut.resize(DataOut.size() - DataSize);
+		const uint8_t* UniformTypeBytes = reinterpret_cast<const uint8_t*>(&UniformType);
+		DataOut.insert(DataOut.end(), UniformTypeBytes, UniformTypeBytes + sizeof(UniformType));
+		DataSize = sizeof(UniformType);
+	}
+
 	return DataSize;
 }
 
@@ -0,0 +1,780 @@
+#include "..\..\Include\Debugging\Benchmarks.h"
+#include "..\..\Include\Debugging\ConsoleOutput.h"
+#include "..\..\Include\Memory\PoolAllocator.h"
+#include "..\..\Include\Memory\ConcurrentPoolAllocator.h"
+#include "..\..\Include\ChunkSystems\Chunk.h"
+#include "..\..\Include\ChunkSystems\RunLengthCodec.h"
+#include "..\..\Include\ChunkSystems\GreedyMesher.h"
+#include "..\..\Include\ChunkSystems\ChunkWorkerPool.h"
+#include "..\..\Include\FileIO\RegionFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <memory>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+namespace
+{
+	// Pool layout used by the pool benchmarks. Matches the size of a block storage page.
+	static const uint32_t ELEMENT_SIZE = 4096;
+	static const uint32_t POOL_SIZE = 16 * 1024;
+
+	// Allocations held by each thread at once, and the number of times they are cycled
+	static const uint32_t LIVE_ALLOCATIONS = 256;
+	static const uint32_t ROUNDS = 2000;
+
+	/**
+	* Mutex guarded FPoolAllocator. This is how pools were shared between threads before
+	* FConcurrentPoolAllocator.
+	*/
+	class FLockedPool
+	{
+	public:
+		FLockedPool()
+			: mPool(16)
+			, mMutex()
+		{}
+
+		void* Allocate()
+		{
+			std::lock_guard<std::mutex> Lock(mMutex);
+			return mPool.Allocate();
+		}
+
+		void Free(void* Data)
+		{
+			std::lock_guard<std::mutex> Lock(mMutex);
+			mPool.Free(Data);
+		}
+
+		void FlushThreadCache() {}
+
+	private:
+		FPoolAllocator<ELEMENT_SIZE, POOL_SIZE> mPool;
+		std::mutex mMutex;
+	};
+
+	typedef FConcurrentPoolAllocator<ELEMENT_SIZE, POOL_SIZE> FLockFreePool;
+
+	template <typename PoolType>
+	/**
+	* Runs allocate and free cycles on a shared pool from a number of threads.
+	* Each thread frees its allocations in a different order than it allocated them.
+	* @return Millions of allocate and free pairs per second over all threads.
+	*/
+	double RunPoolThreads(PoolType& Pool, const uint32_t ThreadCount)
+	{
+		std::vector<std::thread> Threads;
+		std::atomic<uint32_t> ThreadsReady(0);
+		std::atomic<bool> Start(false);
+
+		auto Worker = [&Pool, &ThreadsReady, &Start]()
+		{
+			void* Allocations[LIVE_ALLOCATIONS];
+
+			ThreadsReady++;
+			while (!Start)
+				std::this_thread::yield();
+
+			for (uint32_t Round = 0; Round < ROUNDS; Round++)
+			{
+				for (uint32_t i = 0; i < LIVE_ALLOCATIONS; i++)
+					Allocations[i] = Pool.Allocate();
+
+				for (uint32_t i = 0; i < LIVE_ALLOCATIONS; i++)
+					Pool.Free(Allocations[(i * 7) % LIVE_ALLOCATIONS]);
+			}
+
+			Pool.FlushThreadCache();
+			FThreadSlot::Release();
+		};
+
+		for (uint32_t i = 0; i < ThreadCount; i++)
+			Threads.push_back(std::thread(Worker));
+
+		while (ThreadsReady != ThreadCount)
+			std::this_thread::yield();
+
+		const auto StartTime = std::chrono::high_resolution_clock::now();
+		Start = true;
+
+		for (auto& Thread : Threads)
+			Thread.join();
+
+		const std::chrono::duration<double> Seconds = std::chrono::high_resolution_clock::now() - StartTime;
+		return (double)ThreadCount * ROUNDS * LIVE_ALLOCATIONS / Seconds.count() / 1000000.0;
+	}
+
+	// Number of times each chunk operation is repeated
+	static const uint32_t CHUNK_ITERATIONS = 100;
+	static const uint32_t CHUNK_EDITS = 1000000;
+
+	// Chunks streamed by each stage of the streaming benchmark, and the number of times they are streamed
+	static const uint32_t STREAM_CHUNKS = 64;
+	static const uint32_t STREAM_ROUNDS = 10;
+
+	/**
+	* Builds RLE data for a chunk of rolling terrain with a few block types and scattered holes.
+	*/
+	void BuildTestChunk(std::vector<uint8_t>& DataOut)
+	{
+		const int32_t Size = FChunk::CHUNK_SIZE;
+
+		for (int32_t y = 0; y < Size; y++)
+		{
+			for (int32_t x = 0; x < Size; x++)
+			{
+				FBlockTypes::BlockID RunType = 0;
+				uint8_t Length = 0;
+
+				for (int32_t z = 0; z < Size; z++)
+				{
+					const int32_t Height = Size / 2 + (int32_t)(std::sin(x * 0.3f) * std::cos(z * 0.2f) * Size / 4);
+					FBlockTypes::BlockID Type = (y < Height - 3) ? 1 : (y < Height) ? 2 : FBlock::AIR_BLOCK_ID;
+					if ((x * 7 + y * 13 + z * 3) % 17 == 0)
+						Type = FBlock::AIR_BLOCK_ID;
+
+					if (Length > 0 && Type != RunType)
+					{
+						const uint8_t* RunTypeBytes = reinterpret_cast<const uint8_t*>(&RunType);
+						DataOut.insert(DataOut.end(), RunTypeBytes, RunTypeBytes + sizeof(RunType));
+						DataOut.push_back(Length);
+						Length = 0;
+					}
+
+					RunType = Type;
+					Length++;
+				}
+
+				const uint8_t* RunTypeBytes = reinterpret_cast<const uint8_t*>(&RunType);
+				DataOut.insert(DataOut.end(), RunTypeBytes, RunTypeBytes + sizeof(RunType));
+				DataOut.push_back(Length);
+			}
+		}
+	}
+
+	/**
+	* Per-run scalar RLE decoder. The reference for FRunLengthCodec::Decode.
+	*/
+	void ScalarDecode(const std::vector<uint8_t>& Data, FBlockTypes::BlockID* BlocksOut)
+	{
+		uint32_t TypeIndex = 0;
+		for (int32_t y = 0; y < FChunk::CHUNK_SIZE; y++)
+		{
+			for (int32_t x = 0; x < FChunk::CHUNK_SIZE; x++)
+			{
+				uint32_t Index = FChunkGeometry::BlockIndex(x, y, 0);
+				for (int32_t z = 0; z < FChunk::CHUNK_SIZE;)
+				{
+					FBlockTypes::BlockID BlockType;
+					std::memcpy(&BlockType, &Data[TypeIndex], sizeof(BlockType));
+					const uint8_t RunLength = Data[TypeIndex + sizeof(BlockType)];
+
+					for (uint8_t i = 0; i < RunLength; i++)
+					{
+						BlocksOut[Index] = BlockType;
+						Index = FChunkGeometry::NextZ(Index);
+					}
+
+					z += RunLength;
+					TypeIndex += FRunLengthCodec::RUN_SIZE;
+				}
+			}
+		}
+	}
+
+	/**
+	* Per-run scalar RLE encoder. The reference for FRunLengthCodec::Encode.
+	*/
+	void ScalarEncode(const FBlockTypes::BlockID* Blocks, std::vector<uint8_t>& DataOut)
+	{
+		for (int32_t y = 0; y < FChunk::CHUNK_SIZE; y++)
+		{
+			for (int32_t x = 0; x < FChunk::CHUNK_SIZE; x++)
+			{
+				uint32_t Index = FChunkGeometry::BlockIndex(x, y, 0);
+				for (int32_t z = 0; z < FChunk::CHUNK_SIZE;)
+				{
+					const FBlockTypes::BlockID CurrentBlock = Blocks[Index];
+					uint8_t Length = 1;
+					Index = FChunkGeometry::NextZ(Index);
+
+					while (Length + z < FChunk::CHUNK_SIZE && Blocks[Index] == CurrentBlock)
+					{
+						Length++;
+						Index = FChunkGeometry::NextZ(Index);
+					}
+
+					const uint8_t* BlockBytes = reinterpret_cast<const uint8_t*>(&CurrentBlock);
+					DataOut.insert(DataOut.end(), BlockBytes, BlockBytes + sizeof(CurrentBlock));
+					DataOut.push_back(Length);
+					z += (int32_t)Length;
+				}
+			}
+		}
+	}
+
+	/**
+	* Checks if a block is solid. Blocks one step outside the chunk are read from the apron.
+	*/
+	bool IsSolid(const FBlockTypes::BlockID* Blocks, const FChunk::Apron& Neighbors, const int32_t* x)
+	{
+		const int32_t Size = FChunk::CHUNK_SIZE;
+
+		// Bit set of the axes the block is past the low side of the chunk along
+		uint32_t Low = 0;
+		uint32_t Outside = 0;
+		int32_t Inside = 0;
+		for (int32_t i = 0; i < 3; i++)
+		{
+			Low |= (uint32_t)(x[i] < 0) << i;
+			Outside += (x[i] < 0 || x[i] >= Size);
+			Inside = (x[i] < 0 || x[i] >= Size) ? Inside : i;
+		}
+
+		FBlockTypes::BlockID ID;
+		if (Outside == 0)
+		{
+			ID = Blocks[FChunkGeometry::BlockIndex(x[0], x[1], x[2])];
+		}
+		else if (Outside == 1)
+		{
+			const int32_t d = (x[0] < 0 || x[0] >= Size) ? 0 : (x[1] < 0 || x[1] >= Size) ? 1 : 2;
+			ID = Neighbors.Blocks[2 * d + (Low != 0)][x[(d + 1) % 3] + x[(d + 2) % 3] * Size];
+		}
+		else if (Outside == 2)
+		{
+			const uint32_t Edge = Inside * 4 + ((Low >> ((Inside + 1) % 3)) & 1) + 2 * ((Low >> ((Inside + 2) % 3)) & 1);
+			ID = Neighbors.Edges[Edge][x[Inside]];
+		}
+		else
+		{
+			ID = Neighbors.Corners[Low];
+		}
+
+		return ID != FBlock::AIR_BLOCK_ID;
+	}
+
+	/**
+	* Finds the ambient occlusion of a face from the three blocks around each of its corners in
+	* the slice in front of it, one block at a time.
+	* @param x - Position of the face's cell in the slice in front of it.
+	*/
+	uint8_t ScalarFaceOcclusion(const FBlockTypes::BlockID* Blocks, const FChunk::Apron& Neighbors, const int32_t d, const int32_t* x)
+	{
+		const int32_t u = (d + 1) % 3;
+		const int32_t v = (d + 2) % 3;
+
+		uint32_t Occlusion = 0;
+		for (uint32_t Corner = 0; Corner < 4; Corner++)
+		{
+			int32_t SideU[3] = { x[0], x[1], x[2] };
+			int32_t SideV[3] = { x[0], x[1], x[2] };
+			SideU[u] += 2 * FChunkMesh::QUAD_CORNERS[Corner][0] - 1;
+			SideV[v] += 2 * FChunkMesh::QUAD_CORNERS[Corner][1] - 1;
+			int32_t Diagonal[3] = { SideU[0], SideU[1], SideU[2] };
+			Diagonal[v] = SideV[v];
+
+			const uint32_t Sides = IsSolid(Blocks, Neighbors, SideU) + IsSolid(Blocks, Neighbors, SideV);
+			const uint32_t Level = (Sides == 2) ? 0 : 3 - Sides - IsSolid(Blocks, Neighbors, Diagonal);
+			Occlusion |= Level << (2 * Corner);
+		}
+
+		return (uint8_t)Occlusion;
+	}
+
+	/**
+	* Per-cell greedy mesher by Mikola Lysenko, as FChunk::GreedyMesh() used to build each layer.
+	* The reference for FGreedyMesher.
+	* @param WithOcclusion - If faces only join when their occlusion matches, as well as their types.
+	*/
+	void ScalarGreedyLayer(const FBlockTypes::BlockID* Blocks, const FChunk::Apron& Neighbors, const uint32_t Face, const int32_t Depth, const bool WithOcclusion, std::vector<FGreedyMesher::FQuad>& QuadsOut)
+	{
+		const int32_t Size = FChunk::CHUNK_SIZE;
+		const int32_t d = Face / 2;
+		const int32_t u = (d + 1) % 3;
+		const int32_t v = (d + 2) % 3;
+		const bool BackFace = (Face & 1) != 0;
+
+		// The layer lies between slices x[d] and x[d] + 1
+		int32_t x[3] = { 0, 0, 0 };
+		int32_t q[3] = { 0, 0, 0 };
+		x[d] = BackFace ? Depth - 1 : Depth;
+		q[d] = 1;
+
+		// Compute mask. Each cell holds the face's type, and its occlusion above the type's bits.
+		static const uint32_t OCCLUSION_SHIFT = 8 * sizeof(FBlockTypes::BlockID);
+		uint32_t Mask[Size * Size];
+		int32_t n = 0;
+
+		for (x[v] = 0; x[v] < Size; x[v]++)
+		{
+			for (x[u] = 0; x[u] < Size; x[u]++, n++)
+			{
+				const FBlockTypes::BlockID Voxel1 = (x[d] >= 0) ? Blocks[FChunkGeometry::BlockIndex(x[0], x[1], x[2])] : Neighbors.Blocks[2 * d + 1][n];
+				const FBlockTypes::BlockID Voxel2 = (x[d] < Size - 1) ? Blocks[FChunkGeometry::BlockIndex(x[0] + q[0], x[1] + q[1], x[2] + q[2])] : Neighbors.Blocks[2 * d][n];
+				Mask[n] = (Voxel1 == Voxel2) ? (FBlockTypes::BlockID)FBlock::AIR_BLOCK_ID : BackFace ? Voxel2 : Voxel1;
+
+				if (WithOcclusion && Mask[n] != FBlock::AIR_BLOCK_ID)
+				{
+					// The slice in front of back faces is before the layer, and after it for front faces
+					int32_t Front[3] = { x[0], x[1], x[2] };
+					Front[d] += BackFace ? 0 : 1;
+					Mask[n] |= (uint32_t)ScalarFaceOcclusion(Blocks, Neighbors, d, Front) << OCCLUSION_SHIFT;
+				}
+			}
+		}
+
+		// Generate the quads for the mask
+		n = 0;
+		for (int32_t j = 0; j < Size; j++)
+		{
+			for (int32_t i = 0; i < Size;)
+			{
+				if (Mask[n] == FBlock::AIR_BLOCK_ID)
+				{
+					i++;
+					n++;
+					continue;
+				}
+
+				int32_t Width = 1;
+				while (i + Width < Size && Mask[n + Width] == Mask[n])
+					Width++;
+
+				int32_t Height = 1;
+				bool Done = false;
+				for (; j + Height < Size; Height++)
+				{
+					for (int32_t k = 0; k < Width; k++)
+					{
+						if (Mask[n + k + Height * Size] != Mask[n])
+						{
+							Done = true;
+							break;
+						}
+					}
+
+					if (Done)
+						break;
+				}
+
+				FGreedyMesher::FQuad Quad;
+				Quad.U = (uint8_t)i;
+				Quad.V = (uint8_t)j;
+				Quad.Width = (uint8_t)Width;
+				Quad.Height = (uint8_t)Height;
+				Quad.Occlusion = WithOcclusion ? (uint8_t)(Mask[n] >> OCCLUSION_SHIFT) : FGreedyMesher::UNOCCLUDED;
+				Quad.Type = (FBlockTypes::BlockID)Mask[n];
+				QuadsOut.push_back(Quad);
+
+				// Zero the mask
+				for (int32_t l = 0; l < Height; l++)
+					for (int32_t k = 0; k < Width; k++)
+						Mask[n + k + l * Size] = FBlock::AIR_BLOCK_ID;
+
+				i += Width;
+				n += Width;
+			}
+		}
+	}
+
+	/**
+	* Reads the RLE data of every chunk in a world that is not stored as a single block ID.
+	*/
+	void ReadWorldChunks(const wchar_t* WorldName, std::vector<std::vector<uint8_t>>& ChunksOut)
+	{
+		IFileSystem& FileSystem = IFileSystem::GetInstance();
+
+		std::wstring Filepath{ L"./Worlds/" };
+		Filepath += WorldName;
+		Filepath += L"/WorldInfo.vgw";
+
+		auto WorldInfoFile = FileSystem.OpenReadable(Filepath.c_str());
+		if (!WorldInfoFile)
+			return;
+
+		int32_t WorldSize = 0;
+		WorldInfoFile->Read((uint8_t*)&WorldSize, 4);
+
+		const int32_t RegionSize = (int32_t)FRegionFile::RegionData::REGION_SIZE;
+		const int32_t NumRegions = (WorldSize / RegionSize) + 1;
+
+		for (int32_t ry = 0; ry < NumRegions; ry++)
+		{
+			for (int32_t rx = 0; rx < NumRegions; rx++)
+			{
+				for (int32_t rz = 0; rz < NumRegions; rz++)
+				{
+					FRegionFile Region;
+					if (!Region.Load(WorldName, Vector3i{ rx, ry, rz }))
+						continue;
+
+					for (int32_t i = 0; i < RegionSize * RegionSize * RegionSize; i++)
+					{
+						const Vector3i ChunkPosition{ i % RegionSize, (i / RegionSize) % RegionSize, i / (RegionSize * RegionSize) };
+						const uint32_t DataSize = Region.GetChunkDataSize(ChunkPosition);
+						if (DataSize <= sizeof(FBlockTypes::BlockID))
+							continue;
+
+						ChunksOut.push_back(std::vector<uint8_t>(DataSize));
+						Region.GetChunkData(ChunkPosition, ChunksOut.back().data(), DataSize);
+					}
+				}
+			}
+		}
+	}
+
+	double MillisecondsSince(const std::chrono::high_resolution_clock::time_point& StartTime)
+	{
+		const std::chrono::duration<double, std::milli> Elapsed = std::chrono::high_resolution_clock::now() - StartTime;
+		return Elapsed.count();
+	}
+}
+
+namespace FBenchmarks
+{
+	void PoolContention()
+	{
+		static_assert(16 * LIVE_ALLOCATIONS <= POOL_SIZE, "Pool must hold the allocations of every thread.");
+
+		// Pools are large, keep them off the stack
+		std::unique_ptr<FLockedPool> LockedPool{ new FLockedPool };
+		std::unique_ptr<FLockFreePool> LockFreePool{ new FLockFreePool(16) };
+
+		FDebug::PrintF("Pool contention (million allocate/free pairs per second)");
+		FDebug::PrintF("Threads   Mutex pool   Concurrent pool");
+
+		for (uint32_t ThreadCount = 1; ThreadCount <= 16; ThreadCount *= 2)
+		{
+			const double Locked = RunPoolThreads(*LockedPool, ThreadCount);
+			const double LockFree = RunPoolThreads(*LockFreePool, ThreadCount);
+			FDebug::PrintF("%7u   %10.2f   %15.2f", ThreadCount, Locked, LockFree);
+		}
+	}
+
+	void ChunkLayout()
+	{
+		std::vector<uint8_t> ChunkData;
+		BuildTestChunk(ChunkData);
+
+		FChunk Chunk;
+		std::vector<uint8_t> UnloadData;
+
+		// RLE codec and block storage packing
+		auto StartTime = std::chrono::high_resolution_clock::now();
+		for (uint32_t i = 0; i < CHUNK_ITERATIONS; i++)
+		{
+			UnloadData.clear();
+			Chunk.Load(ChunkData);
+			Chunk.Unload(UnloadData);
+		}
+		const double LoadTime = MillisecondsSince(StartTime) / CHUNK_ITERATIONS;
+
+		// Meshing, with no neighbors loaded
+		std::unique_ptr<FChunk::Apron> Neighbors{ new FChunk::Apron };
+		std::memset(Neighbors.get(), FBlock::AIR_BLOCK_ID, sizeof(FChunk::Apron));
+
+		// Shared meshes would be found after the first build
+		const bool ShareMeshes = FChunk::ShareMeshes;
+		FChunk::ShareMeshes = false;
+
+		Chunk.Load(ChunkData);
+		bool IsShared = false;
+		StartTime = std::chrono::high_resolution_clock::now();
+		for (uint32_t i = 0; i < CHUNK_ITERATIONS; i++)
+			Chunk.GreedyMesh(*Neighbors, 0, Vector3i{ 0, 0, 0 }, nullptr, IsShared);
+		const double MeshTime = MillisecondsSince(StartTime) / CHUNK_ITERATIONS;
+
+		FChunk::ShareMeshes = ShareMeshes;
+
+		// Random edits
+		uint32_t Random = 1;
+		uint32_t Solid = 0;
+		StartTime = std::chrono::high_resolution_clock::now();
+		for (uint32_t i = 0; i < CHUNK_EDITS; i++)
+		{
+			Random = Random * 1103515245 + 12345;
+			const Vector3i Position{ (int32_t)(Random >> 8) & (FChunk::CHUNK_SIZE - 1),
+				(int32_t)(Random >> 14) & (FChunk::CHUNK_SIZE - 1),
+				(int32_t)(Random >> 20) & (FChunk::CHUNK_SIZE - 1) };
+
+			if (Random & 0x80000000)
+				Chunk.SetBlock(Position, (FBlockTypes::BlockID)(Random & 0x3));
+			else
+				Solid += Chunk.GetBlock(Position) != FBlock::AIR_BLOCK_ID;
+		}
+		const double EditTime = MillisecondsSince(StartTime);
+
+		UnloadData.clear();
+		Chunk.Unload(UnloadData);
+
+		FDebug::PrintF("Chunk layout %s, edge %d (%u solid reads)", FChunkGeometry::Layout::Name(), FChunk::CHUNK_SIZE, Solid);
+		FDebug::PrintF("Load and unload   %8.3f ms", LoadTime);
+		FDebug::PrintF("Greedy mesh       %8.3f ms", MeshTime);
+		FDebug::PrintF("%u edits       %8.3f ms", CHUNK_EDITS, EditTime);
+	}
+
+	void GreedyMesher()
+	{
+		std::vector<uint8_t> ChunkData;
+		BuildTestChunk(ChunkData);
+
+		std::vector<FBlockTypes::BlockID> Blocks(FChunk::BLOCKS_PER_CHUNK + FRunLengthCodec::DECODE_PADDING);
+		FRunLengthCodec::Decode(ChunkData.data(), (uint32_t)ChunkData.size(), Blocks.data());
+
+		// Bury the chunk so its bottom faces are covered and the rest of its border is open. The
+		// ground under the chunk's bottom edges and corners occludes the faces beside them.
+		std::unique_ptr<FChunk::Apron> Neighbors{ new FChunk::Apron };
+		std::memset(Neighbors.get(), FBlock::AIR_BLOCK_ID, sizeof(FChunk::Apron));
+		std::fill(Neighbors->Blocks[FChunk::NormalID::Bottom], Neighbors->Blocks[FChunk::NormalID::Bottom] + FChunk::CHUNK_SIZE * FChunk::CHUNK_SIZE, (FBlockTypes::BlockID)1);
+
+		for (uint32_t Edge = 0; Edge < 12; Edge++)
+		{
+			// Edges under the chunk run along x or z, past the low side of y
+			if ((Edge / 4 == 0 && (Edge & 1)) || (Edge / 4 == 2 && (Edge & 2)))
+				std::fill(Neighbors->Edges[Edge], Neighbors->Edges[Edge] + FChunk::CHUNK_SIZE, (FBlockTypes::BlockID)1);
+		}
+
+		for (uint32_t Corner = 0; Corner < 8; Corner++)
+			Neighbors->Corners[Corner] = (Corner & 2) ? 1 : FBlock::AIR_BLOCK_ID;
+
+		// Check that both meshers build the same quads for every layer, first without occlusion and then with it
+		std::vector<FGreedyMesher::FQuad> ScalarQuads;
+		std::vector<FGreedyMesher::FQuad> BitQuads;
+		FGreedyMesher Mesher;
+		Mesher.SetBlocks(Blocks.data(), Neighbors->Blocks, Neighbors->Edges, Neighbors->Corners);
+
+		uint32_t QuadCount = 0;
+		uint32_t Mismatches = 0;
+		uint32_t OcclusionMismatches = 0;
+		for (uint32_t Pass = 0; Pass < 2; Pass++)
+		{
+			const bool WithOcclusion = (Pass == 1);
+			Mesher.SetOcclusion(WithOcclusion);
+
+			for (uint32_t Face = 0; Face < 6; Face++)
+			{
+				for (int32_t Depth = 0; Depth < FChunk::CHUNK_SIZE; Depth++)
+				{
+					ScalarQuads.clear();
+					BitQuads.clear();
+					ScalarGreedyLayer(Blocks.data(), *Neighbors, Face, Depth, WithOcclusion, ScalarQuads);
+					Mesher.BuildLayer(Face, Depth, BitQuads);
+
+					QuadCount += WithOcclusion ? 0 : (uint32_t)ScalarQuads.size();
+					bool Same = (ScalarQuads.size() == BitQuads.size());
+					for (size_t i = 0; Same && i < ScalarQuads.size(); i++)
+					{
+						const FGreedyMesher::FQuad& A = ScalarQuads[i];
+						const FGreedyMesher::FQuad& B = BitQuads[i];
+						Same = (A.U == B.U && A.V == B.V && A.Width == B.Width && A.Height == B.Height && A.Type == B.Type && A.Occlusion == B.Occlusion);
+					}
+
+					if (!Same && WithOcclusion)
+						OcclusionMismatches++;
+					else if (!Same)
+						Mismatches++;
+				}
+			}
+		}
+
+		Mesher.SetOcclusion(false);
+
+		// Time the quads of a whole chunk
+		auto StartTime = std::chrono::high_resolution_clock::now();
+		for (uint32_t i = 0; i < CHUNK_ITERATIONS; i++)
+		{
+			for (uint32_t Face = 0; Face < 6; Face++)
+			{
+				for (int32_t Depth = 0; Depth < FChunk::CHUNK_SIZE; Depth++)
+				{
+					ScalarQuads.clear();
+					ScalarGreedyLayer(Blocks.data(), *Neighbors, Face, Depth, false, ScalarQuads);
+				}
+			}
+		}
+		const double ScalarTime = MillisecondsSince(StartTime) / CHUNK_ITERATIONS;
+
+		StartTime = std::chrono::high_resolution_clock::now();
+		for (uint32_t i = 0; i < CHUNK_ITERATIONS; i++)
+		{
+			Mesher.SetBlocks(Blocks.data(), Neighbors->Blocks, Neighbors->Edges, Neighbors->Corners);
+			for (uint32_t Face = 0; Face < 6; Face++)
+			{
+				for (int32_t Depth = 0; Depth < FChunk::CHUNK_SIZE; Depth++)
+				{
+					BitQuads.clear();
+					Mesher.BuildLayer(Face, Depth, BitQuads);
+				}
+			}
+		}
+		const double BitTime = MillisecondsSince(StartTime) / CHUNK_ITERATIONS;
+
+		uint32_t OccludedQuadCount = 0;
+		Mesher.SetOcclusion(true);
+		StartTime = std::chrono::high_resolution_clock::now();
+		for (uint32_t i = 0; i < CHUNK_ITERATIONS; i++)
+		{
+			OccludedQuadCount = 0;
+			Mesher.SetBlocks(Blocks.data(), Neighbors->Blocks, Neighbors->Edges, Neighbors->Corners);
+			for (uint32_t Face = 0; Face < 6; Face++)
+			{
+				for (int32_t Depth = 0; Depth < FChunk::CHUNK_SIZE; Depth++)
+				{
+					BitQuads.clear();
+					Mesher.BuildLayer(Face, Depth, BitQuads);
+					OccludedQuadCount += (uint32_t)BitQuads.size();
+				}
+			}
+		}
+		const double OccludedTime = MillisecondsSince(StartTime) / CHUNK_ITERATIONS;
+
+		FDebug::PrintF("Greedy mesher, edge %d, %u quads, %u mismatched layers, %u with occlusion", FChunk::CHUNK_SIZE, QuadCount, Mismatches, OcclusionMismatches);
+		FDebug::PrintF("Per-cell   %8.3f ms", ScalarTime);
+		FDebug::PrintF("Bit mask   %8.3f ms", BitTime);
+		FDebug::PrintF("Bit mask with occlusion %8.3f ms, %u quads", OccludedTime, OccludedQuadCount);
+	}
+
+	void ChunkStreaming()
+	{
+		std::vector<uint8_t> ChunkData;
+		BuildTestChunk(ChunkData);
+
+		std::unique_ptr<FChunk[]> Chunks{ new FChunk[STREAM_CHUNKS] };
+		std::vector<std::vector<uint8_t>> UnloadData(STREAM_CHUNKS);
+
+		std::unique_ptr<FChunk::Apron> Neighbors{ new FChunk::Apron };
+		std::memset(Neighbors.get(), FBlock::AIR_BLOCK_ID, sizeof(FChunk::Apron));
+
+		// Every chunk holds the same blocks, so shared meshes would be found after the first build
+		const bool ShareMeshes = FChunk::ShareMeshes;
+		FChunk::ShareMeshes = false;
+
+		// Thread slots are left for the main thread and any others that use the block pools
+		const uint32_t MaxThreads = std::min(std::max(std::thread::hardware_concurrency(), 1u), (uint32_t)FThreadSlot::MAX_THREADS / 2);
+		std::vector<uint32_t> ThreadCounts;
+		for (uint32_t ThreadCount = 1; ThreadCount < MaxThreads; ThreadCount *= 2)
+			ThreadCounts.push_back(ThreadCount);
+		ThreadCounts.push_back(MaxThreads);
+
+		// Speedups only mean something next to the number of cores they were measured on
+		FDebug::PrintF("Chunk streaming, edge %d, %u hardware threads (chunks loaded, meshed and unloaded per second)", FChunk::CHUNK_SIZE, std::thread::hardware_concurrency());
+		FDebug::PrintF("Threads   Chunks/s   Speedup");
+
+		double SingleThreadRate = 0.0;
+		for (const uint32_t ThreadCount : ThreadCounts)
+		{
+			// The calling thread runs jobs too
+			FChunkWorkerPool Pool;
+			Pool.Start(ThreadCount - 1);
+
+			const auto StartTime = std::chrono::high_resolution_clock::now();
+			for (uint32_t Round = 0; Round < STREAM_ROUNDS; Round++)
+			{
+				Pool.Run(STREAM_CHUNKS, [&Chunks, &ChunkData](uint32_t i)
+				{
+					Chunks[i].Load(ChunkData);
+				});
+
+				Pool.Run(STREAM_CHUNKS, [&Chunks, &Neighbors](uint32_t i)
+				{
+					bool IsShared = false;
+					Chunks[i].GreedyMesh(*Neighbors, 0, Vector3i{ (int32_t)i, 0, 0 }, nullptr, IsShared);
+				});
+
+				Pool.Run(STREAM_CHUNKS, [&Chunks, &UnloadData](uint32_t i)
+				{
+					UnloadData[i].clear();
+					Chunks[i].Unload(UnloadData[i]);
+				});
+			}
+			const double ChunksPerSecond = STREAM_CHUNKS * STREAM_ROUNDS / (MillisecondsSince(StartTime) / 1000.0);
+
+			Pool.Stop();
+
+			if (ThreadCount == 1)
+				SingleThreadRate = ChunksPerSecond;
+
+			FDebug::PrintF("%7u   %8.0f   %7.2f", ThreadCount, ChunksPerSecond, ChunksPerSecond / SingleThreadRate);
+		}
+
+		FChunk::ShareMeshes = ShareMeshes;
+	}
+
+	void RunLengthCodec(const wchar_t* WorldName)
+	{
+		std::vector<std::vector<uint8_t>> Chunks;
+		ReadWorldChunks(WorldName, Chunks);
+
+		if (Chunks.empty())
+		{
+			FDebug::PrintF("No chunk data found for the run-length benchmark.");
+			return;
+		}
+
+		// Decoded blocks for every chunk
+		const uint32_t BlocksSize = FChunk::BLOCKS_PER_CHUNK + FRunLengthCodec::DECODE_PADDING;
+		std::vector<FBlockTypes::BlockID> Blocks(Chunks.size() * BlocksSize);
+		std::vector<uint8_t> Encoded(FRunLengthCodec::MAX_ENCODED_SIZE);
+		std::vector<uint8_t> ScalarEncoded;
+		ScalarEncoded.reserve(FRunLengthCodec::MAX_ENCODED_SIZE);
+
+		// Check that both codecs produce the same bytes as the world files
+		uint32_t Mismatches = 0;
+		for (size_t c = 0; c < Chunks.size(); c++)
+		{
+			FBlockTypes::BlockID* ChunkBlocks = &Blocks[c * BlocksSize];
+			FRunLengthCodec::Decode(Chunks[c].data(), (uint32_t)Chunks[c].size(), ChunkBlocks);
+
+			const uint32_t DataSize = FRunLengthCodec::Encode(ChunkBlocks, Encoded.data());
+			ScalarEncoded.clear();
+			ScalarEncode(ChunkBlocks, ScalarEncoded);
+
+			if (DataSize != Chunks[c].size() || std::memcmp(Encoded.data(), Chunks[c].data(), DataSize) != 0 || ScalarEncoded != Chunks[c])
+				Mismatches++;
+		}
+
+		const uint32_t Iterations = 10;
+		double Times[4] = {};
+
+		for (uint32_t i = 0; i < Iterations; i++)
+		{
+			auto StartTime = std::chrono::high_resolution_clock::now();
+			for (size_t c = 0; c < Chunks.size(); c++)
+				ScalarDecode(Chunks[c], &Blocks[c * BlocksSize]);
+			Times[0] += MillisecondsSince(StartTime);
+
+			StartTime = std::chrono::high_resolution_clock::now();
+			for (size_t c = 0; c < Chunks.size(); c++)
+				FRunLengthCodec::Decode(Chunks[c].data(), (uint32_t)Chunks[c].size(), &Blocks[c * BlocksSize]);
+			Times[1] += MillisecondsSince(StartTime);
+
+			StartTime = std::chrono::high_resolution_clock::now();
+			for (size_t c = 0; c < Chunks.size(); c++)
+			{
+				ScalarEncoded.clear();
+				ScalarEncode(&Blocks[c * BlocksSize], ScalarEncoded);
+			}
+			Times[2] += MillisecondsSince(StartTime);
+
+			StartTime = std::chrono::high_resolution_clock::now();
+			for (size_t c = 0; c < Chunks.size(); c++)
+				FRunLengthCodec::Encode(&Blocks[c * BlocksSize], Encoded.data());
+			Times[3] += MillisecondsSince(StartTime);
+		}
+
+		// Throughput in decoded blocks
+		const double MegaBlocks = (double)Chunks.size() * FChunk::BLOCKS_PER_CHUNK * Iterations / 1000000.0;
+
+		FDebug::PrintF("Run-length codec, %u chunks, %u mismatches (million blocks per second)", (uint32_t)Chunks.size(), Mismatches);
+		FDebug::PrintF("          Scalar      SIMD");
+		FDebug::PrintF("Decode  %8.1f  %8.1f", MegaBlocks / Times[0] * 1000.0, MegaBlocks / Times[1] * 1000.0);
+		FDebug::PrintF("Encode  %8.1f  %8.1f", MegaBlocks / Times[2] * 1000.0, MegaBlocks / Times[3] * 1000.0);
+	}
+}
@@ -1,8 +1,10 @@
 #include "Debugging\GameConsole.h"
 #include "Input\ButtonEvent.h"
 #include "Debugging\DebugText.h"
+#include "Debugging\Benchmarks.h"
 #include "Input\TextEntered.h"
 #include "Physics\PhysicsSystem.h"
+#include "Memory\AllocationCounter.h"
 #include "ChunkSystems\ChunkManager.h"
 #include "Rendering\Screen.h"
 #include "Rendering\Camera.h"
@@ -62,13 +64,27 @@ namespace FDebug
 		swprintf_s(String, L"+");
 		DebugText.AddText(std::wstring{ String }, SScreen::GetResolution() / 2, TextMarkup);
 
-		swprintf_s(String, L"Chunks used: %d", FChunk::ChunkAllocator.Size());
+		swprintf_s(String, L"Block pages used: %d   Hibernated blocks: %d KB   Cells: %d KB   Stream allocations: %d   Cached meshes: %d/%d", FBlockStorage::GetPagesInUse(), FChunk::GetHibernatedMemoryUsage() / 1024,
+		           FChunk::GetCellMemoryUsage() / 1024, FAllocationCounter::GetAllocations(),
+		           FMeshCacheFile::GetHits(), FMeshCacheFile::GetHits() + FMeshCacheFile::GetMisses());
 		DebugText.AddText(std::wstring{ String }, Vector2i(50, SScreen::GetResolution().y - 100), TextMarkup);
 
 		Vector3i ChunkPosition = Vector3i(CameraPosition.x / FChunk::CHUNK_SIZE, CameraPosition.y / FChunk::CHUNK_SIZE, CameraPosition.z / FChunk::CHUNK_SIZE);
-		swprintf_s(String, L"Chunk Position: %d %d %d", ChunkPosition.x, ChunkPosition.y, ChunkPosition.z);
+		if (mChunkManager)
+			swprintf_s(String, L"Chunk Position: %d %d %d   Streaming: %.0f chunks/s on %d threads", ChunkPosition.x, ChunkPosition.y, ChunkPosition.z,
+			           mChunkManager->GetStreamRate(), mChunkManager->GetStreamThreadCount());
+		else
+			swprintf_s(String, L"Chunk Position: %d %d %d", ChunkPosition.x, ChunkPosition.y, ChunkPosition.z);
 		DebugText.AddText(std::wstring{ String }, Vector2i(50, SScreen::GetResolution().y - 150), TextMarkup);
 
+		if (mChunkManager)
+		{
+			const FStreamGovernor& Governor = mChunkManager->GetStreamGovernor();
+			swprintf_s(String, L"Frame: %.1f ms   Mesh uploads: %d/%d KB   View distance cut: %d", Governor.GetAverageFrameTime() * 1000.0f,
+			           Governor.GetUploadedBytes() / 1024, Governor.GetUploadByteBudget() / 1024, Governor.GetViewDistanceCut());
+			DebugText.AddText(std::wstring{ String }, Vector2i(50, SScreen::GetResolution().y - 200), TextMarkup);
+		}
+
 		///////////////////////////////////////////////
 		///////////////////////////////
 
@@ -132,6 +148,48 @@ namespace FDebug
 			std::wstring Distance = mCommandBuffer.substr(16, 18);
 			mChunkManager->SetViewDistance((int32_t)std::stoi(Distance));
 		}
+		else if (mChunkManager && mCommandBuffer.substr(0, 15) == std::wstring{ L"SetLodDistance " })
+		{
+			// SetLodDistance <level> <distance>
+			const std::wstring Arguments = mCommandBuffer.substr(15);
+			size_t DistanceStart = 0;
+			const uint32_t Lod = (uint32_t)std::stoi(Arguments, &DistanceStart);
+			if (Lod > 0 && Lod < FChunk::LOD_LEVELS)
+				mChunkManager->SetLodDistance(Lod, (uint32_t)std::stoi(Arguments.substr(DistanceStart)));
+		}
+		else if (mChunkManager && mCommandBuffer.substr(0, 15) == std::wstring{ L"HibernateChunks" })
+		{
+			mChunkManager->SetChunkHibernation(mCommandBuffer.substr(15) == std::wstring{ L" true" });
+		}
+		else if (mChunkManager && mCommandBuffer.substr(0, 11) == std::wstring{ L"CacheMeshes" })
+		{
+			mChunkManager->SetMeshCaching(mCommandBuffer.substr(11) == std::wstring{ L" true" });
+		}
+		else if (mChunkManager && mCommandBuffer.substr(0, 12) == std::wstring{ L"FrameBudget " })
+		{
+			// FrameBudget <milliseconds>
+			const float Milliseconds = std::stof(mCommandBuffer.substr(12));
+			if (Milliseconds > 0.0f)
+				mChunkManager->SetFrameBudget(Milliseconds);
+		}
+		else if (mChunkManager && mCommandBuffer.substr(0, 17) == std::wstring{ L"ScaleViewDistance" })
+		{
+			mChunkManager->SetViewDistanceScaling(mCommandBuffer.substr(17) == std::wstring{ L" true" });
+		}
+		else if (mCommandBuffer.substr(0, 10) == std::wstring{ L"Benchmark " })
+		{
+			const std::wstring Benchmark = mCommandBuffer.substr(10);
+			if (Benchmark == std::wstring{ L"PoolContention" })
+				FBenchmarks::PoolContention();
+			else if (Benchmark == std::wstring{ L"ChunkLayout" })
+				FBenchmarks::ChunkLayout();
+			else if (Benchmark == std::wstring{ L"GreedyMesher" })
+				FBenchmarks::GreedyMesher();
+			else if (Benchmark == std::wstring{ L"ChunkStreaming" })
+				FBenchmarks::ChunkStreaming();
+			else if (Benchmark.substr(0, 10) == std::wstring{ L"RunLength " })
+				FBenchmarks::RunLengthCodec(Benchmark.substr(10).c_str());
+		}
 	}
 
 	void GameConsole::SetPhysicsSystem(FPhysicsSystem* Physics)
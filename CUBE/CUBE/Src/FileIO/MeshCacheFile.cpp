@@ -0,0 +1,380 @@
+#include "FileIO\MeshCacheFile.h"
+#include "FileIO\RegionFile.h"
+#include "ChunkSystems\Chunk.h"
+#include "Misc\Assertions.h"
+
+#include <atomic>
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <wchar.h>
+#include <cstring>
+
+namespace
+{
+	static const uint32_t MESH_FILE_MAGIC = 0x4D584F56; // "VOXM"
+	static const uint32_t REGION_SIZE = FRegionFile::RegionData::REGION_SIZE;
+
+	// Each chunk has an entry for its mesh at every level of detail, followed by one for its cells
+	static const uint32_t ENTRIES_PER_CHUNK = FChunk::LOD_LEVELS + 1;
+	static const uint32_t CELL_ENTRY = FChunk::LOD_LEVELS;
+	static const uint32_t TABLE_ENTRIES = REGION_SIZE * REGION_SIZE * REGION_SIZE * ENTRIES_PER_CHUNK;
+	static const uint32_t QUAD_SIZE = sizeof(FChunkMesh::Quad);
+
+	// Cells are checked by their size instead of a hash
+	static const uint64_t CELL_HASH = 1;
+
+	static const uint8_t FilePadding[4096] = {};
+
+	std::atomic<uint32_t> Hits(0);
+	std::atomic<uint32_t> Misses(0);
+}
+
+FMeshCacheFile::FMeshCacheFile()
+	: mFile()
+	, mFreeBlocks()
+	, mFileMutex()
+{
+}
+
+bool FMeshCacheFile::Load(const wchar_t* WorldName, const Vector3i& RegionPosition)
+{
+	auto& FileSystem = IFileSystem::GetInstance();
+
+	// Mesh caches sit next to the region files of the world
+	std::wstring Directory{ L"./Worlds/" };
+	Directory += WorldName;
+	FileSystem.CreateFileDirectory(Directory.c_str());
+
+	const std::wstring Filepath = GetFilepath(WorldName, RegionPosition);
+
+	FileHeader Expected;
+	Expected.Magic = MESH_FILE_MAGIC;
+	Expected.Version = MESH_VERSION;
+	Expected.ChunkSize = FChunkGeometry::CHUNK_SIZE;
+	Expected.QuadSize = sizeof(FChunkMesh::Quad);
+
+	mFreeBlocks.clear();
+
+	if (FileSystem.FileExists(Filepath.c_str()))
+	{
+		mFile = FileSystem.OpenReadWritable(Filepath.c_str(), true);
+		ASSERT(mFile);
+
+		// Meshes built by another mesher are thrown out with the file
+		FileHeader Header;
+		mFile->SeekFromStart(0);
+		if (mFile->Read((uint8_t*)&Header, sizeof(Header)) && std::memcmp(&Header, &Expected, sizeof(Header)) == 0)
+		{
+			FindFreeBlocks();
+			return true;
+		}
+
+		mFile.reset();
+		FileSystem.DeleteFilename(Filepath.c_str());
+	}
+
+	mFile = FileSystem.OpenReadWritable(Filepath.c_str(), true, true);
+	if (!mFile)
+		return false;
+
+	// Add the header and an empty lookup table
+	if (!mFile->Write((uint8_t*)&Expected, sizeof(Expected)) || !WritePadding(TABLE_ENTRIES * sizeof(LookupEntry)))
+	{
+		mFile.reset();
+		FileSystem.DeleteFilename(Filepath.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+bool FMeshCacheFile::Exists(const wchar_t* WorldName, const Vector3i& RegionPosition)
+{
+	return IFileSystem::GetInstance().FileExists(GetFilepath(WorldName, RegionPosition).c_str());
+}
+
+bool FMeshCacheFile::ReadMesh(const Vector3i& ChunkPosition, const uint32_t Lod, const uint64_t Hash, FChunkMesh::QuadData& QuadsOut)
+{
+	ASSERT(mFile);
+
+	std::lock_guard<std::mutex> Lock(mFileMutex);
+
+	LookupEntry Entry;
+	ReadEntry(GetTableIndex(ChunkPosition, Lod), Entry);
+
+	if (Entry.Hash != Hash || Hash == 0)
+	{
+		Misses.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	QuadsOut.resize(Entry.Size / QUAD_SIZE);
+	if (Entry.Size != 0)
+	{
+		mFile->SeekFromStart(Entry.Offset);
+		if (!mFile->Read((uint8_t*)QuadsOut.data(), Entry.Size))
+		{
+			QuadsOut.clear();
+			Misses.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+	}
+
+	Hits.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+bool FMeshCacheFile::WriteMesh(const Vector3i& ChunkPosition, const uint32_t Lod, const uint64_t Hash, const FChunkMesh::QuadData& Quads)
+{
+	ASSERT(mFile && Hash != 0 && Lod < FChunk::LOD_LEVELS);
+
+	std::lock_guard<std::mutex> Lock(mFileMutex);
+	return WriteData(GetTableIndex(ChunkPosition, Lod), Hash, 0, (const uint8_t*)Quads.data(), (uint32_t)Quads.size() * QUAD_SIZE);
+}
+
+bool FMeshCacheFile::ReadCells(const Vector3i& ChunkPosition, const uint32_t MaxLod, std::vector<uint8_t>& CellDataOut, uint32_t& LodOut)
+{
+	ASSERT(mFile);
+
+	std::lock_guard<std::mutex> Lock(mFileMutex);
+
+	LookupEntry Entry;
+	ReadEntry(GetTableIndex(ChunkPosition, CELL_ENTRY), Entry);
+
+	if (Entry.Hash != CELL_HASH || Entry.Lod == 0 || Entry.Lod > MaxLod)
+		return false;
+
+	// Cells are either uniform or one block ID per cell
+	const uint32_t Size = FChunk::CHUNK_SIZE >> Entry.Lod;
+	if (Entry.Size != sizeof(FBlockTypes::BlockID) && Entry.Size != Size * Size * Size * sizeof(FBlockTypes::BlockID))
+		return false;
+
+	CellDataOut.resize(Entry.Size);
+	if (!mFile->SeekFromStart(Entry.Offset) || !mFile->Read(CellDataOut.data(), Entry.Size))
+	{
+		CellDataOut.clear();
+		return false;
+	}
+
+	LodOut = Entry.Lod;
+	return true;
+}
+
+bool FMeshCacheFile::WriteCells(const Vector3i& ChunkPosition, const uint32_t Lod, const std::vector<uint8_t>& CellData)
+{
+	ASSERT(mFile && Lod > 0 && Lod < FChunk::LOD_LEVELS);
+
+	std::lock_guard<std::mutex> Lock(mFileMutex);
+	return WriteData(GetTableIndex(ChunkPosition, CELL_ENTRY), CELL_HASH, Lod, CellData.data(), (uint32_t)CellData.size());
+}
+
+void FMeshCacheFile::RemoveCells(const Vector3i& ChunkPosition)
+{
+	ASSERT(mFile);
+
+	const uint32_t Index = GetTableIndex(ChunkPosition, CELL_ENTRY);
+
+	std::lock_guard<std::mutex> Lock(mFileMutex);
+
+	// The block is kept for the next cells written
+	LookupEntry Entry;
+	ReadEntry(Index, Entry);
+	if (Entry.Hash != 0)
+	{
+		Entry.Hash = 0;
+		WriteEntry(Index, Entry);
+	}
+}
+
+bool FMeshCacheFile::WriteData(const uint32_t Index, const uint64_t Hash, const uint32_t Lod, const uint8_t* Data, const uint32_t Size)
+{
+	LookupEntry OldEntry;
+	ReadEntry(Index, OldEntry);
+	LookupEntry Entry = OldEntry;
+
+	// Data that doesn't fit in its block gets a new one with room to grow
+	const bool IsMoved = (Size > Entry.Capacity);
+	if (IsMoved)
+	{
+		Entry.Capacity = Size + Size / 4;
+		Entry.Offset = AllocateBlock(Entry.Capacity);
+	}
+
+	Entry.Hash = Hash;
+	Entry.Size = Size;
+	Entry.Lod = Lod;
+
+	bool IsWritten = mFile->SeekFromStart(Entry.Offset) && mFile->Write(Data, Size);
+
+	// Reserve the rest of blocks at the end of the file so the next block starts after them
+	const uint32_t BlockEnd = Entry.Offset + Entry.Capacity;
+	if (IsWritten && IsMoved && BlockEnd > mFile->GetFileSize())
+		IsWritten = WritePadding(BlockEnd - mFile->GetFileSize());
+
+	if (IsWritten && WriteEntry(Index, Entry))
+	{
+		// The old block is only given up once the entry no longer points to it
+		if (IsMoved)
+			FreeBlock(OldEntry.Offset, OldEntry.Capacity);
+
+		return true;
+	}
+
+	if (IsMoved)
+	{
+		// The old data is untouched, but is no longer the entry's last data
+		FreeBlock(Entry.Offset, Entry.Capacity);
+		Entry = OldEntry;
+	}
+
+	// The old data may have been partly overwritten, so it is never read again
+	Entry.Hash = 0;
+	WriteEntry(Index, Entry);
+	return false;
+}
+
+uint32_t FMeshCacheFile::GetHits()
+{
+	return Hits.load(std::memory_order_relaxed);
+}
+
+uint32_t FMeshCacheFile::GetMisses()
+{
+	return Misses.load(std::memory_order_relaxed);
+}
+
+std::wstring FMeshCacheFile::GetFilepath(const wchar_t* WorldName, const Vector3i& RegionPosition)
+{
+	static const uint32_t DirectoryBufferSize = 300;
+
+	std::wstring Filepath{ L"./Worlds/" };
+	Filepath += WorldName;
+
+	wchar_t Filename[DirectoryBufferSize];
+	int32_t CharCount = swprintf(Filename, DirectoryBufferSize, L"/x%dy%dz%d.vgm", RegionPosition.x, RegionPosition.y, RegionPosition.z);
+	Filename[CharCount] = L'\0';
+
+	Filepath += Filename;
+	return Filepath;
+}
+
+uint32_t FMeshCacheFile::GetTableIndex(const Vector3i& ChunkPosition, const uint32_t Entry)
+{
+	ASSERT(Entry < ENTRIES_PER_CHUNK);
+
+	const Vector3i Local = FRegionFile::LocalRegionPosition(ChunkPosition);
+	const uint32_t ChunkIndex = (uint32_t)Local.x * REGION_SIZE + (uint32_t)Local.y * REGION_SIZE * REGION_SIZE + (uint32_t)Local.z;
+	return ChunkIndex * ENTRIES_PER_CHUNK + Entry;
+}
+
+void FMeshCacheFile::ReadEntry(const uint32_t Index, LookupEntry& EntryOut)
+{
+	mFile->SeekFromStart(sizeof(FileHeader) + Index * sizeof(LookupEntry));
+	if (!mFile->Read((uint8_t*)&EntryOut, sizeof(LookupEntry)))
+		std::memset(&EntryOut, 0, sizeof(LookupEntry));
+}
+
+bool FMeshCacheFile::WriteEntry(const uint32_t Index, const LookupEntry& Entry)
+{
+	return mFile->SeekFromStart(sizeof(FileHeader) + Index * sizeof(LookupEntry)) &&
+	       mFile->Write((const uint8_t*)&Entry, sizeof(LookupEntry));
+}
+
+bool FMeshCacheFile::WritePadding(uint32_t Size)
+{
+	while (Size > 0)
+	{
+		const uint32_t Count = std::min(Size, (uint32_t)sizeof(FilePadding));
+		if (!mFile->Write(FilePadding, Count))
+			return false;
+
+		Size -= Count;
+	}
+
+	return true;
+}
+
+void FMeshCacheFile::FindFreeBlocks()
+{
+	std::vector<LookupEntry> Table(TABLE_ENTRIES);
+	mFile->SeekFromStart(sizeof(FileHeader));
+	if (!mFile->Read((uint8_t*)Table.data(), TABLE_ENTRIES * sizeof(LookupEntry)))
+		return;
+
+	// Blocks in file order
+	std::vector<std::pair<uint32_t, uint32_t>> Blocks;
+	for (const auto& Entry : Table)
+	{
+		if (Entry.Capacity != 0)
+			Blocks.push_back(std::make_pair(Entry.Offset, Entry.Capacity));
+	}
+
+	std::sort(Blocks.begin(), Blocks.end());
+
+	uint32_t End = sizeof(FileHeader) + TABLE_ENTRIES * sizeof(LookupEntry);
+	for (const auto& Block : Blocks)
+	{
+		if (Block.first > End)
+			mFreeBlocks[End] = Block.first - End;
+
+		End = std::max(End, Block.first + Block.second);
+	}
+
+	if (End < mFile->GetFileSize())
+	{
+		mFile->SeekFromStart(End);
+		mFile->Truncate();
+	}
+}
+
+uint32_t FMeshCacheFile::AllocateBlock(const uint32_t Size)
+{
+	for (auto Block = mFreeBlocks.begin(); Block != mFreeBlocks.end(); ++Block)
+	{
+		if (Block->second < Size)
+			continue;
+
+		const uint32_t Offset = Block->first;
+		const uint32_t Remaining = Block->second - Size;
+		mFreeBlocks.erase(Block);
+
+		if (Remaining != 0)
+			mFreeBlocks[Offset + Size] = Remaining;
+
+		return Offset;
+	}
+
+	return mFile->GetFileSize();
+}
+
+void FMeshCacheFile::FreeBlock(uint32_t Offset, uint32_t Size)
+{
+	if (Size == 0)
+		return;
+
+	auto Next = mFreeBlocks.lower_bound(Offset);
+	if (Next != mFreeBlocks.end() && Next->first == Offset + Size)
+	{
+		Size += Next->second;
+		Next = mFreeBlocks.erase(Next);
+	}
+
+	if (Next != mFreeBlocks.begin())
+	{
+		auto Previous = std::prev(Next);
+		if (Previous->first + Previous->second == Offset)
+		{
+			Offset = Previous->first;
+			Size += Previous->second;
+			mFreeBlocks.erase(Previous);
+		}
+	}
+
+	// Free space at the end of the file is given back to the file system
+	if (Offset + Size >= mFile->GetFileSize() && mFile->SeekFromStart(Offset) && mFile->Truncate())
+		return;
+
+	mFreeBlocks[Offset] = Size;
+}
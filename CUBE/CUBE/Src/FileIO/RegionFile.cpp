@@ -1,6 +1,7 @@
 #include "FileIO/RegionFile.h"
 #include "Misc\Assertions.h"
 #include <wchar.h>
+#include <cstring>
 
 static const uint8_t FilePadding[sizeof(FRegionFile::RegionData)];
 
@@ -56,28 +57,42 @@ bool FRegionFile::Load(const wchar_t* WorldName, const Vector3i& RegionPosition)
 	return mRegionFile->Read((uint8_t*)&mRegionData, sizeof(RegionData));
 }
 
-void FRegionFile::GetChunkDataInfo(const Vector3i& ChunkPosition, uint32_t& SizeOut, uint32_t& SectorOffsetOut)
+uint32_t FRegionFile::GetChunkDataSize(const Vector3i& ChunkPosition)
 {
-	uint32_t TableIndex = GetTableIndex(ChunkPosition);
+	const LookupEntry& ChunkEntry = mRegionData.ChunkEntry[GetTableIndex(ChunkPosition)];
+
+	if (ChunkEntry.HasInlineData())
+	{
+		return (ChunkEntry.Offset >> 16) & 0x3;
+	}
 
 	// If number of sectors for the chunk is 0, the chunk is not in the file yet
-	if (mRegionData.ChunkEntry[TableIndex].NumOfSectors <= 0)
+	if (ChunkEntry.NumOfSectors == 0)
 	{
-		SizeOut = 0;
-		return;
+		return 0;
 	}
 
-	SectorOffsetOut = mRegionData.ChunkEntry[TableIndex].Offset;
-	mRegionFile->SeekFromStart(sizeof(RegionData) + SectorOffsetOut * RegionData::SECTOR_SIZE);
-	mRegionFile->Read((uint8_t*)&SizeOut, 4);
+	uint32_t Size = 0;
+	mRegionFile->SeekFromStart(sizeof(RegionData) + ChunkEntry.Offset * RegionData::SECTOR_SIZE);
+	mRegionFile->Read((uint8_t*)&Size, 4);
+	return Size;
 }
 
-void FRegionFile::GetChunkData(const uint32_t SectorOffset, uint8_t* DataOut, const uint32_t DataSize)
+void FRegionFile::GetChunkData(const Vector3i& ChunkPosition, uint8_t* DataOut, const uint32_t DataSize)
 {
 	ASSERT(DataSize != 0);
 
+	const LookupEntry& ChunkEntry = mRegionData.ChunkEntry[GetTableIndex(ChunkPosition)];
+
+	if (ChunkEntry.HasInlineData())
+	{
+		const uint32_t InlineData = ChunkEntry.Offset & 0xFFFF;
+		std::memcpy(DataOut, &InlineData, DataSize);
+		return;
+	}
+
 	// Add offset after region data block and offset for chunk data size (4 bytes)
-	mRegionFile->SeekFromStart((sizeof(RegionData) + SectorOffset * RegionData::SECTOR_SIZE) + 4);
+	mRegionFile->SeekFromStart((sizeof(RegionData) + ChunkEntry.Offset * RegionData::SECTOR_SIZE) + 4);
 	mRegionFile->Read(DataOut, DataSize);
 }
 
@@ -86,6 +101,19 @@ void FRegionFile::WriteChunkData(const Vector3i& ChunkPosition, const uint8_t* D
 	uint32_t TableIndex = GetTableIndex(ChunkPosition);
 	LookupEntry& ChunkEntry = mRegionData.ChunkEntry[TableIndex];
 
+	// Small data, such as uniform chunks, is kept in the lookup table instead of a sector
+	if (DataSize <= RegionData::INLINE_DATA_SIZE)
+	{
+		if (ChunkEntry.NumOfSectors != 0)
+			RemoveChunkSectors(ChunkEntry);
+
+		uint32_t InlineData = 0;
+		std::memcpy(&InlineData, Data, DataSize);
+		ChunkEntry.Offset = RegionData::INLINE_DATA_FLAG | (DataSize << 16) | InlineData;
+		ChunkEntry.NumOfSectors = 0;
+		return;
+	}
+
 	// If number of sectors are 0, the chunk is not in the file yet.
 	if (ChunkEntry.NumOfSectors != 0)
 	{
@@ -127,41 +155,50 @@ void FRegionFile::AddNewChunk(LookupEntry& ChunkEntry, const uint8_t* Data, cons
 }
 
 void FRegionFile::RelocateAndAddChunkData(LookupEntry& RelocationEntry, const uint8_t* Data, const uint32_t DataSize)
+{
+	RemoveChunkSectors(RelocationEntry);
+
+	//////////////////////////////////////////////////////////////////
+	// Add this chunk at the end of file
+
+	// Determine how many sectors are currently in this region file.
+	uint32_t SectorCount = (mRegionFile->GetFileSize() - sizeof(RegionData)) / RegionData::SECTOR_SIZE;
+	RelocationEntry.Offset = SectorCount;
+	RelocationEntry.NumOfSectors = 1 + ((DataSize + 4) / RegionData::SECTOR_SIZE); // add 4 bytes for data size
+
+	// We are already at the end of the old data, so just write from here
+	mRegionFile->Write((uint8_t*)&DataSize, 4); // Write size of data
+	mRegionFile->Write(Data, DataSize); // Write chunk data
+
+	// Add padding to the rest of the sector
+	mRegionFile->Write(FilePadding, (RelocationEntry.NumOfSectors * RegionData::SECTOR_SIZE) - DataSize - 4);
+}
+
+void FRegionFile::RemoveChunkSectors(const LookupEntry& RemovedEntry)
 {
 	// Copy all data after this sector, then write it starting at this sector
-	uint32_t RelocationDataStart = sizeof(RegionData) + ((RelocationEntry.Offset + RelocationEntry.NumOfSectors) * RegionData::SECTOR_SIZE);
+	uint32_t RelocationDataStart = sizeof(RegionData) + ((RemovedEntry.Offset + RemovedEntry.NumOfSectors) * RegionData::SECTOR_SIZE);
 	uint32_t RelocationDataSize = mRegionFile->GetFileSize() - RelocationDataStart;
 
 	// Get data to shift left
-	std::unique_ptr<uint8_t> RelocationData{ new uint8_t[RelocationDataSize] };
+	std::unique_ptr<uint8_t[]> RelocationData{ new uint8_t[RelocationDataSize] };
 	mRegionFile->SeekFromStart(RelocationDataStart);
 	mRegionFile->Read(RelocationData.get(), RelocationDataSize);
 
 	// Seek to the point where this chunk sector started and shift data to this point
-	mRegionFile->SeekFromStart(RelocationDataStart - (RelocationEntry.NumOfSectors * RegionData::SECTOR_SIZE));
+	mRegionFile->SeekFromStart(RelocationDataStart - (RemovedEntry.NumOfSectors * RegionData::SECTOR_SIZE));
 	mRegionFile->Write(RelocationData.get(), RelocationDataSize);
 
-	// Decrement all offsets in lookup table that were effected
+	// Drop the sectors left over at the end so new chunks are appended right after the shifted data
+	mRegionFile->Truncate();
+
+	// Decrement all offsets in lookup table that were effected. Entries without sectors are skipped
+	// since their offset field may hold inline data.
 	for (auto& Entry : mRegionData.ChunkEntry)
 	{
-		if (Entry.Offset > RelocationEntry.Offset)
+		if (Entry.NumOfSectors != 0 && Entry.Offset > RemovedEntry.Offset)
 		{
-			Entry.Offset -= RelocationEntry.NumOfSectors;
+			Entry.Offset -= RemovedEntry.NumOfSectors;
 		}
 	}
-
-	//////////////////////////////////////////////////////////////////
-	// Add this chunk at the end of file, overwritting shifted data
-
-	// Determine how many sectors are currently in this region file.
-	uint32_t SectorCount = (mRegionFile->GetFileSize() - sizeof(RegionData)) / RegionData::SECTOR_SIZE;
-	RelocationEntry.Offset = SectorCount - RelocationEntry.NumOfSectors;
-	RelocationEntry.NumOfSectors = 1 + ((DataSize + 4) / RegionData::SECTOR_SIZE); // add 4 bytes for data size
-
-	// We are already at the end of the old data, so just write from here
-	mRegionFile->Write((uint8_t*)&DataSize, 4); // Write size of data
-	mRegionFile->Write(Data, DataSize); // Write chunk data
-
-	// Add padding to the rest of the sector
-	mRegionFile->Write(FilePadding, (RelocationEntry.NumOfSectors * RegionData::SECTOR_SIZE) - DataSize - 4);
 }
\ No newline at end of file
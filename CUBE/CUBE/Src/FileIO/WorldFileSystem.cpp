@@ -128,13 +128,13 @@ void FWorldFileSystem::GetChunkData(const Vector3i& ChunkPosition, std::vector<u
 
 	FRegionFile& File = mRegionFiles[RegionID].File;
 
-	// Get size and offset
-	uint32_t DataSize, SectorOffset;
-	File.GetChunkDataInfo(RegionPosition, DataSize, SectorOffset);
+	// Get size
+	const uint32_t DataSize = File.GetChunkDataSize(RegionPosition);
 
-	// Fill data buffer
+	// Fill data buffer. Chunks not in the file yet have no data.
 	DataOut.resize(DataSize);
-	File.GetChunkData(SectorOffset, DataOut.data(), DataSize);
+	if (DataSize != 0)
+		File.GetChunkData(RegionPosition, DataOut.data(), DataSize);
 
 }
 
@@ -145,7 +145,24 @@ void FWorldFileSystem::WriteChunkData(const Vector3i& ChunkPosition, const std::
 
 	ASSERT(mRegionFiles.find(RegionID) != mRegionFiles.end());
 
-	FRegionFile& File = mRegionFiles[RegionID].File;
-	File.WriteChunkData(RegionPosition, Data.data(), Data.size());
+	RegionFileRecord& Record = mRegionFiles[RegionID];
+	Record.File.WriteChunkData(RegionPosition, Data.data(), Data.size());
+
+	// Cells kept in the mesh cache were merged from the old blocks
+	FMeshCacheFile& MeshFile = Record.MeshFile;
+	if (MeshFile.IsLoaded() || (FMeshCacheFile::Exists(TEMP_DIRECTORY_NAME, RegionID) && MeshFile.Load(TEMP_DIRECTORY_NAME, RegionID)))
+		MeshFile.RemoveCells(ChunkPosition);
+}
+
+FMeshCacheFile* FWorldFileSystem::GetMeshCacheFile(const Vector3i& ChunkPosition)
+{
+	const Vector3i RegionID = FRegionFile::ChunkToRegionPosition(ChunkPosition);
+
+	ASSERT(mRegionFiles.find(RegionID) != mRegionFiles.end());
+
+	FMeshCacheFile& MeshFile = mRegionFiles[RegionID].MeshFile;
+	if (!MeshFile.IsLoaded() && !MeshFile.Load(TEMP_DIRECTORY_NAME, RegionID))
+		return nullptr;
 
+	return &MeshFile;
 }
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifdef __linux__
+
+#include "Memory\MemoryUtil.h"
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace FMemory
+{
+	void* ReserveVirtual(const size_t Bytes)
+	{
+		void* Address = mmap(nullptr, Bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		return (Address == MAP_FAILED) ? nullptr : Address;
+	}
+
+	bool CommitVirtual(void* Address, const size_t Bytes)
+	{
+		// Anonymous pages are zero filled and only backed by memory on first touch
+		return mprotect(Address, Bytes, PROT_READ | PROT_WRITE) == 0;
+	}
+
+	void ReleaseVirtual(void* Address, const size_t Bytes)
+	{
+		munmap(Address, Bytes);
+	}
+
+	void AdviseHugePages(void* Address, const size_t Bytes)
+	{
+#ifdef MADV_HUGEPAGE
+		madvise(Address, Bytes, MADV_HUGEPAGE);
+#endif
+	}
+
+	size_t GetVirtualPageSize()
+	{
+		return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	}
+}
+
+#endif
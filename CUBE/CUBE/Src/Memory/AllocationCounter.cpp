@@ -0,0 +1,97 @@
+#include "Memory\AllocationCounter.h"
+#include "Common.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	std::atomic<uint32_t> Allocations(0);
+
+	// If the calling thread is inside a counting scope
+	THREAD_LOCAL bool IsCounting = false;
+
+	void* CountedAllocate(const size_t Size)
+	{
+		if (IsCounting)
+			Allocations.fetch_add(1, std::memory_order_relaxed);
+
+		return std::malloc(Size ? Size : 1);
+	}
+}
+
+namespace FAllocationCounter
+{
+	FScope::FScope()
+		: mWasCounting(IsCounting)
+	{
+		IsCounting = true;
+	}
+
+	FScope::~FScope()
+	{
+		IsCounting = mWasCounting;
+	}
+
+	uint32_t GetAllocations()
+	{
+		return Allocations.load(std::memory_order_relaxed);
+	}
+
+	void* Allocate(size_t Size)
+	{
+		return CountedAllocate(Size);
+	}
+
+	void Free(void* Data)
+	{
+		std::free(Data);
+	}
+}
+
+// Replacements of the global allocation functions, so every allocation can be counted
+
+void* operator new(size_t Size)
+{
+	void* Data = CountedAllocate(Size);
+	if (!Data)
+		throw std::bad_alloc{};
+
+	return Data;
+}
+
+void* operator new[](size_t Size)
+{
+	return operator new(Size);
+}
+
+void* operator new(size_t Size, const std::nothrow_t&) throw()
+{
+	return CountedAllocate(Size);
+}
+
+void* operator new[](size_t Size, const std::nothrow_t&) throw()
+{
+	return CountedAllocate(Size);
+}
+
+void operator delete(void* Data) throw()
+{
+	std::free(Data);
+}
+
+void operator delete[](void* Data) throw()
+{
+	std::free(Data);
+}
+
+void operator delete(void* Data, const std::nothrow_t&) throw()
+{
+	std::free(Data);
+}
+
+void operator delete[](void* Data, const std::nothrow_t&) throw()
+{
+	std::free(Data);
+}
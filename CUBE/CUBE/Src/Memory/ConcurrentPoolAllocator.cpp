@@ -0,0 +1,48 @@
+#include "..\..\Include\Memory\ConcurrentPoolAllocator.h"
+
+static_assert(FThreadSlot::MAX_THREADS <= 64, "Thread slots are tracked in a 64 bit mask.");
+
+namespace
+{
+	// Bit set of slots held by running threads
+	std::atomic<uint64_t> ClaimedSlots(0);
+
+	// Slot of the calling thread, offset by one so zero means unassigned
+	THREAD_LOCAL int32_t ThreadSlot = 0;
+}
+
+namespace FThreadSlot
+{
+	int32_t Get()
+	{
+		if (ThreadSlot != 0)
+			return ThreadSlot - 1;
+
+		uint64_t Claimed = ClaimedSlots.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			if (Claimed == ~0ull)
+				return NO_SLOT;
+
+			// Claim the lowest free slot
+			int32_t Slot = 0;
+			while (Claimed & (1ull << Slot))
+				Slot++;
+
+			if (ClaimedSlots.compare_exchange_weak(Claimed, Claimed | (1ull << Slot)))
+			{
+				ThreadSlot = Slot + 1;
+				return Slot;
+			}
+		}
+	}
+
+	void Release()
+	{
+		if (ThreadSlot == 0)
+			return;
+
+		ClaimedSlots.fetch_and(~(1ull << (ThreadSlot - 1)));
+		ThreadSlot = 0;
+	}
+}
@@ -0,0 +1,19 @@
+#include "Memory\RecyclingAllocator.h"
+
+namespace
+{
+	std::atomic<uint32_t> HeapAllocations(0);
+}
+
+namespace FRecyclingAllocatorStats
+{
+	uint32_t GetHeapAllocations()
+	{
+		return HeapAllocations.load(std::memory_order_relaxed);
+	}
+
+	void AddHeapAllocation()
+	{
+		HeapAllocations.fetch_add(1, std::memory_order_relaxed);
+	}
+}
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "Components\RigidBody.h"
 #include "Components\Collider.h"
 #include "Debugging\DebugDraw.h"
+#include "Memory\AllocationCounter.h"
 #include "SFML\Window\Keyboard.hpp"
 
 FPhysicsSystem::FPhysicsSystem(Atlas::FWorld& World)
@@ -17,6 +18,9 @@ FPhysicsSystem::FPhysicsSystem(Atlas::FWorld& World)
 	, mConstraintSolver()
 	, mDynamicsWorld(&mCollisionDispatcher, &mBroadPhase, &mConstraintSolver, &mCollisionConfig)
 {
+	// Collision shapes and BVHs built while streaming chunks are counted with other allocations
+	btAlignedAllocSetCustom(&FAllocationCounter::Allocate, &FAllocationCounter::Free);
+
 	mDynamicsWorld.setGravity(btVector3{ 0, -10, 0 });
 	mDynamicsWorld.setDebugDrawer(FDebug::Draw::GetInstancePtr());
 
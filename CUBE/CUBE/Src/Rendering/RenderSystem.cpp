@@ -62,6 +62,7 @@ FRenderSystem::FRenderSystem(Atlas::FWorld& World, sf::Window& GameWindow, FChun
 	, mChunkManager(ChunkManager)
 	, mDeferredRender()
 	, mChunkRender()
+	, mChunkOrigin()
 	, mGBuffer()
 	, mPostProcesses()
 	, mTransformBlock(GLUniformBindings::TransformBlock, TransformBuffer::Size)
@@ -96,10 +97,12 @@ void FRenderSystem::LoadShaders()
 	mDeferredRender.AttachShader(DeferredFrag);
 	mDeferredRender.LinkProgram();
 
-	FShader DeferredChunkVert{ L"Shaders/DeferredChunkRender.vert", GL_VERTEX_SHADER };
+	// Chunk quads are either pulled from a storage buffer or expanded to vertices
+	FShader DeferredChunkVert{ FChunkMesh::UseQuadPulling ? L"Shaders/DeferredChunkQuadRender.vert" : L"Shaders/DeferredChunkRender.vert", GL_VERTEX_SHADER };
 	mChunkRender.AttachShader(DeferredChunkVert);
 	mChunkRender.AttachShader(DeferredFrag);
 	mChunkRender.LinkProgram();
+	mChunkOrigin.Bind(mChunkRender.GetID(), "ChunkOrigin");
 }
 
 void FRenderSystem::LoadSubSystems()
@@ -154,6 +157,11 @@ void FRenderSystem::SetModelTransform(const FTransform& WorldTransform)
 	mTransformBlock.SetData(TransformBuffer::Model, WorldTransform.LocalToWorldMatrix());
 }
 
+void FRenderSystem::SetChunkOrigin(const Vector3i& WorldPosition)
+{
+	mChunkOrigin.SetVector(1, &WorldPosition);
+}
+
 void FRenderSystem::Update()
 {
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
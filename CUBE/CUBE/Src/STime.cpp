@@ -4,6 +4,7 @@ FClock STime::mGameClock;
 uint64_t STime::mFrameStart = 0;
 uint64_t STime::mFrameEnd = 0;
 float STime::mDeltaTime = 1.0f / 30.0f;
+float STime::mFrameTime = 1.0f / 30.0f;
 float STime::mFixedUpdate = 0;
 
 void STime::StartGameTimer()
@@ -34,5 +35,9 @@ void STime::UpdateGameTimer()
 
 	// Set delta time for this frame
 	mDeltaTime = DeltaTime;
+
+	// Breakpoints are left out of the real frame time as well
+	const float FrameSeconds = FClock::CyclesToSeconds(FrameTime);
+	mFrameTime = (FrameSeconds > 1.5f) ? 1.0f / 30.0f : FrameSeconds;
 	mFrameStart = mFrameEnd;
 }
\ No newline at end of file
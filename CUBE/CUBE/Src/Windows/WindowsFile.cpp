@@ -96,6 +96,15 @@ uint32_t FWindowsHandle::GetFileSize() const
 	return ::GetFileSize(mFileHandle, nullptr);
 }
 
+bool FWindowsHandle::Truncate()
+{
+	if (SetEndOfFile(mFileHandle))
+		return true;
+
+	PrintError();
+	return false;
+}
+
 FWindowsHandle::~FWindowsHandle()
 {
 	CloseHandle(mFileHandle);
@@ -0,0 +1,38 @@
+#ifdef _WIN32
+
+#include "Memory\MemoryUtil.h"
+#include <Windows.h>
+
+namespace FMemory
+{
+	void* ReserveVirtual(const size_t Bytes)
+	{
+		return VirtualAlloc(nullptr, Bytes, MEM_RESERVE, PAGE_NOACCESS);
+	}
+
+	bool CommitVirtual(void* Address, const size_t Bytes)
+	{
+		return VirtualAlloc(Address, Bytes, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+	}
+
+	void ReleaseVirtual(void* Address, const size_t Bytes)
+	{
+		// Windows releases the whole reservation, so the size must be 0
+		VirtualFree(Address, 0, MEM_RELEASE);
+	}
+
+	void AdviseHugePages(void* Address, const size_t Bytes)
+	{
+		// Large pages on Windows require a user privilege and must be committed
+		// up front, which defeats committing on demand.
+	}
+
+	size_t GetVirtualPageSize()
+	{
+		SYSTEM_INFO Info;
+		GetSystemInfo(&Info);
+		return Info.dwPageSize;
+	}
+}
+
+#endif